@@ -0,0 +1,54 @@
+#include "common/TimeUtils.h"
+
+static constexpr size_t loop_count = 1000000;
+
+/// Average clock cycles one call of f costs.
+template <typename F>
+void benchmarkClock(const std::string &name, F &&f)
+{
+    Common::Nanos sink = 0;
+    const auto start = Common::rdtscStart();
+    for (size_t i = 0; i < loop_count; ++i)
+    {
+        sink += f();
+    }
+    const auto cycles = Common::rdtscStop() - start;
+
+    std::cout << name << " " << (cycles / loop_count) << " CLOCK CYCLES PER CALL." << (sink == 42 ? " " : "") << std::endl;
+}
+
+/// Cost of the TSC reads and conversions against the system_clock call TTT_MEASURE used to make, then how far CTscClock::Now()
+/// strays from CLOCK_REALTIME while the background thread keeps recalibrating.
+int main(int, char **)
+{
+    const auto &clock = Common::CTscClock::Instance();
+    std::cout << "INVARIANT TSC " << clock.IsInvariant() << ", " << (1.0 / clock.NanosPerTick()) << " GHZ." << std::endl;
+
+    benchmarkClock("RDTSC", []() { return static_cast<Common::Nanos>(Common::rdtsc()); });
+    benchmarkClock("RDTSC START", []() { return static_cast<Common::Nanos>(Common::rdtscStart()); });
+    benchmarkClock("RDTSCP STOP", []() { return static_cast<Common::Nanos>(Common::rdtscStop()); });
+    benchmarkClock("TSC CLOCK NOW", [&clock]() { return clock.Now(); });
+    benchmarkClock("SYSTEM CLOCK", []() { return Common::GetCurrentNanos(); });
+
+    for (int second = 1; second <= 5; ++second)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        // Compare against the midpoint of the narrowest pair of system clock reads, the first ones after the sleep run cold.
+        Common::Nanos bestWidth = INT64_MAX, offset = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            const auto before = Common::GetCurrentNanos();
+            const auto tscNanos = clock.Now();
+            const auto after = Common::GetCurrentNanos();
+            if (after - before < bestWidth)
+            {
+                bestWidth = after - before;
+                offset = tscNanos - (before + (after - before) / 2);
+            }
+        }
+        std::cout << "AFTER " << second << "S TSC CLOCK - SYSTEM CLOCK " << offset << " NANOS." << std::endl;
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,99 @@
+#include <sstream>
+
+#include "matcher/MatchingEngine.h"
+
+static constexpr size_t loop_count = 1000000;
+static constexpr size_t dump_count = 200;
+static constexpr size_t orders_per_level = 40;
+
+/// SMEClientRequest::ToString() as it was written before CFormatBuffer, a std::stringstream per call.
+std::string streamToString(const Exchange::SMEClientRequest &request)
+{
+    const auto checked = [](auto value, auto invalid) { return value == invalid ? std::string("INVALID") : std::to_string(value); };
+
+    std::stringstream ss;
+    ss << "SMEClientRequest"
+       << " ["
+       << "type:"    << Exchange::ClientRequestTypeToString(request.type)
+       << " client:" << checked(request.clientId, Common::ClientId_INVALID)
+       << " ticker:" << checked(request.tickerId, Common::TickerId_INVALID)
+       << " oid:"    << checked(request.orderId, Common::OrderId_INVALID)
+       << " side:"   << Common::SideToString(request.side)
+       << " qty:"    << checked(request.qty, Common::Qty_INVALID)
+       << " price:"  << checked(request.price, Common::Price_INVALID)
+       << "]";
+    return ss.str();
+}
+
+/// Run f count times and report the average clock cycles per call and the rate output was produced at.
+template <typename F>
+void benchmarkFormat(const std::string &name, size_t count, F &&f)
+{
+    size_t bytes = 0;
+    const auto start_nanos = Common::GetCurrentNanos();
+    const auto start = Common::rdtsc();
+    for (size_t i = 0; i < count; ++i)
+    {
+        bytes += f(i);
+    }
+    const auto cycles = Common::rdtsc() - start;
+    const auto elapsed = Common::GetCurrentNanos() - start_nanos;
+
+    std::cout << name << " " << cycles / count << " CLOCK CYCLES PER CALL, "
+              << (bytes / (1024.0 * 1024.0)) / (static_cast<double>(elapsed) / Common::NANOS_TO_SECS) << " MB/S." << std::endl;
+}
+
+int main(int, char **)
+{
+    Common::CLogger logger("format_benchmark.log");
+    Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+    Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+    Exchange::MEMarketUpdateRing market_updates(ME_MAX_MARKET_UPDATES, Exchange::ME_MAX_MARKET_UPDATE_READERS);
+    auto matching_engine = new Exchange::CMatchingEngine(&client_requests, &client_responses, &market_updates);
+
+    {
+        std::vector<Exchange::SMEClientRequest> requests;
+        for (size_t i = 0; i < 1024; ++i)
+        {
+            requests.push_back({Exchange::EClientRequestType::NEW, static_cast<ClientId>(i % 16), static_cast<TickerId>(i % ME_MAX_TICKERS),
+                                1000 + i, (i % 2 ? ESide::BUY : ESide::SELL), static_cast<Price>(100 + i % 50), static_cast<Qty>(1 + i % 100)});
+        }
+
+        benchmarkFormat("STRINGSTREAM TOSTRING", loop_count, [&](size_t i) { return streamToString(requests[i % requests.size()]).size(); });
+        benchmarkFormat("FORMAT TOSTRING", loop_count, [&](size_t i) { return requests[i % requests.size()].ToString().size(); });
+
+        Common::CInlineFormatBuffer<Common::FORMAT_INLINE_SIZE> buffer;
+        benchmarkFormat("FORMAT INTO BUFFER", loop_count, [&](size_t i)
+        {
+            buffer.Clear();
+            buffer << requests[i % requests.size()];
+            return buffer.size();
+        });
+    }
+
+    {
+        // Every price level populated, the bids below the asks so nothing matches.
+        auto order_book = new Exchange::CMEOrderBook(0, &logger, matching_engine);
+        Common::OrderId order_id = 1000;
+        for (size_t level = 0; level < ME_MAX_PRICE_LEVELS; ++level)
+        {
+            const auto side = (level < ME_MAX_PRICE_LEVELS / 2 ? ESide::BUY : ESide::SELL);
+            for (size_t i = 0; i < orders_per_level; ++i)
+            {
+                order_book->AddOrder(0, order_id++, 0, side, static_cast<Price>(1000 + level), static_cast<Qty>(1 + i));
+            }
+        }
+
+        std::string dump(order_book->ToString(true, true).size(), '\0');
+        Common::CFormatBuffer buffer(dump.data(), dump.size());
+        benchmarkFormat("BOOK DUMP TOSTRING", dump_count, [&](size_t) { return order_book->ToString(true, true).size(); });
+        benchmarkFormat("BOOK DUMP INTO BUFFER", dump_count, [&](size_t)
+        {
+            buffer.Clear();
+            order_book->Format(buffer, true, true);
+            return buffer.size();
+        });
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -45,7 +45,7 @@ int main(int, char **)
     Common::CLogger logger("hash_benchmark.log");
     Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
     Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
-    Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+    Exchange::MEMarketUpdateRing market_updates(ME_MAX_MARKET_UPDATES, Exchange::ME_MAX_MARKET_UPDATE_READERS);
     auto matching_engine = new Exchange::CMatchingEngine(&client_requests, &client_responses, &market_updates);
 
     Common::OrderId order_id = 1000;
@@ -0,0 +1,65 @@
+#include <filesystem>
+
+#include "common/Logging.h"
+
+static constexpr size_t loop_count = 2000000;
+
+/// Total size of fileName and of every file it was rotated to.
+size_t logFileBytes(const std::string &fileName)
+{
+    size_t bytes = 0;
+    for (size_t i = 0; std::filesystem::exists(i ? fileName + "." + std::to_string(i) : fileName); ++i)
+    {
+        bytes += std::filesystem::file_size(i ? fileName + "." + std::to_string(i) : fileName);
+    }
+
+    return bytes;
+}
+
+auto removeLogFiles(const std::string &fileName)
+{
+    std::filesystem::remove(fileName);
+    for (size_t i = 1; std::filesystem::remove(fileName + "." + std::to_string(i)); ++i);
+}
+
+/// Flood the logger with typical order book lines as fast as the producer can push them, wait for the CLogService thread to drain the queue,
+/// and report the sustained rate the records reached the file at and the deepest the queue got.
+template <typename T>
+void benchmarkThroughput(const std::string &name, const std::string &fileName)
+{
+    // The writer appends to what is already there, start from an empty file so the byte count is this run's alone.
+    removeLogFiles(fileName);
+
+    Common::Nanos elapsed = 0;
+    size_t highWaterMark = 0;
+    {
+        T logger(fileName);
+
+        const auto start = Common::GetCurrentNanos();
+        for (size_t i = 0; i < loop_count; ++i)
+        {
+            logger.Log(LOG_FORMAT("order id:% ticker:% side:% price:% qty:% priority:% client:%\n"),
+                       static_cast<long>(i), 3, 'B', 100.25 + static_cast<double>(i % 7), 10, static_cast<long>(i), "CLIENT_ONE");
+        }
+        while (logger.QueueStats().size)
+        {
+            using namespace std::literals::chrono_literals;
+            std::this_thread::sleep_for(100us);
+        }
+        elapsed = Common::GetCurrentNanos() - start;
+        highWaterMark = logger.QueueStats().highWaterMark;
+    }
+
+    const auto bytes = logFileBytes(fileName);
+    std::cout << name << " " << (bytes / (1024.0 * 1024.0)) / (static_cast<double>(elapsed) / Common::NANOS_TO_SECS) << " MB/S SUSTAINED, "
+              << bytes << " BYTES IN " << elapsed / Common::NANOS_TO_MILLIS << " MS, MAX QUEUE DEPTH " << highWaterMark << " BYTES." << std::endl;
+
+    removeLogFiles(fileName);
+}
+
+int main(int, char **)
+{
+    benchmarkThroughput<Common::CLogger>("LOGGER", "log_writer_benchmark.log");
+
+    exit(EXIT_SUCCESS);
+}
@@ -1,5 +1,151 @@
+#include <algorithm>
+
 #include "common/Logging.h"
-#include "common/OptLogging.h"
+
+/// Common::CLogger as it was before binary records, kept as the baseline: Log() walks the format at runtime, recursing once per argument,
+/// and pushes one queue element per character. Argument count mismatches are only caught when the line executes.
+class CPerElementLogger final
+{
+    struct SLogElement
+    {
+        bool isLong = false;
+        union
+        {
+            char c;
+            long l;
+        } u_;
+    };
+
+public:
+    explicit CPerElementLogger(const std::string &fileName) : m_queue(Common::LOG_QUEUE_SIZE)
+    {
+        m_file.open(fileName);
+        ASSERT(m_file.is_open(), "Could not open log file:" + fileName);
+
+        m_pLoggerThread = Common::CreateAndStartThread(-1, "CPerElementLogger " + fileName, [this]() { FlushQueue(); });
+        ASSERT(m_pLoggerThread != nullptr, "Failed to start CPerElementLogger thread.");
+    }
+
+    ~CPerElementLogger()
+    {
+        while (m_queue.size())
+        {
+            using namespace std::literals::chrono_literals;
+            std::this_thread::sleep_for(1s);
+        }
+        m_isRrunning = false;
+        m_pLoggerThread->join();
+        delete m_pLoggerThread;
+    }
+
+    auto PushValue(const SLogElement &logElement) noexcept
+    {
+        *(m_queue.GetNextToWriteTo()) = logElement;
+        m_queue.UpdateWriteIndex();
+    }
+
+    auto PushValue(const char value) noexcept
+    {
+        PushValue(SLogElement{false, {.c = value}});
+    }
+
+    auto PushValue(const long value) noexcept
+    {
+        PushValue(SLogElement{true, {.l = value}});
+    }
+
+    auto PushValue(const int value) noexcept
+    {
+        PushValue(static_cast<long>(value));
+    }
+
+    auto PushValue(const std::string &value) noexcept
+    {
+        for (const auto c : value)
+        {
+            PushValue(c);
+        }
+    }
+
+    template <typename T, typename... A>
+    auto Log(const char *szBuffer, const T &value, A... args) noexcept
+    {
+        while (*szBuffer)
+        {
+            if (*szBuffer == '%')
+            {
+                if (UNLIKELY(*(szBuffer + 1) == '%'))
+                { // to allow %% -> % escape character.
+                    ++szBuffer;
+                }
+                else
+                {
+                    PushValue(value);
+                    Log(szBuffer + 1, args...);
+                    return;
+                }
+            }
+            PushValue(*szBuffer++);
+        }
+        FATAL("extra arguments provided to log()");
+    }
+
+    auto Log(const char *szBuffer) noexcept
+    {
+        while (*szBuffer)
+        {
+            if (*szBuffer == '%')
+            {
+                if (UNLIKELY(*(szBuffer + 1) == '%'))
+                { // to allow %% -> % escape character.
+                    ++szBuffer;
+                }
+                else
+                {
+                    FATAL("missing arguments to log()");
+                }
+            }
+            PushValue(*szBuffer++);
+        }
+    }
+
+    /// Same call sites as Common::CLogger, the baseline ignores the pre-split chunks and walks the format itself.
+    template <typename... A>
+    auto Log(const Common::SLogFormatInfo &format, const A &...args) noexcept
+    {
+        Log(format.format, args...);
+    }
+
+private:
+    auto FlushQueue() noexcept -> void
+    {
+        while (m_isRrunning)
+        {
+            const auto elements = m_queue.PeekRead(Common::LOG_QUEUE_SIZE);
+            for (size_t i = 0; i < elements.size(); ++i)
+            {
+                if (elements[i].isLong)
+                {
+                    m_file << elements[i].u_.l;
+                }
+                else
+                {
+                    m_file << elements[i].u_.c;
+                }
+            }
+            m_queue.ReleaseRead(elements.size());
+            m_file.flush();
+
+            using namespace std::literals::chrono_literals;
+            std::this_thread::sleep_for(10ms);
+        }
+    }
+
+    std::ofstream                             m_file;
+    OptCommon::COptLockFreeQueue<SLogElement> m_queue;
+    std::atomic<bool>                         m_isRrunning = {true};
+    std::thread                              *m_pLoggerThread = nullptr;
+};
 
 std::string random_string(size_t length)
 {
@@ -17,6 +163,7 @@ std::string random_string(size_t length)
     return str;
 }
 
+/// One 128 character string argument per line.
 template <typename T>
 size_t benchmarkLogging(T *logger)
 {
@@ -26,7 +173,23 @@ size_t benchmarkLogging(T *logger)
     {
         const auto s = random_string(128);
         const auto start = Common::rdtsc();
-        logger->Log("%\n", s);
+        logger->Log(LOG_FORMAT("%\n"), s);
+        total_rdtsc += (Common::rdtsc() - start);
+    }
+
+    return (total_rdtsc / loop_count);
+}
+
+/// A typical order book line, a few literal chunks and numeric arguments.
+template <typename T>
+size_t benchmarkNumericLogging(T *logger)
+{
+    constexpr size_t loop_count = 100000;
+    size_t total_rdtsc = 0;
+    for (size_t i = 0; i < loop_count; ++i)
+    {
+        const auto start = Common::rdtsc();
+        logger->Log(LOG_FORMAT("order id:% ticker:% side:% price:% qty:% priority:%\n"), static_cast<long>(i), 3, 'B', 100 + static_cast<long>(i % 7), 10, static_cast<long>(i));
         total_rdtsc += (Common::rdtsc() - start);
     }
 
@@ -38,16 +201,20 @@ int main(int, char **)
     using namespace std::literals::chrono_literals;
 
     {
-        Common::CLogger logger("logger_benchmark_original.log");
+        CPerElementLogger logger("logger_benchmark_per_element.log");
         const auto cycles = benchmarkLogging(&logger);
-        std::cout << "ORIGINAL LOGGER " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        std::cout << "PER-ELEMENT LOGGER " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        const auto numericCycles = benchmarkNumericLogging(&logger);
+        std::cout << "PER-ELEMENT LOGGER NUMERIC " << numericCycles << " CLOCK CYCLES PER OPERATION." << std::endl;
         std::this_thread::sleep_for(10s);
     }
 
     {
-        OptCommon::COptLogger opt_logger("logger_benchmark_optimized.log");
-        const auto cycles = benchmarkLogging(&opt_logger);
+        Common::CLogger logger("logger_benchmark_optimized.log");
+        const auto cycles = benchmarkLogging(&logger);
         std::cout << "OPTIMIZED LOGGER " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        const auto numericCycles = benchmarkNumericLogging(&logger);
+        std::cout << "OPTIMIZED LOGGER NUMERIC " << numericCycles << " CLOCK CYCLES PER OPERATION." << std::endl;
         std::this_thread::sleep_for(10s);
     }
 
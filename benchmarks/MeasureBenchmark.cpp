@@ -0,0 +1,38 @@
+#include "common/Logging.h"
+
+static constexpr size_t loop_count = 1000000;
+
+/// Average clock cycles one START_MEASURE() / END_MEASURE() pair costs the measured thread, recording into a histogram,
+/// against logging every sample like END_MEASURE() used to.
+int main(int, char **)
+{
+    {
+        size_t total_rdtsc = 0;
+        for (size_t i = 0; i < loop_count; ++i)
+        {
+            const auto start = Common::rdtsc();
+            START_MEASURE(Benchmark_histogram);
+            END_MEASURE(Benchmark_histogram);
+            total_rdtsc += (Common::rdtsc() - start);
+        }
+        std::cout << "HISTOGRAM " << (total_rdtsc / loop_count) << " CLOCK CYCLES PER MEASUREMENT." << std::endl;
+    }
+
+    {
+        Common::CLogger logger("measure_benchmark.log");
+        logger.SetLevel(Common::ELogLevel::DEBUG);
+
+        size_t total_rdtsc = 0;
+        for (size_t i = 0; i < loop_count; ++i)
+        {
+            const auto start = Common::rdtsc();
+            START_MEASURE(Benchmark_log);
+            LOG_DEBUG(logger, "RDTSC Benchmark_log %\n", (Common::rdtsc() - Benchmark_log));
+            total_rdtsc += (Common::rdtsc() - start);
+        }
+        std::cout << "LOG LINE " << (total_rdtsc / loop_count) << " CLOCK CYCLES PER MEASUREMENT." << std::endl;
+    }
+
+    std::remove("measure_benchmark.log");
+    exit(EXIT_SUCCESS);
+}
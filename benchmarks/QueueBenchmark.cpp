@@ -0,0 +1,72 @@
+#include "common/LockFreeQueue.h"
+#include "common/OptLockFreeQueue.h"
+#include "common/PerfUtils.h"
+#include "common/ThreadUtils.h"
+
+static constexpr size_t loop_count = 1000000;
+
+/// Bounce a counter between two threads over a pair of queues and return the average round trip in clock cycles.
+/// The calling thread sends on ping and waits on pong, a second thread pinned to pong_core echoes every message back.
+template <typename T>
+size_t benchmarkPingPong(int ping_core, int pong_core)
+{
+    T ping(1024), pong(1024);
+
+    auto pong_thread = Common::CreateAndStartThread(pong_core, "QueueBenchmark/Pong", [&]()
+    {
+        for (size_t i = 0; i < loop_count; ++i)
+        {
+            const size_t *request = nullptr;
+            while (!(request = ping.GetNextToRead()));
+            const auto value = *request;
+            ping.UpdateReadIndex();
+
+            *(pong.GetNextToWriteTo()) = value;
+            pong.UpdateWriteIndex();
+        }
+    });
+    ASSERT(pong_thread != nullptr, "Failed to start QueueBenchmark/Pong thread.");
+
+    size_t total_rdtsc = 0;
+    for (size_t i = 0; i < loop_count; ++i)
+    {
+        const auto start = Common::rdtsc();
+        *(ping.GetNextToWriteTo()) = i;
+        ping.UpdateWriteIndex();
+
+        const size_t *response = nullptr;
+        while (!(response = pong.GetNextToRead()));
+        ASSERT(*response == i, "Received out of order response.");
+        pong.UpdateReadIndex();
+        total_rdtsc += (Common::rdtsc() - start);
+    }
+
+    pong_thread->join();
+    delete pong_thread;
+
+    return (total_rdtsc / loop_count);
+}
+
+/// ./queue_benchmark [PING_CORE PONG_CORE] - pass two different physical cores to measure the cross-core cost, -1 leaves a thread unpinned.
+int main(int argc, char **argv)
+{
+    const int ping_core = (argc > 2 ? atoi(argv[1]) : -1);
+    const int pong_core = (argc > 2 ? atoi(argv[2]) : -1);
+
+    if (ping_core >= 0)
+    {
+        ASSERT(Common::setThreadCore(ping_core), "Failed to set core affinity for ping thread to " + std::to_string(ping_core));
+    }
+
+    {
+        const auto cycles = benchmarkPingPong<Common::CLockFreeQueue<size_t>>(ping_core, pong_core);
+        std::cout << "ORIGINAL LFQUEUE " << cycles << " CLOCK CYCLES PER ROUND TRIP." << std::endl;
+    }
+
+    {
+        const auto cycles = benchmarkPingPong<OptCommon::COptLockFreeQueue<size_t>>(ping_core, pong_core);
+        std::cout << "OPTIMIZED LFQUEUE " << cycles << " CLOCK CYCLES PER ROUND TRIP." << std::endl;
+    }
+
+    exit(EXIT_SUCCESS);
+}
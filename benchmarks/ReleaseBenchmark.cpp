@@ -1,9 +1,59 @@
+#include <random>
+
 #include "common/MemoryPool.h"
 #include "common/OptMemoryPool.h"
 #include "common/PerfUtils.h"
 
 #include "exchange/market_data/MarketUpdate.h"
 
+/// Common::CMemoryPool as it was before the free list, kept as the baseline: Allocate() walks the store for the next free block.
+template <typename T>
+class CLinearScanMemPool final
+{
+public:
+    explicit CLinearScanMemPool(std::size_t numElems) : m_store(numElems, {T(), true})
+    {
+    }
+
+    template <typename... Args>
+    T *Allocate(Args... args) noexcept
+    {
+        auto obj_block = &(m_store[m_nextFreeIndex]);
+        ASSERT(obj_block->isFree, "Expected free SObjectBlock at index:" + std::to_string(m_nextFreeIndex));
+        T *ret = new (&(obj_block->object)) T(args...);
+        obj_block->isFree = false;
+
+        const auto initial_free_index = m_nextFreeIndex;
+        while (!m_store[m_nextFreeIndex].isFree)
+        {
+            m_nextFreeIndex = (m_nextFreeIndex + 1 == m_store.size() ? 0 : m_nextFreeIndex + 1);
+            ASSERT(initial_free_index != m_nextFreeIndex, "Memory Pool out of space.");
+        }
+
+        return ret;
+    }
+
+    auto Deallocate(const T *elem) noexcept
+    {
+        const auto elem_index = (reinterpret_cast<const SObjectBlock *>(elem) - &m_store[0]);
+        ASSERT(elem_index >= 0 && static_cast<size_t>(elem_index) < m_store.size(), "Element being deallocated does not belong to this Memory pool.");
+        ASSERT(!m_store[elem_index].isFree, "Expected in-use SObjectBlock at index:" + std::to_string(elem_index));
+
+        m_store[elem_index].isFree = true;
+    }
+
+private:
+    struct SObjectBlock
+    {
+        T object;
+        bool isFree = true;
+    };
+
+    std::vector<SObjectBlock> m_store;
+    size_t m_nextFreeIndex = 0;
+};
+
+/// Allocate 256 objects then free all of them, over and over - the pool is never fragmented.
 template <typename T>
 size_t benchmarkMemPool(T *mem_pool)
 {
@@ -30,18 +80,80 @@ size_t benchmarkMemPool(T *mem_pool)
     return (total_rdtsc / (loop_count * allocated_objs.size()));
 }
 
+/// Fill the pool to fill_percent, then free a random live object and allocate a new one, like orders being cancelled and added across a deep book.
+/// Free blocks end up scattered across the whole store, which is what makes the linear scan expensive.
+template <typename T>
+size_t benchmarkFragmentedMemPool(T *mem_pool, size_t pool_size, size_t fill_percent)
+{
+    constexpr size_t loop_count = 1000000;
+    size_t total_rdtsc = 0;
+    std::mt19937_64 rng(0);
+
+    std::vector<Exchange::MDPMarketUpdate *> live_objs;
+    live_objs.reserve(pool_size);
+    while (live_objs.size() < pool_size * fill_percent / 100)
+    {
+        live_objs.push_back(mem_pool->Allocate());
+    }
+
+    for (size_t i = 0; i < loop_count; ++i)
+    {
+        auto &victim = live_objs[rng() % live_objs.size()];
+
+        const auto start = Common::rdtsc();
+        mem_pool->Deallocate(victim);
+        victim = mem_pool->Allocate();
+        total_rdtsc += (Common::rdtsc() - start);
+    }
+
+    for (auto obj : live_objs)
+    {
+        mem_pool->Deallocate(obj);
+    }
+
+    return (total_rdtsc / (loop_count * 2));
+}
+
 int main(int, char **)
 {
+    {
+        CLinearScanMemPool<Exchange::MDPMarketUpdate> mem_pool(512);
+        const auto cycles = benchmarkMemPool(&mem_pool);
+        std::cout << "ORIGINAL LINEAR-SCAN MEMPOOL " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+    }
+
     {
         Common::CMemoryPool<Exchange::MDPMarketUpdate> mem_pool(512);
         const auto cycles = benchmarkMemPool(&mem_pool);
-        std::cout << "ORIGINAL MEMPOOL " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        std::cout << "FREE-LIST MEMPOOL " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
     }
 
     {
         OptCommon::COptMemPool<Exchange::MDPMarketUpdate> opt_mem_pool(512);
         const auto cycles = benchmarkMemPool(&opt_mem_pool);
-        std::cout << "OPTIMIZED MEMPOOL " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        std::cout << "OPTIMIZED FREE-LIST MEMPOOL " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+    }
+
+    constexpr size_t fragmented_pool_size = 64 * 1024;
+    for (const size_t fill_percent : {50, 90, 99})
+    {
+        {
+            CLinearScanMemPool<Exchange::MDPMarketUpdate> mem_pool(fragmented_pool_size);
+            const auto cycles = benchmarkFragmentedMemPool(&mem_pool, fragmented_pool_size, fill_percent);
+            std::cout << "ORIGINAL LINEAR-SCAN MEMPOOL " << fill_percent << "% FULL FRAGMENTED " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        }
+
+        {
+            Common::CMemoryPool<Exchange::MDPMarketUpdate> mem_pool(fragmented_pool_size);
+            const auto cycles = benchmarkFragmentedMemPool(&mem_pool, fragmented_pool_size, fill_percent);
+            std::cout << "FREE-LIST MEMPOOL " << fill_percent << "% FULL FRAGMENTED " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        }
+
+        {
+            OptCommon::COptMemPool<Exchange::MDPMarketUpdate> opt_mem_pool(fragmented_pool_size);
+            const auto cycles = benchmarkFragmentedMemPool(&opt_mem_pool, fragmented_pool_size, fill_percent);
+            std::cout << "OPTIMIZED FREE-LIST MEMPOOL " << fill_percent << "% FULL FRAGMENTED " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+        }
     }
 
     exit(EXIT_SUCCESS);
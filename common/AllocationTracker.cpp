@@ -0,0 +1,117 @@
+#include "AllocationTracker.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <execinfo.h>
+#include <malloc.h>
+#include <unistd.h>
+
+namespace Common
+{
+    auto CAllocationTracker::MarkAllocationFree(const char *name) noexcept -> void
+    {
+        auto &state = ThisThread();
+        state.name = name;
+        // Leaked on purpose, the hooks may still count through it while the thread and the process wind down.
+        state.pCounter = new CMetricCounter(CMetricsRegistry::Instance().Counter(std::string(name) + ":hot_allocations"));
+
+        // The first backtrace() loads libgcc's unwinder, which allocates. Have it happen now rather than in the first report.
+        void *frames[1];
+        backtrace(frames, 1);
+
+        state.isAllocationFree = true;
+        static constexpr const char *policyNames[] = {"COUNT", "LOG", "ABORT"};
+        std::cerr << "CAllocationTracker " << name << " is allocation-free from now on, policy:" << policyNames[static_cast<size_t>(ALLOCATION_TRACKER_POLICY_VALUE)]
+                  << std::endl;
+    }
+
+    auto CAllocationTracker::Report(size_t size) noexcept -> void
+    {
+        auto &state = ThisThread();
+        state.isReporting = true;
+
+        state.pCounter->Increment();
+
+        if (ALLOCATION_TRACKER_POLICY_VALUE != EAllocationPolicy::COUNT &&
+            (ALLOCATION_TRACKER_POLICY_VALUE == EAllocationPolicy::ABORT || state.numLogged < ALLOCATION_TRACKER_MAX_LOGGED))
+        {
+            ++state.numLogged;
+
+            // Straight to the file descriptor, the loggers run on other threads and this one may be about to abort.
+            char line[160];
+            const auto length = snprintf(line, sizeof(line), "CAllocationTracker %s allocated %zu bytes on an allocation-free thread, backtrace:\n", state.name, size);
+            (void)!write(STDERR_FILENO, line, std::min(static_cast<size_t>(std::max(length, 0)), sizeof(line) - 1));
+
+            void *frames[ALLOCATION_TRACKER_MAX_FRAMES];
+            backtrace_symbols_fd(frames, backtrace(frames, ALLOCATION_TRACKER_MAX_FRAMES), STDERR_FILENO);
+        }
+
+        if (ALLOCATION_TRACKER_POLICY_VALUE == EAllocationPolicy::ABORT)
+        {
+            abort();
+        }
+
+        state.isReporting = false;
+    }
+}
+
+#if defined(ENABLE_ALLOCATION_TRACKER)
+
+/// glibc's allocator under its internal names, what the interposed functions below forward to.
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *p, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+}
+
+/// Defined in the executable, these take precedence over glibc's for the whole process, shared libraries included.
+/// free() is left alone, releasing memory does not stall the way a trip into the allocator for more can.
+extern "C"
+{
+    void *malloc(size_t size) noexcept
+    {
+        Common::CAllocationTracker::OnAllocation(size);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size) noexcept
+    {
+        Common::CAllocationTracker::OnAllocation(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *p, size_t size) noexcept
+    {
+        Common::CAllocationTracker::OnAllocation(size);
+        return __libc_realloc(p, size);
+    }
+
+    void *memalign(size_t alignment, size_t size) noexcept
+    {
+        Common::CAllocationTracker::OnAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        Common::CAllocationTracker::OnAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **pp, size_t alignment, size_t size) noexcept
+    {
+        Common::CAllocationTracker::OnAllocation(size);
+        if (alignment % sizeof(void *) || (alignment & (alignment - 1)))
+        {
+            return EINVAL;
+        }
+
+        *pp = __libc_memalign(alignment, size);
+        return *pp ? 0 : ENOMEM;
+    }
+}
+
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Macros.h"
+#include "Metrics.h"
+
+/// What an allocation on an allocation-free thread does, set at build time with -DALLOCATION_TRACKER_POLICY=COUNT|LOG|ABORT.
+#if !defined(ALLOCATION_TRACKER_POLICY)
+#define ALLOCATION_TRACKER_POLICY LOG
+#endif
+
+namespace Common
+{
+    enum class EAllocationPolicy : uint8_t
+    {
+        COUNT = 0, /// Count it in the thread's <name>:hot_allocations counter, stats_reader shows it.
+        LOG = 1,   /// Count it and print its size and backtrace to stderr, the first ALLOCATION_TRACKER_MAX_LOGGED per thread.
+        ABORT = 2  /// Print it and abort(), the flight recorders are dumped on the way out.
+    };
+
+    constexpr auto ALLOCATION_TRACKER_POLICY_VALUE = EAllocationPolicy::ALLOCATION_TRACKER_POLICY;
+
+    /// Busy passes of its run loop a thread makes before it is held to allocating nothing: the first messages allocate the thread's
+    /// histograms, flight recorder ring and other state created on first use.
+    constexpr uint32_t ALLOCATION_TRACKER_WARMUP_PASSES = 1000;
+
+    /// Allocations with a backtrace printed per thread under LOG, later ones are only counted so a leaky loop does not flood stderr.
+    constexpr uint32_t ALLOCATION_TRACKER_MAX_LOGGED = 32;
+
+    constexpr size_t ALLOCATION_TRACKER_MAX_FRAMES = 32;
+
+    /// The calling thread's tracking state, trivially constructible so the allocation hooks can reach it without a TLS guard.
+    struct SAllocationThreadState
+    {
+        const char     *name = nullptr;
+        CMetricCounter *pCounter = nullptr;
+        uint32_t        warmupPasses = 0;
+        uint32_t        numLogged = 0;
+        bool            isAllocationFree = false;
+
+        /// Set while an allocation is being reported, the report's own allocations go through unchecked.
+        bool isReporting = false;
+    };
+
+    /// Finds hidden heap allocations on the critical threads: std::string temporaries, container growth, anything that reaches malloc().
+    ///
+    /// Opt-in, built with -DENABLE_ALLOCATION_TRACKER=ON. malloc() and its siblings are then interposed by AllocationTracker.cpp, operator new
+    /// included since libstdc++ allocates through malloc(). A thread calls ALLOCATION_FREE_AFTER_WARMUP() from its run loop: once warmed up,
+    /// every allocation it makes is counted, logged with a backtrace or aborts, per ALLOCATION_TRACKER_POLICY. Threads that never call it, and
+    /// warming up threads, allocate as usual through a check of one thread local flag.
+    class CAllocationTracker final
+    {
+    public:
+        static auto ThisThread() noexcept -> SAllocationThreadState &
+        {
+            static thread_local SAllocationThreadState state;
+            return state;
+        }
+
+        /// Count a pass of the calling thread's run loop, after ALLOCATION_TRACKER_WARMUP_PASSES busy ones it becomes allocation-free.
+        static auto OnPoll(const char *name, bool didWork) noexcept
+        {
+            auto &state = ThisThread();
+            if (UNLIKELY(!state.isAllocationFree && didWork && ++state.warmupPasses >= ALLOCATION_TRACKER_WARMUP_PASSES))
+            {
+                MarkAllocationFree(name);
+            }
+        }
+
+        /// Hold the calling thread to allocating nothing from now on, name is a string literal the reports and counter are named after.
+        static auto MarkAllocationFree(const char *name) noexcept -> void;
+
+        /// Called by the interposed allocation functions on every allocation, the cost of the tracker on a thread that is not checked.
+        static auto OnAllocation(size_t size) noexcept
+        {
+            auto &state = ThisThread();
+            if (UNLIKELY(state.isAllocationFree && !state.isReporting))
+            {
+                Report(size);
+            }
+        }
+
+        /// Deleted default, copy & move constructors and assignment-operators.
+        CAllocationTracker() = delete;
+
+        CAllocationTracker(const CAllocationTracker &) = delete;
+
+        CAllocationTracker(const CAllocationTracker &&) = delete;
+
+        CAllocationTracker &operator=(const CAllocationTracker &) = delete;
+
+        CAllocationTracker &operator=(const CAllocationTracker &&) = delete;
+
+    private:
+        static auto Report(size_t size) noexcept -> void;
+    };
+}
+
+/// Called from a critical thread's run loop with whether the pass did any work, makes the thread allocation-free once it warmed up.
+#if defined(ENABLE_ALLOCATION_TRACKER)
+#define ALLOCATION_FREE_AFTER_WARMUP(NAME, DID_WORK) Common::CAllocationTracker::OnPoll((NAME), (DID_WORK))
+#else
+#define ALLOCATION_FREE_AFTER_WARMUP(NAME, DID_WORK) do { (void)sizeof(DID_WORK); } while (false)
+#endif
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "HugePages.h"
+#include "Macros.h"
+#include "RingSlots.h"
+#include "QueueStats.h"
+#include "WaitStrategy.h"
+
+namespace OptCommon
+{
+    /// Single producer / multi consumer sequence ring (disruptor style).
+    /// Every element is written once and read in place by every registered consumer, each of which owns its own read cursor,
+    /// so fanning out to N consumers needs no relay thread and no copies.
+    /// The producer never overwrites a slot until the slowest consumer has released it, a full ring is handled according to the EQueueFullPolicy.
+    /// It caches the slowest read cursor and only scans the readers' cursor lines when that cached value says the ring is full,
+    /// and once every QUEUE_STATS_SAMPLE_INTERVAL elements written to sample the occupancy.
+    ///
+    /// Consumers must be registered with AddReader() before the producer starts writing, a reader only sees elements
+    /// written after it was registered.
+    template <typename T>
+    class CBroadcastRing final
+    {
+    public:
+        /// A run of consecutive slots in the ring, split in two spans when it wraps around the end of the buffer.
+        template <typename U>
+        using SSlots = OptCommon::SSlots<U>;
+
+        /// Consumer side handle, owned by the consuming thread.
+        /// Same read API as COptLockFreeQueue so consumer loops do not care whether they read from a queue or a ring.
+        class CReader final
+        {
+        public:
+            auto GetNextToRead() const noexcept -> const T *
+            {
+                const auto readSeq = m_cursor.readSeq.load(std::memory_order_relaxed);
+                if (readSeq == m_cursor.cachedWriteSeq)
+                {
+                    m_cursor.cachedWriteSeq = m_pRing->m_producer.writeSeq.load(std::memory_order_acquire);
+                    if (readSeq == m_cursor.cachedWriteSeq)
+                    {
+                        return nullptr;
+                    }
+                }
+
+                return &m_pRing->m_store[readSeq & m_pRing->m_mask];
+            }
+
+            auto UpdateReadIndex() noexcept
+            {
+                const auto readSeq = m_cursor.readSeq.load(std::memory_order_relaxed);
+                DEBUG_ASSERT(readSeq != m_cursor.cachedWriteSeq, "Read an invalid element in:" + std::to_string(pthread_self()));
+                m_cursor.readSeq.store(readSeq + 1, std::memory_order_release);
+            }
+
+            /// Return up to maxCount elements that are ready to be read, without releasing them to the producer.
+            auto PeekRead(size_t maxCount) const noexcept -> SSlots<const T>
+            {
+                const auto readSeq = m_cursor.readSeq.load(std::memory_order_relaxed);
+                if (readSeq + maxCount > m_cursor.cachedWriteSeq)
+                {
+                    m_cursor.cachedWriteSeq = m_pRing->m_producer.writeSeq.load(std::memory_order_acquire);
+                }
+
+                return m_pRing->Slice(static_cast<const T *>(m_pRing->m_store.data()), readSeq, std::min(maxCount, m_cursor.cachedWriteSeq - readSeq));
+            }
+
+            /// Release the first count elements returned by PeekRead() with a single cursor update.
+            auto ReleaseRead(size_t count) noexcept
+            {
+                const auto readSeq = m_cursor.readSeq.load(std::memory_order_relaxed);
+                DEBUG_ASSERT(readSeq + count <= m_cursor.cachedWriteSeq, "Released more elements than were read in:" + std::to_string(pthread_self()));
+                m_cursor.readSeq.store(readSeq + count, std::memory_order_release);
+            }
+
+            /// Ring sequence number of the element GetNextToRead() / PeekRead() returns first, counts every element ever written to the ring.
+            auto ReadSequence() const noexcept
+            {
+                return m_cursor.readSeq.load(std::memory_order_relaxed);
+            }
+
+            auto size() const noexcept
+            {
+                const auto readSeq = m_cursor.readSeq.load(std::memory_order_acquire);
+                return m_pRing->m_producer.writeSeq.load(std::memory_order_acquire) - readSeq;
+            }
+
+        private:
+            friend class CBroadcastRing;
+
+            /// Read cursor on its own cache line, written only by the owning consumer and read by the producer when it looks full.
+            struct alignas(CACHE_LINE_SIZE) SCursor
+            {
+                std::atomic<size_t> readSeq = {0};
+                mutable size_t cachedWriteSeq = 0;
+            };
+
+            CReader(CBroadcastRing *pRing, SCursor &cursor) : m_pRing(pRing), m_cursor(cursor)
+            {
+            }
+
+            CBroadcastRing *m_pRing = nullptr;
+            SCursor        &m_cursor;
+        };
+
+        /// An empty name keeps the ring out of CQueueStatsRegistry.
+        CBroadcastRing(std::size_t numElements, std::size_t maxReaders, const std::string &name = "", EQueueFullPolicy fullPolicy = EQueueFullPolicy::SPIN)
+            : m_store(std::bit_ceil(numElements), T(), Common::CHugePageAllocator<T>("OptCommon::CBroadcastRing")) /* pre-allocation of pre-faulted, huge page backed storage. */
+            , m_mask(m_store.size() - 1)
+            , m_name(name)
+            , m_fullPolicy(fullPolicy)
+            , m_cursors(maxReaders)
+        {
+            m_readers.reserve(maxReaders);
+            m_producer.readerWaitStrategies.reserve(maxReaders);
+
+            if (!m_name.empty())
+            {
+                CQueueStatsRegistry::Instance().Register(this, [this]() { return Stats(); });
+            }
+        }
+
+        ~CBroadcastRing()
+        {
+            if (!m_name.empty())
+            {
+                CQueueStatsRegistry::Instance().Unregister(this);
+            }
+        }
+
+        /// Register a new consumer, it starts reading at the element the producer writes next.
+        /// The returned reader lives as long as the ring. pWaitStrategy, the consumer thread's, is unparked after every publish,
+        /// so a consumer with EWaitStrategy::PARK only sleeps while it has nothing to read.
+        auto AddReader(Common::CWaitStrategy *pWaitStrategy = nullptr) noexcept -> CReader *
+        {
+            const auto numReaders = m_numReaders.load(std::memory_order_relaxed);
+            ASSERT(numReaders < m_cursors.size(), "CBroadcastRing out of reader cursors, max:" + std::to_string(m_cursors.size()));
+
+            auto &cursor = m_cursors[numReaders];
+            const auto writeSeq = m_producer.writeSeq.load(std::memory_order_acquire);
+            cursor.readSeq.store(writeSeq, std::memory_order_relaxed);
+            cursor.cachedWriteSeq = writeSeq;
+            m_readers.push_back(CReader(this, cursor));
+            if (pWaitStrategy)
+            {
+                m_producer.readerWaitStrategies.push_back(pWaitStrategy);
+            }
+
+            m_numReaders.store(numReaders + 1, std::memory_order_release);
+
+            return &m_readers.back();
+        }
+
+        /// Never overwrites a slot the slowest reader still has to read, a full ring is handled according to the EQueueFullPolicy.
+        /// With EQueueFullPolicy::DROP the returned slot is a scratch element and the following UpdateWriteIndex() discards it.
+        auto GetNextToWriteTo() noexcept
+        {
+            const auto writeSeq = m_producer.writeSeq.load(std::memory_order_relaxed);
+            m_producer.isDropping = !WaitForSpace(writeSeq, 1);
+            if (UNLIKELY(m_producer.isDropping))
+            {
+                return &m_producer.dropSlot;
+            }
+
+            return &m_store[writeSeq & m_mask];
+        }
+
+        auto UpdateWriteIndex() noexcept
+        {
+            if (UNLIKELY(m_producer.isDropping))
+            {
+                m_producer.dropCount.store(m_producer.dropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+
+            const auto writeSeq = m_producer.writeSeq.load(std::memory_order_relaxed);
+            m_producer.writeSeq.store(writeSeq + 1, std::memory_order_release);
+            WakeReaders();
+            SampleOccupancyEvery(writeSeq, writeSeq + 1);
+        }
+
+        /// Reserve min(count, capacity()) slots for a burst of writes, a full ring is handled according to the EQueueFullPolicy.
+        /// With EQueueFullPolicy::DROP fewer slots than requested may be returned, callers only write and commit size() of them.
+        /// Nothing becomes visible to the readers until CommitWrite() publishes the whole batch with a single sequence update.
+        auto ReserveWrite(size_t count) noexcept -> SSlots<T>
+        {
+            count = std::min(count, m_store.size());
+            const auto writeSeq = m_producer.writeSeq.load(std::memory_order_relaxed);
+            const auto available = WaitForSpace(writeSeq, count);
+            if (UNLIKELY(available < count))
+            {
+                m_producer.dropCount.store(m_producer.dropCount.load(std::memory_order_relaxed) + count - available, std::memory_order_relaxed);
+            }
+
+            return Slice(m_store.data(), writeSeq, available);
+        }
+
+        auto CommitWrite(size_t count) noexcept
+        {
+            const auto writeSeq = m_producer.writeSeq.load(std::memory_order_relaxed);
+            m_producer.writeSeq.store(writeSeq + count, std::memory_order_release);
+            WakeReaders();
+            SampleOccupancyEvery(writeSeq, writeSeq + count);
+        }
+
+        /// Number of elements written but not yet released by the slowest reader.
+        auto size() const noexcept
+        {
+            const auto writeSeq = m_producer.writeSeq.load(std::memory_order_acquire);
+            return writeSeq - MinReadSequence(writeSeq);
+        }
+
+        auto capacity() const noexcept
+        {
+            return m_store.size();
+        }
+
+        /// Safe to call from any thread, the counters are only ever written by the producer.
+        auto Stats() const -> SQueueStats
+        {
+            return {m_name, m_fullPolicy, capacity(), size(),
+                    m_producer.highWaterMark.load(std::memory_order_relaxed),
+                    m_producer.fullCount.load(std::memory_order_relaxed),
+                    m_producer.dropCount.load(std::memory_order_relaxed)};
+        }
+
+        /// Deleted default, copy & move constructors and assignment-operators.
+        CBroadcastRing() = delete;
+
+        CBroadcastRing(const CBroadcastRing &) = delete;
+
+        CBroadcastRing(const CBroadcastRing &&) = delete;
+
+        CBroadcastRing &operator=(const CBroadcastRing &) = delete;
+
+        CBroadcastRing &operator=(const CBroadcastRing &&) = delete;
+
+    private:
+        /// Return how many of the count slots starting at writeSeq are free.
+        /// Only the first check runs in the common case, the rest is the full path: rescan the read cursors and apply the EQueueFullPolicy.
+        auto WaitForSpace(size_t writeSeq, size_t count) noexcept -> size_t
+        {
+            if (LIKELY(writeSeq + count - m_producer.cachedMinReadSeq <= m_store.size()))
+            {
+                return count;
+            }
+
+            m_producer.cachedMinReadSeq = MinReadSequence(writeSeq);
+            SampleOccupancy(writeSeq, m_producer.cachedMinReadSeq);
+            if (writeSeq + count - m_producer.cachedMinReadSeq <= m_store.size())
+            {
+                return count;
+            }
+
+            m_producer.fullCount.store(m_producer.fullCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            switch (m_fullPolicy)
+            {
+                case EQueueFullPolicy::SPIN:
+                    while (writeSeq + count - m_producer.cachedMinReadSeq > m_store.size())
+                    {
+                        m_producer.cachedMinReadSeq = MinReadSequence(writeSeq);
+                    }
+                    return count;
+                case EQueueFullPolicy::DROP:
+                    return m_store.size() - (writeSeq - m_producer.cachedMinReadSeq);
+                case EQueueFullPolicy::FAIL_FAST:
+                    FATAL("Broadcast ring full:" + Stats().ToString());
+            }
+
+            return 0;
+        }
+
+        auto WakeReaders() noexcept
+        {
+            for (auto pWaitStrategy : m_producer.readerWaitStrategies)
+            {
+                pWaitStrategy->Unpark();
+            }
+        }
+
+        auto SampleOccupancy(size_t writeSeq, size_t minReadSeq) noexcept
+        {
+            if (writeSeq - minReadSeq > m_producer.highWaterMark.load(std::memory_order_relaxed))
+            {
+                m_producer.highWaterMark.store(writeSeq - minReadSeq, std::memory_order_relaxed);
+            }
+        }
+
+        /// Sample exactly when the writes from oldWriteSeq to writeSeq crossed a QUEUE_STATS_SAMPLE_INTERVAL boundary, single writes and batch
+        /// commits alike. The readers' cursor lines are only scanned then, and the result refreshes the producer's cached minimum on the way.
+        auto SampleOccupancyEvery(size_t oldWriteSeq, size_t writeSeq) noexcept
+        {
+            if (UNLIKELY((oldWriteSeq ^ writeSeq) & ~(QUEUE_STATS_SAMPLE_INTERVAL - 1)))
+            {
+                m_producer.cachedMinReadSeq = MinReadSequence(writeSeq);
+                SampleOccupancy(writeSeq, m_producer.cachedMinReadSeq);
+            }
+        }
+
+        /// Slowest read cursor across all registered readers, writeSeq when there are none so the producer never blocks on an empty ring.
+        auto MinReadSequence(size_t writeSeq) const noexcept
+        {
+            auto minReadSeq = writeSeq;
+            const auto numReaders = m_numReaders.load(std::memory_order_acquire);
+            for (size_t i = 0; i < numReaders; ++i)
+            {
+                minReadSeq = std::min(minReadSeq, m_cursors[i].readSeq.load(std::memory_order_acquire));
+            }
+
+            return minReadSeq;
+        }
+
+        template <typename U>
+        auto Slice(U *pBase, size_t seq, size_t count) const noexcept -> SSlots<U>
+        {
+            return SliceRing(pBase, m_mask, seq, count);
+        }
+
+        /// Underlying container of data, size is always a power of two.
+        /// Read-only after construction so it can share a cache line between all threads.
+        alignas(CACHE_LINE_SIZE) std::vector<T, Common::CHugePageAllocator<T>> m_store;
+        const size_t m_mask;
+
+        const std::string      m_name;
+        const EQueueFullPolicy m_fullPolicy;
+
+        /// Written only by the producer, readers load writeSeq when their cached copy runs out.
+        /// The statistics are atomics only so Stats() can read them from another thread, the producer updates them with plain relaxed stores.
+        struct alignas(CACHE_LINE_SIZE) SProducerState
+        {
+            std::atomic<size_t> writeSeq = {0};
+            size_t cachedMinReadSeq = 0;
+            bool isDropping = false;
+
+            /// Wait strategies of the readers registered with one, filled in by AddReader() before the producer starts.
+            std::vector<Common::CWaitStrategy *> readerWaitStrategies;
+
+            std::atomic<size_t> highWaterMark = {0};
+            std::atomic<size_t> fullCount = {0};
+            std::atomic<size_t> dropCount = {0};
+
+            /// Scratch element handed out by GetNextToWriteTo() while dropping.
+            T dropSlot = T();
+        } m_producer;
+
+        /// One cache line per reader, fixed at construction so cursors never move while the producer scans them.
+        std::vector<typename CReader::SCursor> m_cursors;
+        std::atomic<size_t>                   m_numReaders = {0};
+        std::vector<CReader>                  m_readers;
+    };
+}
@@ -0,0 +1,242 @@
+#include "FlightRecorder.h"
+
+#include <csignal>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace Common
+{
+    namespace
+    {
+        constexpr std::array<int, 5> FATAL_SIGNALS = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+        /// Copy src to pDest, NUL terminated, and return where the NUL went. The async signal safe stand-in for snprintf().
+        auto Append(char *pDest, const char *pEnd, const char *src) noexcept -> char *
+        {
+            while (*src && pDest + 1 < pEnd)
+            {
+                *pDest++ = *src++;
+            }
+            *pDest = '\0';
+            return pDest;
+        }
+
+        auto Append(char *pDest, const char *pEnd, uint64_t value) noexcept -> char *
+        {
+            char digits[24];
+            auto p = digits + sizeof(digits) - 1;
+            *p = '\0';
+            do
+            {
+                *--p = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value);
+            return Append(pDest, pEnd, p);
+        }
+
+        auto WriteAll(int fd, const void *pData, size_t size) noexcept
+        {
+            auto p = static_cast<const char *>(pData);
+            while (size)
+            {
+                const auto n = write(fd, p, size);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    return false;
+                }
+                p += n;
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        auto OnFatalSignal(int signal) noexcept -> void
+        {
+            const auto savedErrno = errno;
+            CFlightRecorderRegistry::Instance().Dump(signal == SIGABRT ? "abort" : "signal");
+            errno = savedErrno;
+
+            // SA_RESETHAND put the default action back, raising the signal again lets it run: core dump, exit status, all as without the recorder.
+            raise(signal);
+        }
+
+        auto OnContractFailed() noexcept -> void
+        {
+            CFlightRecorderRegistry::Instance().Dump("contract");
+        }
+    }
+
+    auto CFlightRecorder::Create() noexcept -> CFlightRecorder *
+    {
+        // Left to leak on purpose: the ring must outlive its thread for a later dump to show what the thread did last.
+        auto pRecorder = new CFlightRecorder();
+        pthread_getname_np(pthread_self(), pRecorder->m_threadName, sizeof(pRecorder->m_threadName));
+        pRecorder->m_tid = static_cast<int32_t>(gettid());
+
+        if (!CFlightRecorderRegistry::Instance().Register(pRecorder))
+        {
+            std::cerr << "CFlightRecorder no room for thread:" << pRecorder->m_threadName << " tid:" << pRecorder->m_tid
+                      << ", its events are left out of dumps" << std::endl;
+        }
+
+        return pRecorder;
+    }
+
+    CFlightRecorderRegistry::CFlightRecorderRegistry()
+    {
+        auto p = Append(m_pathPrefix, std::end(m_pathPrefix), program_invocation_short_name);
+        p = Append(p, std::end(m_pathPrefix), "_");
+        p = Append(p, std::end(m_pathPrefix), static_cast<uint64_t>(getpid()));
+        Append(p, std::end(m_pathPrefix), "_flight_");
+
+        // Constructed before the registry so it is destroyed after it, the thresholds and every dump convert with it.
+        CTscClock::Instance();
+        SetLatencyThreshold(FLIGHT_RECORDER_LATENCY_THRESHOLD);
+
+        InstallSignalHandlers();
+        pContractFailedHook = OnContractFailed;
+
+        m_isRunning = true;
+        m_pThread = CreateAndStartThread(-1, "Common/CFlightRecorderRegistry", [this]() { Run(); });
+        ASSERT(m_pThread != nullptr, "Failed to start CFlightRecorderRegistry thread.");
+    }
+
+    CFlightRecorderRegistry::~CFlightRecorderRegistry()
+    {
+        if (m_pThread)
+        {
+            m_isRunning = false;
+            m_pThread->join();
+
+            delete m_pThread;
+            m_pThread = nullptr;
+        }
+    }
+
+    auto CFlightRecorderRegistry::InstallSignalHandlers() -> void
+    {
+        struct sigaction action = {};
+        action.sa_handler = OnFatalSignal;
+        action.sa_flags = SA_RESETHAND | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+
+        for (const auto signal : FATAL_SIGNALS)
+        {
+            // Leave a handler someone else installed alone, only take over the default action.
+            struct sigaction previous = {};
+            if (sigaction(signal, nullptr, &previous) == 0 && previous.sa_handler == SIG_DFL)
+            {
+                ASSERT(sigaction(signal, &action, nullptr) == 0, "sigaction() failed for signal:" + std::to_string(signal) + " error:" + std::string(std::strerror(errno)));
+            }
+        }
+    }
+
+    auto CFlightRecorderRegistry::Register(CFlightRecorder *pRecorder) noexcept -> bool
+    {
+        const auto index = m_numRecorders.fetch_add(1, std::memory_order_relaxed);
+        if (UNLIKELY(index >= FLIGHT_RECORDER_MAX_THREADS))
+        {
+            return false;
+        }
+
+        m_recorders[index].store(pRecorder, std::memory_order_release);
+        return true;
+    }
+
+    auto CFlightRecorderRegistry::SetLatencyThreshold(Nanos thresholdNanos) noexcept -> void
+    {
+        const auto nanosPerTick = CTscClock::Instance().NanosPerTick();
+        m_thresholdTicks.store(thresholdNanos > 0 && nanosPerTick > 0 ? static_cast<uint64_t>(static_cast<double>(thresholdNanos) / nanosPerTick) : UINT64_MAX,
+                               std::memory_order_relaxed);
+    }
+
+    auto CFlightRecorderRegistry::Dump(const char *reason) noexcept -> void
+    {
+        // Only stack buffers, atomics and syscalls from here on, this runs in signal handlers and after a failed check.
+        char path[sizeof(m_pathPrefix) + 48];
+        auto p = Append(path, std::end(path), m_pathPrefix);
+        p = Append(p, std::end(path), reason);
+        p = Append(p, std::end(path), "_");
+        p = Append(p, std::end(path), static_cast<uint64_t>(m_numDumps.fetch_add(1, std::memory_order_relaxed)));
+        Append(p, std::end(path), ".bin");
+
+        const auto fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            static constexpr char error[] = "CFlightRecorderRegistry failed to open the dump file\n";
+            (void)!write(STDERR_FILENO, error, sizeof(error) - 1);
+            return;
+        }
+
+        const auto numRecorders = std::min(m_numRecorders.load(std::memory_order_acquire), FLIGHT_RECORDER_MAX_THREADS);
+
+        // clock_gettime() is async signal safe where CTscClock::ToNanos() is not: its seqlock would spin forever if the signal interrupted the recalibration.
+        timespec now = {};
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        SFlightDumpHeader header;
+        header.pid = getpid();
+        header.tsc = rdtsc();
+        header.nanos = static_cast<Nanos>(now.tv_sec) * NANOS_TO_SECS + now.tv_nsec;
+        header.nanosPerTick = CTscClock::Instance().NanosPerTick();
+        Append(header.reason, std::end(header.reason), reason);
+
+        // A ring registered but not yet stored is left out, the count in the header is what follows.
+        std::array<CFlightRecorder *, FLIGHT_RECORDER_MAX_THREADS> recorders = {};
+        for (size_t i = 0; i < numRecorders; ++i)
+        {
+            recorders[header.numThreads] = m_recorders[i].load(std::memory_order_acquire);
+            header.numThreads += (recorders[header.numThreads] != nullptr);
+        }
+
+        auto isWritten = WriteAll(fd, &header, sizeof(header));
+        for (size_t i = 0; i < header.numThreads && isWritten; ++i)
+        {
+            const auto &recorder = *recorders[i];
+
+            SFlightDumpThread thread;
+            std::memcpy(thread.threadName, recorder.m_threadName, sizeof(thread.threadName));
+            thread.tid = recorder.m_tid;
+            thread.next = recorder.m_next.load(std::memory_order_acquire);
+
+            isWritten = WriteAll(fd, &thread, sizeof(thread)) && WriteAll(fd, recorder.m_records.data(), sizeof(recorder.m_records));
+        }
+        close(fd);
+
+        const char *lines[] = {"CFlightRecorderRegistry ", isWritten ? "dumped " : "failed to write ", path, "\n"};
+        for (const auto line : lines)
+        {
+            (void)!write(STDERR_FILENO, line, strlen(line));
+        }
+    }
+
+    auto CFlightRecorderRegistry::Run() -> void
+    {
+        // Polls rather than waits, RequestDump() comes from hot threads that must not pay for a notify.
+        size_t numLatencyDumps = 0;
+        auto lastDump = std::chrono::steady_clock::now() - FLIGHT_RECORDER_DUMP_INTERVAL;
+        while (m_isRunning)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+            if (!m_isDumpRequested.exchange(false, std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (numLatencyDumps < FLIGHT_RECORDER_MAX_LATENCY_DUMPS && now - lastDump >= FLIGHT_RECORDER_DUMP_INTERVAL)
+            {
+                Dump("latency");
+                lastDump = now;
+                ++numLatencyDumps;
+            }
+        }
+    }
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+
+#include "Macros.h"
+#include "PerfUtils.h"
+#include "TimeUtils.h"
+#include "Types.h"
+
+namespace Common
+{
+    /// Records each thread's ring keeps, the last FLIGHT_RECORDER_RECORDS events it recorded. A power of two, 160 KB per thread.
+    constexpr size_t FLIGHT_RECORDER_RECORDS = 4096;
+
+    /// Most threads a dump covers, later threads still get a ring but it is never dumped.
+    constexpr size_t FLIGHT_RECORDER_MAX_THREADS = 64;
+
+    /// Default end to end latency of an in-process trace past which the rings are dumped, see CFlightRecorderRegistry::SetLatencyThreshold().
+    constexpr Nanos FLIGHT_RECORDER_LATENCY_THRESHOLD = 250 * NANOS_TO_MICROS;
+
+    /// Latency dumps are at least this far apart and at most FLIGHT_RECORDER_MAX_LATENCY_DUMPS per process, so a slow patch does not fill the disk.
+    constexpr auto FLIGHT_RECORDER_DUMP_INTERVAL = std::chrono::seconds(10);
+    constexpr size_t FLIGHT_RECORDER_MAX_LATENCY_DUMPS = 16;
+
+    /// Bumped every time the dump file layout below changes, "ULLFLIT\0" in little endian identifies a dump.
+    constexpr uint32_t FLIGHT_RECORDER_LAYOUT_VERSION = 2;
+    constexpr uint64_t FLIGHT_RECORDER_MAGIC = 0x0054494c464c4c55;
+
+    /// What a record is about. id is the order's TraceId for order events, the update's sequence number for market data.
+    enum class EFlightEvent : uint8_t
+    {
+        NONE = 0,
+        REQUEST_RECEIVED,     /// Order server read a client request, type is the EClientRequestType.
+        REQUEST_PROCESSED,    /// Matching engine processed a client request, type is the EClientRequestType.
+        MATCH,                /// Matching engine filled qty at price, id is the aggressive order, type is 0.
+        RESPONSE_QUEUED,      /// Matching engine wrote a client response for the order server, type is the EClientResponseType.
+        RESPONSE_SENT,        /// Order server sent a client response, type is the EClientResponseType.
+        MARKET_UPDATE_QUEUED, /// Matching engine wrote a market update for the publisher, type is the EMarketUpdateType, id the market order id.
+        MARKET_UPDATE_SENT,   /// Market data publisher sent an update on the incremental stream, type is the EMarketUpdateType, id the sequence number.
+        MARKET_UPDATE_READ,   /// Trade engine processed a market update, type is the EMarketUpdateType, id the market order id.
+        RESPONSE_READ,        /// Trade engine processed a client response, type is the EClientResponseType.
+        REQUEST_SENT,         /// Order gateway sent a client request, type is the EClientRequestType.
+        COUNT
+    };
+
+    inline constexpr auto FormatFlightEvent(EFlightEvent event) noexcept -> std::string_view
+    {
+        switch (event)
+        {
+            case EFlightEvent::NONE:                 return "NONE";
+            case EFlightEvent::REQUEST_RECEIVED:     return "REQUEST_RECEIVED";
+            case EFlightEvent::REQUEST_PROCESSED:    return "REQUEST_PROCESSED";
+            case EFlightEvent::MATCH:                return "MATCH";
+            case EFlightEvent::RESPONSE_QUEUED:      return "RESPONSE_QUEUED";
+            case EFlightEvent::RESPONSE_SENT:        return "RESPONSE_SENT";
+            case EFlightEvent::MARKET_UPDATE_QUEUED: return "MARKET_UPDATE_QUEUED";
+            case EFlightEvent::MARKET_UPDATE_SENT:   return "MARKET_UPDATE_SENT";
+            case EFlightEvent::MARKET_UPDATE_READ:   return "MARKET_UPDATE_READ";
+            case EFlightEvent::RESPONSE_READ:        return "RESPONSE_READ";
+            case EFlightEvent::REQUEST_SENT:         return "REQUEST_SENT";
+            case EFlightEvent::COUNT:                break;
+        }
+        return "UNKNOWN";
+    }
+
+    /// One event, the full TickerId makes it 40 bytes rather than two to a cache line.
+    struct SFlightRecord
+    {
+        uint64_t     tsc = 0;
+        uint64_t     id = 0;
+        int64_t      price = 0;
+        uint32_t     qty = 0;
+        TickerId     tickerId = 0;
+        EFlightEvent event = EFlightEvent::NONE;
+        uint8_t      type = 0;
+        int8_t       side = 0;
+    };
+
+    static_assert(sizeof(SFlightRecord) == 40);
+
+    /// One thread's ring of its last FLIGHT_RECORDER_RECORDS events. Only the owning thread writes: a record is a handful of plain stores
+    /// and an index bump, nothing is synchronised. A dump taken while the owner records may catch the newest record half written.
+    class CFlightRecorder final
+    {
+    public:
+        /// The calling thread's ring, created and registered on its first event. Rings are never freed, so a dump still sees the threads that exited.
+        static auto ForThisThread() noexcept -> CFlightRecorder *
+        {
+            static thread_local CFlightRecorder *pRecorder = nullptr;
+            if (UNLIKELY(!pRecorder))
+            {
+                pRecorder = Create();
+            }
+            return pRecorder;
+        }
+
+        auto Record(EFlightEvent event, uint64_t id, TickerId tickerId, int8_t side, int64_t price, uint32_t qty, uint8_t type) noexcept
+        {
+            const auto next = m_next.load(std::memory_order_relaxed);
+            auto &record = m_records[next & (FLIGHT_RECORDER_RECORDS - 1)];
+            record.tsc = rdtsc();
+            record.id = id;
+            record.price = price;
+            record.qty = qty;
+            record.event = event;
+            record.type = type;
+            record.side = side;
+            record.tickerId = tickerId;
+            m_next.store(next + 1, std::memory_order_release);
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CFlightRecorder(const CFlightRecorder &) = delete;
+
+        CFlightRecorder(const CFlightRecorder &&) = delete;
+
+        CFlightRecorder &operator=(const CFlightRecorder &) = delete;
+
+        CFlightRecorder &operator=(const CFlightRecorder &&) = delete;
+
+    private:
+        friend class CFlightRecorderRegistry;
+
+        CFlightRecorder() = default;
+
+        static auto Create() noexcept -> CFlightRecorder *;
+
+        char                                                 m_threadName[16] = {};
+        int32_t                                              m_tid = 0;
+        std::atomic<uint64_t>                                m_next = {0};
+        std::array<SFlightRecord, FLIGHT_RECORDER_RECORDS>   m_records = {};
+    };
+
+    /// Start of a dump file, <process name>_<pid>_flight_<reason>_<n>.bin. Each thread's SFlightDumpThread and its ring follow,
+    /// SFlightDumpThread::next says where the ring wraps.
+    struct SFlightDumpHeader
+    {
+        uint64_t magic = FLIGHT_RECORDER_MAGIC;
+        uint32_t layoutVersion = FLIGHT_RECORDER_LAYOUT_VERSION;
+        uint32_t numThreads = 0;
+        uint32_t recordsPerThread = FLIGHT_RECORDER_RECORDS;
+        int32_t  pid = 0;
+
+        /// One TSC reading and the wall clock it converts to, to turn the records' TSC stamps into wall clock nanoseconds.
+        uint64_t tsc = 0;
+        Nanos    nanos = 0;
+        double   nanosPerTick = 0.0;
+        char     reason[16] = {};
+    };
+
+    struct SFlightDumpThread
+    {
+        char     threadName[16] = {};
+        int32_t  tid = 0;
+        uint32_t reserved = 0;
+        uint64_t next = 0;
+    };
+
+    /// Process wide list of the threads' rings and the ways they get written to disk:
+    /// - a fatal signal (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT), from the signal handler before the default action runs,
+    /// - a failed ASSERT / FATAL, from ContractFailed() before it exits,
+    /// - a traced message slower than the latency threshold, by a background thread shortly after, rate limited.
+    /// Dumping only uses open() / write() / close() on buffers that already exist, so it is safe from a signal handler.
+    /// The mains call Instance() before starting their threads so all of that is in place from the start, the first event would otherwise create it.
+    class CFlightRecorderRegistry final
+    {
+    public:
+        static auto Instance() -> CFlightRecorderRegistry &
+        {
+            static CFlightRecorderRegistry registry;
+            return registry;
+        }
+
+        /// Write every ring to a new dump file now, on the calling thread. Async signal safe.
+        auto Dump(const char *reason) noexcept -> void;
+
+        /// Ask the background thread to dump soon, the rings go on recording in the meantime so the dump shows what followed too.
+        /// A store and nothing else, for the hot path.
+        auto RequestDump() noexcept
+        {
+            m_isDumpRequested.store(true, std::memory_order_relaxed);
+        }
+
+        /// Traces slower end to end than thresholdNanos request a dump, 0 disables latency dumps.
+        auto SetLatencyThreshold(Nanos thresholdNanos) noexcept -> void;
+
+        auto IsOverLatencyThreshold(uint64_t ticks) const noexcept
+        {
+            return ticks > m_thresholdTicks.load(std::memory_order_relaxed);
+        }
+
+        ~CFlightRecorderRegistry();
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CFlightRecorderRegistry(const CFlightRecorderRegistry &) = delete;
+
+        CFlightRecorderRegistry(const CFlightRecorderRegistry &&) = delete;
+
+        CFlightRecorderRegistry &operator=(const CFlightRecorderRegistry &) = delete;
+
+        CFlightRecorderRegistry &operator=(const CFlightRecorderRegistry &&) = delete;
+
+    private:
+        friend class CFlightRecorder;
+
+        CFlightRecorderRegistry();
+
+        auto Register(CFlightRecorder *pRecorder) noexcept -> bool;
+
+        auto InstallSignalHandlers() -> void;
+
+        auto Run() -> void;
+
+        std::array<std::atomic<CFlightRecorder *>, FLIGHT_RECORDER_MAX_THREADS> m_recorders = {};
+        std::atomic<size_t>                                                     m_numRecorders = {0};
+
+        /// <process name>_<pid>_flight_, built up front so a dump from a signal handler only has to append to it.
+        char                  m_pathPrefix[128] = {};
+        std::atomic<uint32_t> m_numDumps = {0};
+
+        std::atomic<uint64_t> m_thresholdTicks = {UINT64_MAX};
+        std::atomic<bool>     m_isDumpRequested = {false};
+
+        std::thread      *m_pThread = nullptr;
+        std::atomic<bool> m_isRunning = {false};
+    };
+}
+
+/// Record EVENT in the calling thread's flight recorder.
+#define FLIGHT_RECORD(EVENT, ID, TICKER, SIDE, PRICE, QTY, TYPE)                                                        \
+    Common::CFlightRecorder::ForThisThread()->Record(Common::EFlightEvent::EVENT, (ID), (TICKER),                       \
+                                                     static_cast<int8_t>(SIDE), (PRICE), (QTY), static_cast<uint8_t>(TYPE))
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "Macros.h"
+
+namespace Common
+{
+    /// Bytes of stack FormatToString() formats into before it falls back to a heap buffer, enough for every message and order ToString().
+    constexpr size_t FORMAT_INLINE_SIZE = 512;
+
+    /// A value that is written as INVALID when it holds the sentinel of its type, the ids, prices and quantities in Types.h.
+    template <typename T>
+    struct SFormatChecked
+    {
+        T value;
+        T invalid;
+    };
+
+    /// A value padded with spaces to at least width characters, right aligned, or left aligned for a negative width, like printf's %5s / %-5s.
+    template <typename T>
+    struct SFormatPadded
+    {
+        T   value;
+        int width;
+    };
+
+    template <typename T>
+    constexpr auto Padded(const T &value, int width) noexcept
+    {
+        return SFormatPadded<T>{value, width};
+    }
+
+    class CFormatBuffer;
+
+    /// Types that write themselves with a Format(CFormatBuffer &) member.
+    template <typename V>
+    concept Formattable = requires(const V &value, CFormatBuffer &out) { value.Format(out); };
+
+    /// Appends text and numbers to a caller provided buffer, numbers through std::to_chars, and never allocates.
+    /// Output that does not fit is dropped and IsTruncated() is set, the contents are never NUL terminated.
+    /// Constructed over a std::string instead, the buffer grows the string as needed and is never truncated, for FormatToString().
+    /// Floating point values are written like std::ostream's defaults, 6 significant digits.
+    class CFormatBuffer
+    {
+    public:
+        CFormatBuffer(char *pData, size_t capacity) noexcept : m_pData(pData), m_capacity(capacity)
+        {
+        }
+
+        explicit CFormatBuffer(std::string &str) noexcept : m_pData(str.data()), m_capacity(str.size()), m_pString(&str)
+        {
+        }
+
+        auto View() const noexcept
+        {
+            return std::string_view(m_pData, m_size);
+        }
+
+        auto size() const noexcept
+        {
+            return m_size;
+        }
+
+        auto capacity() const noexcept
+        {
+            return m_capacity;
+        }
+
+        auto IsTruncated() const noexcept
+        {
+            return m_isTruncated;
+        }
+
+        auto Clear() noexcept
+        {
+            m_size = 0;
+            m_isTruncated = false;
+        }
+
+        auto Append(std::string_view str) noexcept -> CFormatBuffer &
+        {
+            Reserve(str.size());
+            const auto count = std::min(str.size(), m_capacity - m_size);
+            memcpy(m_pData + m_size, str.data(), count);
+            m_size += count;
+            m_isTruncated |= (count != str.size());
+
+            return *this;
+        }
+
+        auto Append(const char *str) noexcept -> CFormatBuffer &
+        {
+            return Append(std::string_view(str));
+        }
+
+        auto Append(char c) noexcept -> CFormatBuffer &
+        {
+            if (!Reserve(1))
+            {
+                m_isTruncated = true;
+                return *this;
+            }
+            m_pData[m_size++] = c;
+
+            return *this;
+        }
+
+        auto Append(bool value) noexcept -> CFormatBuffer &
+        {
+            return Append(value ? '1' : '0');
+        }
+
+        template <typename V>
+            requires(std::integral<V> && !std::same_as<V, char> && !std::same_as<V, bool>)
+        auto Append(V value) noexcept -> CFormatBuffer &
+        {
+            return ToChars([value](char *pFirst, char *pLast) { return std::to_chars(pFirst, pLast, value); });
+        }
+
+        template <std::floating_point V>
+        auto Append(V value) noexcept -> CFormatBuffer &
+        {
+            return ToChars([value](char *pFirst, char *pLast) { return std::to_chars(pFirst, pLast, value, std::chars_format::general, 6); });
+        }
+
+        template <typename T>
+        auto Append(const SFormatChecked<T> &checked) noexcept -> CFormatBuffer &
+        {
+            if (checked.value == checked.invalid)
+            {
+                return Append(std::string_view("INVALID"));
+            }
+
+            return Append(checked.value);
+        }
+
+        template <typename T>
+        auto Append(const SFormatPadded<T> &padded) noexcept -> CFormatBuffer &
+        {
+            char buf[64];
+            CFormatBuffer text(buf, sizeof(buf));
+            text.Append(padded.value);
+
+            const auto width = static_cast<size_t>(padded.width < 0 ? -padded.width : padded.width);
+            const auto padding = (text.size() < width ? width - text.size() : 0);
+            if (padded.width > 0)
+            {
+                AppendFill(' ', padding);
+            }
+            Append(text.View());
+            if (padded.width < 0)
+            {
+                AppendFill(' ', padding);
+            }
+
+            return *this;
+        }
+
+        template <Formattable V>
+        auto Append(const V &value) noexcept -> CFormatBuffer &
+        {
+            value.Format(*this);
+            return *this;
+        }
+
+        auto AppendFill(char c, size_t count) noexcept -> CFormatBuffer &
+        {
+            Reserve(count);
+            const auto fill = std::min(count, m_capacity - m_size);
+            memset(m_pData + m_size, c, fill);
+            m_size += fill;
+            m_isTruncated |= (fill != count);
+
+            return *this;
+        }
+
+        template <typename V>
+        auto operator<<(const V &value) noexcept -> CFormatBuffer &
+        {
+            return Append(value);
+        }
+
+        /// Deleted default, copy & move constructors and assignment-operators.
+        CFormatBuffer() = delete;
+
+        CFormatBuffer(const CFormatBuffer &) = delete;
+
+        CFormatBuffer(const CFormatBuffer &&) = delete;
+
+        CFormatBuffer &operator=(const CFormatBuffer &) = delete;
+
+        CFormatBuffer &operator=(const CFormatBuffer &&) = delete;
+
+    private:
+        template <typename F>
+        auto ToChars(F &&toChars) noexcept -> CFormatBuffer &
+        {
+            auto result = toChars(m_pData + m_size, m_pData + m_capacity);
+            if (result.ec != std::errc() && Reserve(m_capacity - m_size + TO_CHARS_MAX_SIZE))
+            {
+                result = toChars(m_pData + m_size, m_pData + m_capacity);
+            }
+            if (result.ec != std::errc())
+            {
+                m_isTruncated = true;
+                return *this;
+            }
+            m_size = result.ptr - m_pData;
+
+            return *this;
+        }
+
+        /// Room for count more bytes, growing the string the buffer was constructed over if there is one.
+        auto Reserve(size_t count) -> bool
+        {
+            if (LIKELY(count <= m_capacity - m_size))
+            {
+                return true;
+            }
+            if (!m_pString)
+            {
+                return false;
+            }
+
+            m_pString->resize(std::max(m_pString->size() * 2, m_size + count));
+            m_pData = m_pString->data();
+            m_capacity = m_pString->size();
+
+            return true;
+        }
+
+        /// Longest text std::to_chars() writes for any integral or floating point value.
+        static constexpr size_t TO_CHARS_MAX_SIZE = 64;
+
+        char        *m_pData = nullptr;
+        size_t       m_capacity = 0;
+        size_t       m_size = 0;
+        bool         m_isTruncated = false;
+        std::string *m_pString = nullptr;
+    };
+
+    template <size_t N>
+    struct SFormatStorage
+    {
+        std::array<char, N> storage;
+    };
+
+    /// CFormatBuffer over N bytes of its own, for formatting on the stack. The bytes live in a base so they exist before CFormatBuffer is handed them.
+    template <size_t N>
+    class CInlineFormatBuffer final : private SFormatStorage<N>, public CFormatBuffer
+    {
+    public:
+        CInlineFormatBuffer() noexcept : CFormatBuffer(this->storage.data(), N)
+        {
+        }
+    };
+
+    /// Format into a std::string, for the ToString() helpers. Output up to FORMAT_INLINE_SIZE bytes is formatted on the stack and copied once,
+    /// anything longer, order book dumps, is formatted again straight into a string that grows as it goes. format is called with a CFormatBuffer &.
+    template <typename F>
+        requires std::invocable<F &, CFormatBuffer &>
+    inline auto FormatToString(F &&format) -> std::string
+    {
+        CInlineFormatBuffer<FORMAT_INLINE_SIZE> inlineBuffer;
+        format(static_cast<CFormatBuffer &>(inlineBuffer));
+        if (!inlineBuffer.IsTruncated())
+        {
+            return std::string(inlineBuffer.View());
+        }
+
+        std::string str(FORMAT_INLINE_SIZE * 4, '\0');
+        CFormatBuffer out(str);
+        format(out);
+        str.resize(out.size());
+
+        return str;
+    }
+
+    template <typename V>
+        requires(!std::invocable<V &, CFormatBuffer &>)
+    inline auto FormatToString(const V &value) -> std::string
+    {
+        return FormatToString([&value](CFormatBuffer &out) { out << value; });
+    }
+}
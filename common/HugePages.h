@@ -0,0 +1,282 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+
+#include "Macros.h"
+
+namespace Common
+{
+    constexpr size_t SMALL_PAGE_SIZE = 4 * 1024;
+    constexpr size_t HUGE_PAGE_2MB_SIZE = 2 * 1024 * 1024;
+    constexpr size_t HUGE_PAGE_1GB_SIZE = 1024 * 1024 * 1024;
+
+    /// 1 GB pages are only used when rounding up to whole pages wastes at most this percentage of the request, 1.1 GB would otherwise pin 2 GB.
+    /// Everything mapped is pre-faulted and mlock'd, so the waste is real memory. Past the limit the region falls back to 2 MB pages.
+    constexpr size_t HUGE_PAGE_1GB_MAX_WASTE_PERCENT = 10;
+
+    /// What kind of pages ended up backing a region returned by AllocateHugePages().
+    enum class EPageKind : int8_t
+    {
+        NORMAL = 0,           /// Regular 4 KB pages.
+        TRANSPARENT_HUGE = 1, /// Regular mapping, 2 MB aligned and madvise(MADV_HUGEPAGE)'d so THP can back it with huge pages.
+        HUGE_2MB = 2,         /// MAP_HUGETLB from the reserved 2 MB huge page pool.
+        HUGE_1GB = 3          /// MAP_HUGETLB from the reserved 1 GB huge page pool.
+    };
+
+    inline auto PageKindToString(EPageKind pageKind) -> std::string
+    {
+        switch (pageKind)
+        {
+            case EPageKind::NORMAL:
+                return "NORMAL";
+            case EPageKind::TRANSPARENT_HUGE:
+                return "TRANSPARENT_HUGE";
+            case EPageKind::HUGE_2MB:
+                return "HUGE_2MB";
+            case EPageKind::HUGE_1GB:
+                return "HUGE_1GB";
+        }
+
+        return "UNKNOWN";
+    }
+
+    /// One mapping made by AllocateHugePages().
+    struct SMappedRegion
+    {
+        std::string name;
+        size_t      requestedBytes = 0;
+        EPageKind   pageKind = EPageKind::NORMAL;
+        bool        isLocked = false;
+
+        /// The mapping actually made, rounded up to a whole number of pages.
+        void   *pMapBase = nullptr;
+        size_t  mapBytes = 0;
+
+        auto ToString() const
+        {
+            std::stringstream ss;
+            ss << "SMappedRegion"
+               << " ["
+               << " name:" << name
+               << " requested:" << requestedBytes
+               << " mapped:" << mapBytes
+               << " pages:" << PageKindToString(pageKind)
+               << " locked:" << isLocked
+               << "]";
+            return ss.str();
+        }
+    };
+
+    /// Process wide list of the regions currently mapped by AllocateHugePages(), for FreeHugePages() and the startup report.
+    /// Only touched when storage is allocated / released, never on the hot path.
+    class CHugePageRegistry final
+    {
+    public:
+        static auto Instance() -> CHugePageRegistry &
+        {
+            static CHugePageRegistry registry;
+            return registry;
+        }
+
+        auto Register(const void *p, SMappedRegion region) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_regions[p] = std::move(region);
+        }
+
+        /// Remove and return the region handed out as p.
+        auto Unregister(const void *p) -> SMappedRegion
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const auto it = m_regions.find(p);
+            ASSERT(it != m_regions.end(), "Releasing memory that was not mapped by AllocateHugePages().");
+            auto region = std::move(it->second);
+            m_regions.erase(it);
+
+            return region;
+        }
+
+        /// One line per region plus the totals and the system transparent huge page setting.
+        auto ToString() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::string thpMode = "unavailable";
+            std::ifstream thpFile("/sys/kernel/mm/transparent_hugepage/enabled");
+            std::getline(thpFile, thpMode);
+
+            size_t totalBytes = 0, wastedBytes = 0, hugeBytes = 0, lockedBytes = 0;
+            std::string str;
+            for (const auto &[p, region] : m_regions)
+            {
+                totalBytes += region.mapBytes;
+                wastedBytes += region.mapBytes - region.requestedBytes;
+                hugeBytes += (region.pageKind != EPageKind::NORMAL ? region.mapBytes : 0);
+                lockedBytes += (region.isLocked ? region.mapBytes : 0);
+                str += region.ToString() + "\n";
+            }
+
+            return str + "Mapped regions:" + std::to_string(m_regions.size()) +
+                   " total:" + std::to_string(totalBytes >> 20) + "MB" +
+                   " rounding-waste:" + std::to_string(wastedBytes >> 20) + "MB" +
+                   " huge:" + std::to_string(hugeBytes >> 20) + "MB" +
+                   " locked:" + std::to_string(lockedBytes >> 20) + "MB" +
+                   " thp:" + thpMode + "\n";
+        }
+
+    private:
+        CHugePageRegistry() = default;
+
+        mutable std::mutex                   m_mutex;
+        std::map<const void *, SMappedRegion> m_regions;
+    };
+
+    inline auto RoundUpToPage(size_t bytes, size_t pageSize) noexcept
+    {
+        return (bytes + pageSize - 1) & ~(pageSize - 1);
+    }
+
+    /// mmap an anonymous private range of bytes starting at a multiple of alignment, FATAL on failure.
+    /// Over-maps by one alignment unit and gives back the slack on either side.
+    inline auto MapAligned(size_t bytes, size_t alignment, int prot, int extraFlags, const std::string &name) -> char *
+    {
+        const auto slackBytes = (alignment > SMALL_PAGE_SIZE ? alignment : 0);
+
+        auto pBase = static_cast<char *>(mmap(nullptr, bytes + slackBytes, prot, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0));
+        if (pBase == MAP_FAILED)
+        {
+            FATAL("mmap() of " + std::to_string(bytes) + " bytes failed for:" + name + " error:" + std::string(std::strerror(errno)));
+        }
+
+        auto p = reinterpret_cast<char *>(RoundUpToPage(reinterpret_cast<uintptr_t>(pBase), alignment));
+        if (p != pBase)
+        {
+            munmap(pBase, p - pBase);
+        }
+        if (p + bytes != pBase + bytes + slackBytes)
+        {
+            munmap(p + bytes, (pBase + bytes + slackBytes) - (p + bytes));
+        }
+
+        return p;
+    }
+
+    /// Touch every page of the range now instead of taking the faults on first use.
+    inline auto PrefaultPages(char *p, size_t bytes) noexcept
+    {
+        for (size_t i = 0; i < bytes; i += SMALL_PAGE_SIZE)
+        {
+            p[i] = 0;
+        }
+    }
+
+    /// Map bytes of zeroed, pre-faulted memory, preferring 1 GB then 2 MB huge pages, then transparent huge pages, then regular pages.
+    /// Huge pages are only tried for regions at least one huge page long, so small pools do not pin a whole huge page each,
+    /// and 1 GB pages only when the rounding stays within HUGE_PAGE_1GB_MAX_WASTE_PERCENT.
+    /// The region is mlock'd when RLIMIT_MEMLOCK allows it. Every page is resident on return, so using it never page faults.
+    /// Meant for storage sized once at startup, the result is recorded in CHugePageRegistry for the startup report.
+    inline auto AllocateHugePages(size_t bytes, const std::string &name) -> void *
+    {
+        SMappedRegion region{name, bytes};
+
+        const auto mapHugeTlb = [&](size_t pageSize, int pageShift, EPageKind pageKind, size_t maxWastePercent)
+        {
+            const auto mapBytes = RoundUpToPage(bytes, pageSize);
+            if (region.pMapBase || bytes < pageSize || (mapBytes - bytes) * 100 > bytes * maxWastePercent)
+            {
+                return;
+            }
+
+            auto p = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE | (pageShift << MAP_HUGE_SHIFT), -1, 0);
+            if (p != MAP_FAILED)
+            {
+                region.pMapBase = p;
+                region.mapBytes = mapBytes;
+                region.pageKind = pageKind;
+            }
+        };
+        mapHugeTlb(HUGE_PAGE_1GB_SIZE, 30, EPageKind::HUGE_1GB, HUGE_PAGE_1GB_MAX_WASTE_PERCENT);
+        mapHugeTlb(HUGE_PAGE_2MB_SIZE, 21, EPageKind::HUGE_2MB, 100);
+
+        auto p = static_cast<char *>(region.pMapBase);
+        if (!p)
+        {
+            // No reserved huge pages, map regular pages and ask for THP, which only ever backs 2 MB aligned ranges.
+            const auto wantsThp = (bytes >= HUGE_PAGE_2MB_SIZE);
+            const auto mapBytes = RoundUpToPage(bytes, wantsThp ? HUGE_PAGE_2MB_SIZE : SMALL_PAGE_SIZE);
+            p = MapAligned(mapBytes, wantsThp ? HUGE_PAGE_2MB_SIZE : SMALL_PAGE_SIZE, PROT_READ | PROT_WRITE, 0, name);
+
+            region.pMapBase = p;
+            region.mapBytes = mapBytes;
+            region.pageKind = ((wantsThp && madvise(p, mapBytes, MADV_HUGEPAGE) == 0) ? EPageKind::TRANSPARENT_HUGE : EPageKind::NORMAL);
+
+            PrefaultPages(p, mapBytes);
+        }
+
+        region.isLocked = (mlock(region.pMapBase, region.mapBytes) == 0);
+        CHugePageRegistry::Instance().Register(p, std::move(region));
+
+        return p;
+    }
+
+    /// Release a region returned by AllocateHugePages().
+    inline auto FreeHugePages(void *p) -> void
+    {
+        if (!p)
+        {
+            return;
+        }
+
+        const auto region = CHugePageRegistry::Instance().Unregister(p);
+        munmap(region.pMapBase, region.mapBytes);
+    }
+
+    /// Standard allocator over AllocateHugePages(), for containers that are sized once and never grow, e.g. the storage of pools and queues.
+    /// name only labels the regions in the startup report, it must be a string literal.
+    template <typename T>
+    class CHugePageAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit CHugePageAllocator(const char *name) noexcept : m_name(name)
+        {
+        }
+
+        template <typename U>
+        CHugePageAllocator(const CHugePageAllocator<U> &other) noexcept : m_name(other.m_name)
+        {
+        }
+
+        auto allocate(size_t n) -> T *
+        {
+            return static_cast<T *>(AllocateHugePages(n * sizeof(T), m_name));
+        }
+
+        auto deallocate(T *p, size_t) noexcept -> void
+        {
+            FreeHugePages(p);
+        }
+
+        template <typename U>
+        auto operator==(const CHugePageAllocator<U> &) const noexcept
+        {
+            return true;
+        }
+
+    private:
+        template <typename U>
+        friend class CHugePageAllocator;
+
+        const char *m_name;
+    };
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+namespace Common
+{
+    /// Every power of two range is split into 2^LATENCY_SUB_BUCKET_BITS linear buckets, so a recorded value is off by at most 1/64 (1.6%).
+    constexpr size_t LATENCY_SUB_BUCKET_BITS = 6;
+    constexpr size_t LATENCY_SUB_BUCKETS = size_t{1} << LATENCY_SUB_BUCKET_BITS;
+
+    /// Enough buckets to cover the whole uint64_t range: values below 2 * LATENCY_SUB_BUCKETS get a bucket each, every power of two above that gets
+    /// LATENCY_SUB_BUCKETS.
+    constexpr size_t LATENCY_BUCKETS = (65 - LATENCY_SUB_BUCKET_BITS) * LATENCY_SUB_BUCKETS;
+
+    /// Log-linear (HDR style) bucket index of value.
+    constexpr auto LatencyBucket(uint64_t value) noexcept -> size_t
+    {
+        if (value < 2 * LATENCY_SUB_BUCKETS)
+        {
+            return value;
+        }
+
+        const auto shift = static_cast<size_t>(63 - std::countl_zero(value)) - LATENCY_SUB_BUCKET_BITS;
+        return shift * LATENCY_SUB_BUCKETS + (value >> shift);
+    }
+
+    /// Largest value that falls in the bucket, what percentiles are reported as.
+    constexpr auto LatencyBucketHighest(size_t bucket) noexcept -> uint64_t
+    {
+        if (bucket < 2 * LATENCY_SUB_BUCKETS)
+        {
+            return bucket;
+        }
+
+        const auto shift = bucket / LATENCY_SUB_BUCKETS - 1;
+        return ((static_cast<uint64_t>(bucket - shift * LATENCY_SUB_BUCKETS) + 1) << shift) - 1;
+    }
+
+    static_assert(LatencyBucket(UINT64_MAX) == LATENCY_BUCKETS - 1);
+    static_assert(LatencyBucketHighest(LatencyBucket(1000)) >= 1000 && LatencyBucketHighest(LatencyBucket(1000) - 1) < 1000);
+
+    /// What a histogram's values are: TSC ticks, reported converted to nanoseconds, or a plain count of events, reported as is.
+    enum class EHistogramUnit : uint8_t
+    {
+        TICKS = 0,
+        COUNT = 1
+    };
+
+    class CLatencyHistogram;
+
+    /// Counts copied out of one or more CLatencyHistogram, to compute percentiles from off the recording thread.
+    struct SLatencySnapshot
+    {
+        std::array<uint64_t, LATENCY_BUCKETS> counts = {};
+        uint64_t                              count = 0;
+        uint64_t                              sum = 0;
+        uint64_t                              max = 0;
+
+        /// Add the histogram's counts to the snapshot, the histogram may be recording concurrently.
+        auto Merge(const CLatencyHistogram &histogram) noexcept -> void;
+
+        auto Mean() const noexcept -> double
+        {
+            return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+        }
+
+        /// Smallest value at least fraction of the samples are at or below, rounded up to the end of its bucket but never above max.
+        auto Percentile(double fraction) const noexcept -> uint64_t
+        {
+            const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * static_cast<double>(count) + 0.5));
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+            {
+                seen += counts[bucket];
+                if (seen >= target)
+                {
+                    return std::min(LatencyBucketHighest(bucket), max);
+                }
+            }
+
+            return max;
+        }
+    };
+
+    /// Preallocated latency histogram with a single writer. Record() is a handful of instructions and never allocates, it leaves the counts
+    /// in relaxed atomics so a reporting thread can take a SLatencySnapshot at any time, at worst missing the samples in flight.
+    class CLatencyHistogram final
+    {
+    public:
+        CLatencyHistogram() = default;
+
+        auto Record(uint64_t value) noexcept
+        {
+            Increment(m_counts[LatencyBucket(value)], 1);
+            Increment(m_sum, value);
+            if (value > m_max.load(std::memory_order_relaxed))
+            {
+                m_max.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CLatencyHistogram(const CLatencyHistogram &) = delete;
+
+        CLatencyHistogram(const CLatencyHistogram &&) = delete;
+
+        CLatencyHistogram &operator=(const CLatencyHistogram &) = delete;
+
+        CLatencyHistogram &operator=(const CLatencyHistogram &&) = delete;
+
+    private:
+        friend struct SLatencySnapshot;
+
+        /// Only the owning thread writes, a plain load and store instead of a locked read-modify-write.
+        static auto Increment(std::atomic<uint64_t> &counter, uint64_t value) noexcept -> void
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<uint64_t>, LATENCY_BUCKETS> m_counts = {};
+        std::atomic<uint64_t>                              m_sum = {0};
+        std::atomic<uint64_t>                              m_max = {0};
+    };
+
+    inline auto SLatencySnapshot::Merge(const CLatencyHistogram &histogram) noexcept -> void
+    {
+        // The count is taken from the buckets themselves so percentiles stay consistent with a histogram that is still recording.
+        for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+        {
+            const auto bucketCount = histogram.m_counts[bucket].load(std::memory_order_relaxed);
+            counts[bucket] += bucketCount;
+            count += bucketCount;
+        }
+        sum += histogram.m_sum.load(std::memory_order_relaxed);
+        max = std::max(max, histogram.m_max.load(std::memory_order_relaxed));
+    }
+}
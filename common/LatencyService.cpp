@@ -0,0 +1,61 @@
+#include "LatencyService.h"
+
+#include <errno.h>
+#include <map>
+#include <memory>
+
+#include "TimeUtils.h"
+
+namespace Common
+{
+    auto CLatencyService::ReportLocked() -> void
+    {
+        if (m_histograms.empty())
+        {
+            return;
+        }
+
+        if (!m_file.is_open())
+        {
+            const auto fileName = std::string(program_invocation_short_name) + "_" + std::to_string(getpid()) + "_latency.log";
+            m_file.open(fileName, std::ios::app);
+            ASSERT(m_file.is_open(), "Could not open latency file:" + fileName);
+        }
+
+        std::map<std::string, std::pair<EHistogramUnit, std::unique_ptr<SLatencySnapshot>>> snapshots;
+        for (const auto &histogram : m_histograms)
+        {
+            auto &[unit, snapshot] = snapshots[histogram.tag];
+            if (!snapshot)
+            {
+                unit = histogram.unit;
+                snapshot = std::make_unique<SLatencySnapshot>();
+            }
+            snapshot->Merge(*histogram.pHistogram);
+        }
+
+        std::string timeStr;
+        GetCurrentTimeStr(&timeStr);
+        for (const auto &[tag, unitSnapshot] : snapshots)
+        {
+            const auto &[unit, snapshot] = unitSnapshot;
+            if (!snapshot->count)
+            {
+                // Preregistered by a thread but not measured yet, a rare path.
+                continue;
+            }
+
+            const auto isTicks = (unit == EHistogramUnit::TICKS);
+            const auto toReported = [isTicks](uint64_t value) { return isTicks ? static_cast<uint64_t>(CTscClock::Instance().TicksToNanos(value)) : value; };
+
+            m_file << timeStr << (isTicks ? " LATENCY " : " PERF ") << tag << " count:" << snapshot->count
+                   << " mean:" << toReported(static_cast<uint64_t>(snapshot->Mean()));
+            for (const auto &[fraction, name] : LATENCY_REPORT_PERCENTILES)
+            {
+                m_file << ' ' << name << ':' << toReported(snapshot->Percentile(fraction));
+            }
+            m_file << " max:" << toReported(snapshot->max) << '\n';
+        }
+        m_file.flush();
+    }
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "Macros.h"
+#include "Metrics.h"
+#include "ThreadUtils.h"
+
+namespace Common
+{
+    /// How often the latency service appends a snapshot of every histogram to its file, one more is written at shutdown.
+    constexpr auto LATENCY_REPORT_INTERVAL = std::chrono::seconds(10);
+
+    /// Percentiles every snapshot reports, besides the count, mean and max.
+    constexpr std::array<std::pair<double, const char *>, 3> LATENCY_REPORT_PERCENTILES = {{{0.5, "p50"}, {0.99, "p99"}, {0.999, "p99.9"}}};
+
+    /// Histograms one thread finds again by tag through CLatencyService::ThreadHistogram(), later ones are handed out afresh on every call.
+    constexpr size_t LATENCY_MAX_THREAD_HISTOGRAMS = 128;
+
+    /// Longest tag, terminator included, ThreadHistogram() finds again.
+    constexpr size_t LATENCY_MAX_TAG_LENGTH = 96;
+
+    /// Process wide owner of the END_MEASURE() histograms, one CLatencyHistogram per tag per thread that measures it.
+    /// A background thread merges the threads' histograms of each tag and appends count / mean / percentiles / max, in nanoseconds,
+    /// to <process name>_<pid>_latency.log every LATENCY_REPORT_INTERVAL and when the process exits.
+    /// EHistogramUnit::COUNT histograms, the hardware counters of a measurement, are reported as is on PERF lines instead of LATENCY ones.
+    /// Started by the first histogram handed out.
+    class CLatencyService final
+    {
+    public:
+        static auto Instance() -> CLatencyService &
+        {
+            static CLatencyService service;
+            return service;
+        }
+
+        /// A new histogram for the calling thread to record tag into, allocated once per thread and tag, outside the measured path.
+        /// It lives in the CMetricsRegistry segment, so stats_reader shows the same histograms live.
+        auto Histogram(const char *tag, EHistogramUnit unit = EHistogramUnit::TICKS) -> CLatencyHistogram *
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_histograms.push_back({tag, unit, CMetricsRegistry::Instance().Histogram(tag, unit)});
+
+            if (!m_pThread)
+            {
+                m_isRunning = true;
+                m_pThread = CreateAndStartThread(-1, "Common/CLatencyService", [this]() { Run(); });
+                ASSERT(m_pThread != nullptr, "Failed to start CLatencyService thread.");
+            }
+
+            return m_histograms.back().pHistogram;
+        }
+
+        /// The calling thread's histogram for tag: created by the first call per thread and tag, found again by later ones without allocating.
+        /// Threads that must not allocate once they run call it for their tags at startup, see PreregisterMeasures() and PreregisterTraceHops().
+        auto ThreadHistogram(const char *tag, EHistogramUnit unit = EHistogramUnit::TICKS) -> CLatencyHistogram *
+        {
+            auto &table = ThreadTable();
+            for (size_t i = 0; i < table.count; ++i)
+            {
+                if (table.entries[i].unit == unit && !strcmp(table.entries[i].tag, tag))
+                {
+                    return table.entries[i].pHistogram;
+                }
+            }
+
+            auto pHistogram = Histogram(tag, unit);
+            if (table.count < LATENCY_MAX_THREAD_HISTOGRAMS && strlen(tag) < LATENCY_MAX_TAG_LENGTH)
+            {
+                auto &entry = table.entries[table.count++];
+                strcpy(entry.tag, tag);
+                entry.unit = unit;
+                entry.pHistogram = pHistogram;
+            }
+
+            return pHistogram;
+        }
+
+        /// Append a snapshot of every histogram to the file now.
+        auto Report() -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ReportLocked();
+        }
+
+        /// The histograms themselves are left allocated: threads still running during static destruction may be recording into them.
+        ~CLatencyService()
+        {
+            if (m_pThread)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_isRunning = false;
+                }
+                m_wakeup.notify_one();
+                m_pThread->join();
+
+                delete m_pThread;
+                m_pThread = nullptr;
+            }
+
+            Report();
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CLatencyService(const CLatencyService &) = delete;
+
+        CLatencyService(const CLatencyService &&) = delete;
+
+        CLatencyService &operator=(const CLatencyService &) = delete;
+
+        CLatencyService &operator=(const CLatencyService &&) = delete;
+
+    private:
+        CLatencyService() = default;
+
+        auto Run() -> void
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_isRunning)
+            {
+                m_wakeup.wait_for(lock, LATENCY_REPORT_INTERVAL, [this]() { return !m_isRunning; });
+                if (m_isRunning)
+                {
+                    ReportLocked();
+                }
+            }
+        }
+
+        auto ReportLocked() -> void;
+
+        /// One thread's histograms by tag, trivially constructible so the table costs no allocation of its own.
+        struct SThreadHistograms
+        {
+            struct SEntry
+            {
+                char               tag[LATENCY_MAX_TAG_LENGTH];
+                EHistogramUnit     unit;
+                CLatencyHistogram *pHistogram;
+            };
+
+            std::array<SEntry, LATENCY_MAX_THREAD_HISTOGRAMS> entries;
+            size_t                                            count;
+        };
+
+        static auto ThreadTable() noexcept -> SThreadHistograms &
+        {
+            static thread_local SThreadHistograms table;
+            return table;
+        }
+
+        struct SHistogram
+        {
+            std::string        tag;
+            EHistogramUnit     unit = EHistogramUnit::TICKS;
+            CLatencyHistogram *pHistogram = nullptr;
+        };
+
+        std::mutex              m_mutex;
+        std::condition_variable m_wakeup;
+        std::vector<SHistogram> m_histograms;
+        std::ofstream           m_file;
+
+        std::thread *m_pThread = nullptr;
+        bool         m_isRunning = false;
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/// Log levels as plain integers, so the build-time floor can be set with -DLOG_COMPILE_LEVEL=LOG_LEVEL_WARN.
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_FATAL 5
+
+/// Log statements below LOG_COMPILE_LEVEL are compiled out, arguments included. Release builds keep INFO and above.
+#if !defined(LOG_COMPILE_LEVEL)
+#if defined(NDEBUG)
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+namespace Common
+{
+    enum class ELogLevel : int8_t
+    {
+        TRACE = LOG_LEVEL_TRACE, /// Every message in and out of a component, order book dumps.
+        DEBUG = LOG_LEVEL_DEBUG, /// Latency measurements and decisions made per message.
+        INFO = LOG_LEVEL_INFO,   /// Start up, shut down and periodic reports.
+        WARN = LOG_LEVEL_WARN,   /// Recoverable problems, gaps, drops, unexpected messages.
+        ERROR = LOG_LEVEL_ERROR, /// Failed system calls and protocol violations.
+        FATAL = LOG_LEVEL_FATAL
+    };
+
+    constexpr auto LOG_COMPILE_FLOOR = static_cast<ELogLevel>(LOG_COMPILE_LEVEL);
+
+    /// How often the logger threads look for a changed <log file>.level control file.
+    constexpr int LOG_LEVEL_CHECK_INTERVAL_MS = 1000;
+
+    inline auto LogLevelToString(ELogLevel level) -> const char *
+    {
+        switch (level)
+        {
+            case ELogLevel::TRACE:
+                return "TRACE";
+            case ELogLevel::DEBUG:
+                return "DEBUG";
+            case ELogLevel::INFO:
+                return "INFO";
+            case ELogLevel::WARN:
+                return "WARN";
+            case ELogLevel::ERROR:
+                return "ERROR";
+            case ELogLevel::FATAL:
+                return "FATAL";
+        }
+
+        return "UNKNOWN";
+    }
+
+    /// Parse a level name, as written to a .level control file. Returns false, leaving level untouched, for anything else.
+    inline auto StringToLogLevel(const std::string &str, ELogLevel &level) -> bool
+    {
+        for (auto candidate : {ELogLevel::TRACE, ELogLevel::DEBUG, ELogLevel::INFO, ELogLevel::WARN, ELogLevel::ERROR, ELogLevel::FATAL})
+        {
+            if (str == LogLevelToString(candidate))
+            {
+                level = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Read the level name in fileName, false if the file does not exist or does not hold a level name.
+    inline auto ReadLogLevelFile(const std::string &fileName, ELogLevel &level) -> bool
+    {
+        std::ifstream file(fileName);
+        std::string str;
+        return (file >> str) && StringToLogLevel(str, level);
+    }
+}
+
+/// Log at a given level. Below LOG_COMPILE_LEVEL the statement is discarded at compile time and its arguments are never evaluated,
+/// it still has to compile so the format is checked in every build. Above it the logger's runtime threshold, one relaxed load, decides.
+/// LOGGER is a logger object, not a pointer.
+#define LOG_AT(LEVEL, LOGGER, FORMAT, ...)                                                          \
+    do                                                                                              \
+    {                                                                                               \
+        if constexpr (Common::ELogLevel::LEVEL >= Common::LOG_COMPILE_FLOOR)                         \
+        {                                                                                           \
+            if ((LOGGER).IsEnabled(Common::ELogLevel::LEVEL))                                       \
+            {                                                                                       \
+                (LOGGER).Log(Common::ELogLevel::LEVEL, LOG_FORMAT(FORMAT) __VA_OPT__(,) __VA_ARGS__); \
+            }                                                                                       \
+        }                                                                                           \
+    } while (false)
+
+#define LOG_TRACE(LOGGER, ...) LOG_AT(TRACE, LOGGER, __VA_ARGS__)
+#define LOG_DEBUG(LOGGER, ...) LOG_AT(DEBUG, LOGGER, __VA_ARGS__)
+#define LOG_INFO(LOGGER, ...) LOG_AT(INFO, LOGGER, __VA_ARGS__)
+#define LOG_WARN(LOGGER, ...) LOG_AT(WARN, LOGGER, __VA_ARGS__)
+#define LOG_ERROR(LOGGER, ...) LOG_AT(ERROR, LOGGER, __VA_ARGS__)
+#define LOG_FATAL(LOGGER, ...) LOG_AT(FATAL, LOGGER, __VA_ARGS__)
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#include "Format.h"
+#include "LogLevel.h"
+#include "Macros.h"
+#include "OptLockFreeQueue.h"
+#include "PerfUtils.h"
+#include "TimeUtils.h"
+
+namespace Common
+{
+    /// A string argument, encoded by copying the characters into the record.
+    struct SLogString
+    {
+        const char *pData = nullptr;
+        uint32_t    length = 0;
+    };
+
+    /// Normalize a Log() argument to one of the encodable types, with the same implicit conversions the per-element PushValue() overloads had.
+    inline auto LogArg(char value) noexcept { return value; }
+    inline auto LogArg(int value) noexcept { return value; }
+    inline auto LogArg(long value) noexcept { return value; }
+    inline auto LogArg(long long value) noexcept { return value; }
+    inline auto LogArg(unsigned value) noexcept { return value; }
+    inline auto LogArg(unsigned long value) noexcept { return value; }
+    inline auto LogArg(unsigned long long value) noexcept { return value; }
+    inline auto LogArg(float value) noexcept { return value; }
+    inline auto LogArg(double value) noexcept { return value; }
+    inline auto LogArg(const char *value) noexcept { return SLogString{value, static_cast<uint32_t>(strlen(value))}; }
+    inline auto LogArg(const std::string &value) noexcept { return SLogString{value.data(), static_cast<uint32_t>(value.size())}; }
+
+    /// How the logger thread renders a struct argument. Left undefined, a type is only logged by value once LOG_BY_VALUE() registers a formatter for it.
+    template <typename V>
+    struct SLogFormatter;
+
+    /// A struct copied into the record as raw bytes, wire messages and the like, so the hot path never builds its string.
+    template <typename V>
+    concept LoggableByValue = std::is_trivially_copyable_v<V> && requires(std::ostream &out, const V &value) { SLogFormatter<V>::Format(out, value); };
+
+    template <LoggableByValue V>
+    inline auto LogArg(const V &value) noexcept -> const V & { return value; }
+
+    /// Types Log() accepts as arguments, anything else is a compile error at the call site.
+    template <typename V>
+    concept Loggable = requires(const V &value) { LogArg(value); };
+
+    template <typename V>
+    constexpr auto EncodedSize(const V &) noexcept -> size_t
+    {
+        return sizeof(V);
+    }
+
+    constexpr auto EncodedSize(const SLogString &value) noexcept -> size_t
+    {
+        return sizeof(value.length) + value.length;
+    }
+
+    /// Sequential reader / writer over the two spans of a (possibly wrapped) run of queue slots holding log records.
+    template <typename TSlots>
+    class CLogCursor final
+    {
+    public:
+        explicit CLogCursor(const TSlots &slots) noexcept : m_slots(slots)
+        {
+        }
+
+        auto Remaining() const noexcept
+        {
+            return m_slots.size() - m_pos;
+        }
+
+        /// Call func(pointer, length) for each contiguous piece of the next count bytes and move past them.
+        template <typename F>
+        auto Visit(size_t count, F &&func) noexcept
+        {
+            if (m_pos < m_slots.first.size())
+            {
+                const auto firstCount = std::min(count, m_slots.first.size() - m_pos);
+                func(m_slots.first.data() + m_pos, firstCount);
+                m_pos += firstCount;
+                count -= firstCount;
+            }
+            if (count)
+            {
+                func(m_slots.second.data() + (m_pos - m_slots.first.size()), count);
+                m_pos += count;
+            }
+        }
+
+        auto Write(const void *pSrc, size_t count) noexcept
+        {
+            auto pBytes = static_cast<const char *>(pSrc);
+            Visit(count, [&pBytes](auto *pDst, size_t n)
+            {
+                memcpy(pDst, pBytes, n);
+                pBytes += n;
+            });
+        }
+
+        auto Read(void *pDst, size_t count) noexcept
+        {
+            auto pBytes = static_cast<char *>(pDst);
+            Visit(count, [&pBytes](const auto *pSrc, size_t n)
+            {
+                memcpy(pBytes, pSrc, n);
+                pBytes += n;
+            });
+        }
+
+        template <typename V>
+        auto WriteArg(const V &value) noexcept
+        {
+            Write(&value, sizeof(value));
+        }
+
+        auto WriteArg(const SLogString &value) noexcept
+        {
+            Write(&value.length, sizeof(value.length));
+            Write(value.pData, value.length);
+        }
+
+    private:
+        TSlots m_slots;
+        size_t m_pos = 0;
+    };
+
+    /// Cursor the logger threads read records with.
+    using CLogReader = CLogCursor<OptCommon::COptLockFreeQueue<char>::SSlots<const char>>;
+
+    /// A piece of literal text of a format, as an offset and a length into the format string. %% escapes are already resolved:
+    /// the text before one ends a chunk with a single %, so the decoder writes every chunk as is.
+    struct SLogChunk
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        /// The next argument is rendered right after this chunk.
+        bool isArgNext = false;
+    };
+
+    /// A format string split into its literal chunks at compile time, the decoder walks the chunks instead of the format.
+    struct SLogFormatInfo
+    {
+        /// The format string itself, for error messages.
+        const char      *format = nullptr;
+        const SLogChunk *pChunks = nullptr;
+        uint32_t         numChunks = 0;
+        uint32_t         numPlaceholders = 0;
+    };
+
+    /// A format string literal as a template argument, so every distinct format gets one SLogFormatInfo with static storage.
+    template <size_t N>
+    struct SLogFormatString
+    {
+        char text[N] = {};
+
+        consteval SLogFormatString(const char (&format)[N])
+        {
+            std::copy_n(format, N, text);
+        }
+    };
+
+    /// Number of chunks ParseLogFormat() splits format into: one per placeholder and per %% escape, plus the trailing one.
+    consteval auto CountLogChunks(const char *format) -> size_t
+    {
+        size_t chunks = 1;
+        for (auto p = format; *p; ++p)
+        {
+            if (*p == '%')
+            {
+                ++chunks;
+                p += (*(p + 1) == '%');
+            }
+        }
+
+        return chunks;
+    }
+
+    /// Every % is a placeholder for the next argument and %% is a literal %.
+    template <size_t NumChunks>
+    consteval auto ParseLogFormat(const char *format) -> std::array<SLogChunk, NumChunks>
+    {
+        std::array<SLogChunk, NumChunks> chunks = {};
+        size_t count = 0;
+        uint32_t begin = 0;
+        uint32_t i = 0;
+        for (; format[i]; ++i)
+        {
+            if (format[i] != '%')
+            {
+                continue;
+            }
+
+            if (format[i + 1] == '%')
+            {
+                chunks[count++] = {begin, i + 1 - begin, false};
+                begin = ++i + 1;
+            }
+            else
+            {
+                chunks[count++] = {begin, i - begin, true};
+                begin = i + 1;
+            }
+        }
+        chunks[count] = {begin, i - begin, false};
+
+        return chunks;
+    }
+
+    template <SLogFormatString F>
+    inline constexpr auto LogFormatChunks = ParseLogFormat<CountLogChunks(F.text)>(F.text);
+
+    template <SLogFormatString F>
+    inline constexpr SLogFormatInfo LogFormatInfo{F.text, LogFormatChunks<F>.data(), static_cast<uint32_t>(LogFormatChunks<F>.size()),
+                                                  static_cast<uint32_t>(std::count_if(LogFormatChunks<F>.begin(), LogFormatChunks<F>.end(),
+                                                                                      [](const auto &chunk) { return chunk.isArgNext; }))};
+
+    /// Renders the arguments of one record into its format, instantiated once per list of argument types.
+    using FLogDecoder = void (*)(std::ostream &out, const SLogFormatInfo &format, CLogReader &reader);
+
+    /// Fixed part of every log record, followed by argBytes of encoded arguments.
+    /// Arguments are stored as their raw bytes with no type tags, decode knows their types. Strings are a uint32_t length and the characters.
+    struct SLogRecordHeader
+    {
+        FLogDecoder decode = nullptr;
+        /// The format's chunks, static storage so the pointer doubles as the format id.
+        const SLogFormatInfo *pFormat = nullptr;
+        uint64_t    tsc = 0;
+        uint32_t    argBytes = 0;
+        ELogLevel   level = ELogLevel::INFO;
+    };
+
+    /// Called from the consteval CLogFormat constructor only when the check fails, a call to a non-constexpr function is what turns it into a compile error.
+    inline void LogFormatHasMorePlaceholdersThanArguments() {}
+    inline void LogFormatHasFewerPlaceholdersThanArguments() {}
+
+    /// A Log() format checked at compile time against the types of the arguments it is called with, the number of placeholders must match the number of arguments.
+    /// Implicitly constructed from LOG_FORMAT("...") at the call site, the parameter pack is deduced from the arguments alone.
+    template <typename... A>
+    class CLogFormat final
+    {
+    public:
+        consteval CLogFormat(const SLogFormatInfo &format) : m_pFormat(&format)
+        {
+            if (format.numPlaceholders > sizeof...(A))
+            {
+                LogFormatHasMorePlaceholdersThanArguments();
+            }
+            if (format.numPlaceholders < sizeof...(A))
+            {
+                LogFormatHasFewerPlaceholdersThanArguments();
+            }
+        }
+
+        constexpr auto Get() const noexcept
+        {
+            return m_pFormat;
+        }
+
+    private:
+        const SLogFormatInfo *m_pFormat;
+    };
+
+    /// Write the literal chunks up to the next placeholder, or the end of the format, and move pChunk past them.
+    inline auto WriteLogLiteral(std::ostream &out, const SLogFormatInfo &format, const SLogChunk *&pChunk) noexcept
+    {
+        const auto pEnd = format.pChunks + format.numChunks;
+        for (; pChunk != pEnd; ++pChunk)
+        {
+            out.write(format.format + pChunk->offset, pChunk->length);
+            if (pChunk->isArgNext)
+            {
+                ++pChunk;
+                return;
+            }
+        }
+    }
+
+    template <typename V>
+    inline auto ReadLogArg(std::ostream &out, CLogReader &reader) noexcept
+    {
+        if constexpr (std::is_same_v<V, SLogString>)
+        {
+            uint32_t length;
+            reader.Read(&length, sizeof(length));
+            reader.Visit(length, [&out](const char *pData, size_t n) { out.write(pData, n); });
+        }
+        else if constexpr (LoggableByValue<V>)
+        {
+            // The copy in the record may not be aligned, and V need not be default constructible.
+            std::array<char, sizeof(V)> bytes;
+            reader.Read(bytes.data(), bytes.size());
+            SLogFormatter<V>::Format(out, std::bit_cast<V>(bytes));
+        }
+        else
+        {
+            V value;
+            reader.Read(&value, sizeof(value));
+            CInlineFormatBuffer<32> text;
+            text << value;
+            out.write(text.View().data(), text.size());
+        }
+    }
+
+    /// One literal chunk and one argument per type in V, then the trailing literal. The format was checked to have exactly one placeholder per argument.
+    template <typename... V>
+    inline void DecodeLogRecord(std::ostream &out, const SLogFormatInfo &format, CLogReader &reader)
+    {
+        auto pChunk = format.pChunks;
+        ((WriteLogLiteral(out, format, pChunk), ReadLogArg<V>(out, reader)), ...);
+        WriteLogLiteral(out, format, pChunk);
+    }
+
+    /// Reserve, encode and commit one record: the header and every argument, published to the consumer with a single index update.
+    /// A record that does not fit the queue, which can only happen with EQueueFullPolicy::DROP, is dropped whole.
+    template <typename TQueue, typename... V>
+    inline auto PushLogRecord(TQueue &queue, ELogLevel level, const SLogFormatInfo *pFormat, const V &...values) noexcept
+    {
+        const SLogRecordHeader header{&DecodeLogRecord<V...>, pFormat, rdtsc(), static_cast<uint32_t>((EncodedSize(values) + ... + 0)), level};
+        const auto recordBytes = sizeof(header) + header.argBytes;
+        ASSERT(recordBytes <= queue.capacity(), "Log record of " + std::to_string(recordBytes) + " bytes does not fit in the log queue, format:" + pFormat->format);
+
+        const auto slots = queue.ReserveWrite(recordBytes);
+        if (UNLIKELY(slots.size() < recordBytes))
+        {
+            return;
+        }
+
+        CLogCursor cursor(slots);
+        cursor.Write(&header, sizeof(header));
+        (cursor.WriteArg(values), ...);
+        queue.CommitWrite(recordBytes);
+    }
+
+    /// Render records from the run of slots to out, each one prefixed with the wall clock time of its TSC timestamp and its level,
+    /// stopping at the first record boundary at or past maxBytes. Returns the bytes consumed, always a whole number of records.
+    inline auto FormatLogRecords(std::ostream &out, const OptCommon::COptLockFreeQueue<char>::SSlots<const char> &slots, CTscTimeFormatter &timeFormatter,
+                                 size_t maxBytes = SIZE_MAX) -> size_t
+    {
+        CLogReader reader(slots);
+        while (reader.Remaining() && slots.size() - reader.Remaining() < maxBytes)
+        {
+            SLogRecordHeader header;
+            reader.Read(&header, sizeof(header));
+
+            const auto timeStr = timeFormatter.Format(header.tsc);
+            out.write(timeStr.data(), timeStr.size());
+            out << ' ' << std::left << std::setw(5) << LogLevelToString(header.level) << ' ';
+
+            DEBUG_ASSERT(header.argBytes <= reader.Remaining(), std::string("Truncated log record, format:") + header.pFormat->format);
+            header.decode(out, *header.pFormat, reader);
+        }
+
+        return slots.size() - reader.Remaining();
+    }
+}
+
+/// Register TYPE, a trivially copyable struct with a Format(CFormatBuffer &), to be logged by value: Log() copies its bytes into the record and the logger thread
+/// formats that copy on its stack. Only for types whose Format() reads nothing but their own members, it runs later and on another thread.
+/// Use at global scope, after the definition of TYPE.
+#define LOG_BY_VALUE(TYPE)                                                  \
+    template <>                                                             \
+    struct Common::SLogFormatter<TYPE>                                      \
+    {                                                                       \
+        static auto Format(std::ostream &out, const TYPE &value) -> void    \
+        {                                                                   \
+            Common::CInlineFormatBuffer<Common::FORMAT_INLINE_SIZE> text;   \
+            value.Format(text);                                             \
+            out.write(text.View().data(), text.size());                     \
+        }                                                                   \
+    }
+
+/// The compile time checked, pre-split format Log() takes, FORMAT is a string literal. LOG_TRACE() .. LOG_FATAL() wrap their format in it.
+#define LOG_FORMAT(FORMAT) Common::LogFormatInfo<Common::SLogFormatString(FORMAT)>
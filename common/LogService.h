@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Macros.h"
+#include "ThreadUtils.h"
+#include "WaitStrategy.h"
+
+namespace Common
+{
+    /// The housekeeping core the logging service thread is pinned to, away from the cores the critical threads are given.
+    /// If the process is not allowed to run there the thread is left unpinned.
+    constexpr int LOG_SERVICE_CORE = 0;
+
+    /// Most bytes of records one logger formats per turn, so a logger with a deep backlog cannot starve the others.
+    constexpr size_t LOG_DRAIN_BATCH_BYTES = 1024 * 1024;
+
+    /// Process wide background thread that drains every CLogger queue into its file.
+    /// Each logger keeps its own SPSC queue, only the consumer side is shared: the thread visits the registered loggers round-robin,
+    /// formatting at most LOG_DRAIN_BATCH_BYTES from each per turn, and backs off once none of them had anything queued.
+    /// Started by the first logger that registers.
+    class CLogService final
+    {
+    public:
+        static auto Instance() -> CLogService &
+        {
+            static CLogService service;
+            return service;
+        }
+
+        /// drain is run on the service thread and returns whether the logger had any records queued.
+        auto Register(const void *pLogger, std::function<bool()> drain) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_loggers.push_back({pLogger, std::move(drain)});
+
+            if (!m_pThread)
+            {
+                m_isRunning = true;
+                m_pThread = CreateAndStartThread(LOG_SERVICE_CORE, "Common/CLogService", [this]() { Run(); });
+                if (!m_pThread)
+                {
+                    m_pThread = CreateAndStartThread(-1, "Common/CLogService", [this]() { Run(); });
+                }
+                ASSERT(m_pThread != nullptr, "Failed to start CLogService thread.");
+            }
+        }
+
+        /// Once this returns the service thread is not, and will not be, running the logger's drain.
+        auto Unregister(const void *pLogger) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::erase_if(m_loggers, [pLogger](const auto &logger) { return logger.pLogger == pLogger; });
+        }
+
+        auto Wake() noexcept
+        {
+            m_waitStrategy.Unpark();
+        }
+
+        ~CLogService()
+        {
+            if (m_pThread)
+            {
+                m_isRunning = false;
+                Wake();
+                m_pThread->join();
+
+                delete m_pThread;
+                m_pThread = nullptr;
+            }
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CLogService(const CLogService &) = delete;
+
+        CLogService(const CLogService &&) = delete;
+
+        CLogService &operator=(const CLogService &) = delete;
+
+        CLogService &operator=(const CLogService &&) = delete;
+
+    private:
+        CLogService() = default;
+
+        auto Run() noexcept -> void
+        {
+            while (m_isRunning)
+            {
+                bool didWork = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    for (const auto &logger : m_loggers)
+                    {
+                        didWork |= logger.drain();
+                    }
+                }
+
+                m_waitStrategy.OnPoll(didWork);
+            }
+        }
+
+        struct SLogger
+        {
+            const void           *pLogger = nullptr;
+            std::function<bool()> drain;
+        };
+
+        std::mutex           m_mutex;
+        std::vector<SLogger> m_loggers;
+
+        std::thread      *m_pThread = nullptr;
+        std::atomic<bool> m_isRunning = {false};
+
+        CWaitStrategy m_waitStrategy{EWaitStrategy::PARK};
+    };
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "HugePages.h"
+#include "Macros.h"
+#include "TimeUtils.h"
+
+namespace Common
+{
+    /// The log writer formats into LOG_WRITE_BUFFER_COUNT page aligned buffers of LOG_WRITE_BUFFER_SIZE bytes and hands all the full ones to one writev().
+    constexpr size_t LOG_WRITE_BUFFER_SIZE = 1024 * 1024;
+    constexpr size_t LOG_WRITE_BUFFER_COUNT = 8;
+
+    /// Log files are rotated once they reach LOG_ROTATE_BYTES or have been open for LOG_ROTATE_NANOS, whichever comes first.
+    constexpr size_t LOG_ROTATE_BYTES = 1024 * 1024 * 1024;
+    constexpr Nanos  LOG_ROTATE_NANOS = 24 * 60 * 60 * NANOS_TO_SECS;
+
+    /// Disk blocks are reserved with fallocate() this far ahead of the write offset, so writes never wait on block allocation.
+    constexpr size_t LOG_PREALLOCATE_BYTES = 64 * 1024 * 1024;
+
+    struct SLogWriterStats
+    {
+        size_t bytesWritten = 0;
+        size_t writeCalls = 0;
+        size_t maxWriteBytes = 0;
+        size_t rotations = 0;
+        size_t errors = 0;
+
+        auto ToString() const
+        {
+            std::stringstream ss;
+            ss << "SLogWriterStats"
+               << " ["
+               << " written:" << bytesWritten
+               << " writes:" << writeCalls
+               << " max-write:" << maxWriteBytes
+               << " rotations:" << rotations
+               << " errors:" << errors
+               << "]";
+            return ss.str();
+        }
+    };
+
+    /// Stream buffer the logger threads format into, in place of std::ofstream.
+    /// Nothing reaches the file until Flush(), which writes every filled buffer with a single writev(), or until all the buffers are full.
+    /// The logger thread flushes when its queue runs dry and only rotates between batches, so a record never straddles two files.
+    /// The file is opened for appending, a restart carries on after the records of the previous run.
+    /// Rotated files are renamed to the first of <fileName>.1, <fileName>.2, ... that does not exist yet, so numbering carries on across restarts too.
+    class CLogFileWriter final : public std::streambuf
+    {
+    public:
+        explicit CLogFileWriter(const std::string &fileName, size_t rotateBytes = LOG_ROTATE_BYTES, Nanos rotateNanos = LOG_ROTATE_NANOS)
+            : m_fileName(fileName), m_rotateBytes(rotateBytes), m_rotateNanos(rotateNanos)
+        {
+            for (auto &pBuffer : m_buffers)
+            {
+                pBuffer = static_cast<char *>(std::aligned_alloc(SMALL_PAGE_SIZE, LOG_WRITE_BUFFER_SIZE));
+                ASSERT(pBuffer != nullptr, "Could not allocate log write buffer for:" + fileName);
+            }
+            setp(m_buffers[0], m_buffers[0] + LOG_WRITE_BUFFER_SIZE);
+
+            Open();
+        }
+
+        ~CLogFileWriter()
+        {
+            Flush();
+            Close();
+
+            for (auto pBuffer : m_buffers)
+            {
+                std::free(pBuffer);
+            }
+        }
+
+        /// Write out everything formatted so far.
+        auto Flush() noexcept -> void
+        {
+            iovec iov[LOG_WRITE_BUFFER_COUNT];
+            size_t count = 0;
+            for (size_t i = 0; i < m_fullBuffers; ++i)
+            {
+                iov[count++] = {m_buffers[i], LOG_WRITE_BUFFER_SIZE};
+            }
+            if (pptr() != pbase())
+            {
+                iov[count++] = {pbase(), static_cast<size_t>(pptr() - pbase())};
+            }
+
+            WriteAll(iov, count);
+
+            m_fullBuffers = 0;
+            setp(m_buffers[0], m_buffers[0] + LOG_WRITE_BUFFER_SIZE);
+        }
+
+        /// Start a new file if this one is over the size or age limit. Flushes first, call between records only.
+        auto RotateIfDue() noexcept -> void
+        {
+            if (m_fileOffset + PendingBytes() < m_rotateBytes && GetCurrentNanos() - m_openNanos < m_rotateNanos)
+            {
+                return;
+            }
+
+            Flush();
+            Close();
+            ++m_stats.rotations;
+            std::rename(m_fileName.c_str(), NextRotatedFileName().c_str());
+            Open();
+        }
+
+        auto Stats() const noexcept
+        {
+            return m_stats;
+        }
+
+        /// Deleted default, copy & move constructors and assignment-operators.
+        CLogFileWriter() = delete;
+
+        CLogFileWriter(const CLogFileWriter &) = delete;
+
+        CLogFileWriter(const CLogFileWriter &&) = delete;
+
+        CLogFileWriter &operator=(const CLogFileWriter &) = delete;
+
+        CLogFileWriter &operator=(const CLogFileWriter &&) = delete;
+
+    protected:
+        /// The current buffer is full, move on to the next one, writing them all out first if there is none left.
+        auto overflow(int_type c) -> int_type override
+        {
+            NextBuffer();
+            if (c != traits_type::eof())
+            {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+
+            return traits_type::not_eof(c);
+        }
+
+        auto xsputn(const char *s, std::streamsize n) -> std::streamsize override
+        {
+            auto remaining = static_cast<size_t>(n);
+            while (remaining)
+            {
+                if (pptr() == epptr())
+                {
+                    NextBuffer();
+                }
+
+                const auto count = std::min(remaining, static_cast<size_t>(epptr() - pptr()));
+                memcpy(pptr(), s, count);
+                pbump(static_cast<int>(count));
+                s += count;
+                remaining -= count;
+            }
+
+            return n;
+        }
+
+        auto sync() -> int override
+        {
+            Flush();
+            return 0;
+        }
+
+    private:
+        auto PendingBytes() const noexcept -> size_t
+        {
+            return m_fullBuffers * LOG_WRITE_BUFFER_SIZE + static_cast<size_t>(pptr() - pbase());
+        }
+
+        auto NextBuffer() noexcept -> void
+        {
+            if (m_fullBuffers + 1 == LOG_WRITE_BUFFER_COUNT)
+            {
+                Flush();
+                return;
+            }
+            ++m_fullBuffers;
+            setp(m_buffers[m_fullBuffers], m_buffers[m_fullBuffers] + LOG_WRITE_BUFFER_SIZE);
+        }
+
+        /// Bytes already in the file count towards the size limit, the age limit starts now.
+        auto Open() -> void
+        {
+            m_fd = open(m_fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            ASSERT(m_fd >= 0, "Could not open log file:" + m_fileName + " error:" + std::string(std::strerror(errno)));
+
+            struct stat fileStat;
+            m_fileOffset = (fstat(m_fd, &fileStat) == 0 ? static_cast<size_t>(fileStat.st_size) : 0);
+            m_allocatedBytes = m_fileOffset;
+            m_openNanos = GetCurrentNanos();
+            Preallocate();
+        }
+
+        /// First free <fileName>.N, searched from the last one this writer used, rotations are rare enough for a stat() per taken name.
+        auto NextRotatedFileName() -> std::string
+        {
+            auto rotatedFileName = m_fileName + "." + std::to_string(m_nextSuffix);
+            while (access(rotatedFileName.c_str(), F_OK) == 0)
+            {
+                rotatedFileName = m_fileName + "." + std::to_string(++m_nextSuffix);
+            }
+
+            return rotatedFileName;
+        }
+
+        /// Trim the blocks reserved past the end of what was written and close the file.
+        auto Close() noexcept -> void
+        {
+            if (ftruncate(m_fd, static_cast<off_t>(m_fileOffset)) != 0)
+            {
+                ++m_stats.errors;
+            }
+            close(m_fd);
+            m_fd = -1;
+        }
+
+        /// FALLOC_FL_KEEP_SIZE reserves the blocks without moving end of file, readers never see zeroes past the last record.
+        auto Preallocate() noexcept -> void
+        {
+            if (m_fileOffset + LOG_PREALLOCATE_BYTES / 2 < m_allocatedBytes)
+            {
+                return;
+            }
+
+            const auto bytes = m_fileOffset + LOG_PREALLOCATE_BYTES - m_allocatedBytes;
+            if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_allocatedBytes), static_cast<off_t>(bytes)) == 0)
+            {
+                m_allocatedBytes += bytes;
+            }
+            else
+            {
+                // Not supported by every file system, carry on without it.
+                m_allocatedBytes = SIZE_MAX / 2;
+            }
+        }
+
+        /// writev() until every byte is written, a failed write is counted and its data dropped, logging must never stop the process.
+        auto WriteAll(iovec *iov, size_t count) noexcept -> void
+        {
+            size_t total = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                total += iov[i].iov_len;
+            }
+            if (!total)
+            {
+                return;
+            }
+
+            m_stats.maxWriteBytes = std::max(m_stats.maxWriteBytes, total);
+            while (count)
+            {
+                const auto n = writev(m_fd, iov, static_cast<int>(count));
+                ++m_stats.writeCalls;
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    ++m_stats.errors;
+                    return;
+                }
+
+                m_fileOffset += n;
+                m_stats.bytesWritten += n;
+
+                // Skip past what was written, a short write leaves us part way into an iovec.
+                auto written = static_cast<size_t>(n);
+                while (count && written >= iov->iov_len)
+                {
+                    written -= iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+                if (count)
+                {
+                    iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+                    iov->iov_len -= written;
+                }
+            }
+
+            Preallocate();
+        }
+
+        const std::string m_fileName;
+        const size_t      m_rotateBytes;
+        const Nanos       m_rotateNanos;
+
+        int    m_fd = -1;
+        size_t m_fileOffset = 0;
+        size_t m_allocatedBytes = 0;
+        Nanos  m_openNanos = 0;
+        size_t m_nextSuffix = 1;
+
+        /// m_buffers[0, m_fullBuffers) are full, m_buffers[m_fullBuffers] is the put area.
+        char  *m_buffers[LOG_WRITE_BUFFER_COUNT] = {};
+        size_t m_fullBuffers = 0;
+
+        SLogWriterStats m_stats;
+    };
+}
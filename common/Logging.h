@@ -1,112 +1,66 @@
 #pragma once
 
 #include <string>
-#include <fstream>
+#include <ostream>
 #include <cstdio>
 
+#include "LogRecord.h"
+#include "LogService.h"
+#include "LogWriter.h"
 #include "Macros.h"
-#include "LockFreeQueue.h"
-#include "ThreadUtils.h"
+#include "OptLockFreeQueue.h"
 #include "TimeUtils.h"
 
 namespace Common
 {
-    /// Maximum size of the lock free queue of data to be logged.
-    constexpr size_t LOG_QUEUE_SIZE = 8 * 1024 * 1024;
-
-    /// Type of SLogElement message.
-    enum class ELogType : int8_t
-    {
-        CHAR = 0,
-        INTEGER = 1,
-        LONG_INTEGER = 2,
-        LONG_LONG_INTEGER = 3,
-        UNSIGNED_INTEGER = 4,
-        UNSIGNED_LONG_INTEGER = 5,
-        UNSIGNED_LONG_LONG_INTEGER = 6,
-        FLOAT = 7,
-        DOUBLE = 8
-    };
-
-    /// Represents a single and primitive log entry.
-    struct SLogElement
-    {
-        ELogType type = ELogType::CHAR;
-        union
-        {
-            char c;
-            int i;
-            long l;
-            long long ll;
-            unsigned u;
-            unsigned long ul;
-            unsigned long long ull;
-            float f;
-            double d;
-        } u_;
-    };
+    /// Size in bytes of the lock free queue of log records.
+    constexpr size_t LOG_QUEUE_SIZE = 64 * 1024 * 1024;
 
     class CLogger final
     {
     public:
-        /// Consumes from the lock free queue of log entries and writes to the output log file.
-        auto FlushQueue() noexcept
+        /// One turn of the CLogService thread: format up to LOG_DRAIN_BATCH_BYTES of queued records and hand the bytes back to the producer
+        /// with a single index update. The write buffers only go to disk when they fill up or the queue runs dry. Returns whether anything was queued.
+        auto Drain() noexcept -> bool
         {
-            while (m_isRrunning)
+            const auto bytes = m_queue.PeekRead(LOG_QUEUE_SIZE);
+            if (bytes.size())
+            {
+                m_queue.ReleaseRead(FormatLogRecords(m_file, bytes, m_timeFormatter, LOG_DRAIN_BATCH_BYTES));
+            }
+            else
             {
-                for (auto next = m_queue.GetNextToRead(); m_queue.size() && next; next = m_queue.GetNextToRead())
-                {
-                    switch (next->type)
-                    {
-                        case ELogType::CHAR:
-                            m_file << next->u_.c;
-                            break;
-                        case ELogType::INTEGER:
-                            m_file << next->u_.i;
-                            break;
-                        case ELogType::LONG_INTEGER:
-                            m_file << next->u_.l;
-                            break;
-                        case ELogType::LONG_LONG_INTEGER:
-                            m_file << next->u_.ll;
-                            break;
-                        case ELogType::UNSIGNED_INTEGER:
-                            m_file << next->u_.u;
-                            break;
-                        case ELogType::UNSIGNED_LONG_INTEGER:
-                            m_file << next->u_.ul;
-                            break;
-                        case ELogType::UNSIGNED_LONG_LONG_INTEGER:
-                            m_file << next->u_.ull;
-                            break;
-                        case ELogType::FLOAT:
-                            m_file << next->u_.f;
-                            break;
-                        case ELogType::DOUBLE:
-                            m_file << next->u_.d;
-                            break;
-                    }
-                    m_queue.UpdateReadIndex();
-                }
-                m_file.flush();
+                m_writer.Flush();
+            }
+            m_writer.RotateIfDue();
 
-                using namespace std::literals::chrono_literals;
-                std::this_thread::sleep_for(10ms);
+            if (GetCurrentNanos() >= m_nextLevelCheck)
+            {
+                CheckLevelFile();
+                m_nextLevelCheck = GetCurrentNanos() + LOG_LEVEL_CHECK_INTERVAL_MS * NANOS_TO_MILLIS;
             }
+
+            return bytes.size() != 0;
         }
 
-        explicit CLogger(const std::string &fileName)
-            : m_fileName(fileName), m_queue(LOG_QUEUE_SIZE)
+        /// Pick up a level written to <log file>.level, so the threshold can be changed without a restart, e.g. echo WARN > exchange_main.log.level
+        auto CheckLevelFile() noexcept -> void
         {
-            m_file.open(fileName);
-            ASSERT(m_file.is_open(), "Could not open log file:" + fileName);
+            auto level = Level();
+            if (ReadLogLevelFile(m_fileName + ".level", level) && level != Level())
+            {
+                m_file << m_timeFormatter.Format(rdtsc()) << " Log level changed from " << LogLevelToString(Level()) << " to " << LogLevelToString(level) << '\n';
+                SetLevel(level);
+            }
+        }
 
-            m_pLoggerThread = CreateAndStartThread(-1, "Common/CLogger " + m_fileName, [this]()
-            { 
-                FlushQueue();
-            });
+        explicit CLogger(const std::string &fileName)
+            : m_fileName(fileName), m_writer(fileName), m_file(&m_writer), m_queue(LOG_QUEUE_SIZE, "log:" + fileName)
+        {
+            // Calibrate the TSC clock now, not when the first record is formatted.
+            CTscClock::Instance();
 
-            ASSERT(m_pLoggerThread != nullptr, "Failed to start CLogger thread.");
+            CLogService::Instance().Register(this, [this]() { return Drain(); });
         }
 
         ~CLogger()
@@ -114,128 +68,63 @@ namespace Common
             std::string time_str;
             std::cerr << Common::GetCurrentTimeStr(&time_str) << " Flushing and closing CLogger for " << m_fileName << std::endl;
 
+            CLogService::Instance().Wake();
             while (m_queue.size())
             {
                 using namespace std::literals::chrono_literals;
                 std::this_thread::sleep_for(1s);
             }
-            m_isRrunning = false;
-            m_pLoggerThread->join();
+            CLogService::Instance().Unregister(this);
 
-            m_file.close();
+            m_writer.Flush();
             std::cerr << Common::GetCurrentTimeStr(&time_str) << " CLogger for " << m_fileName << " exiting." << std::endl;
         }
 
-        /// Overloaded methods to write different log entry types to the lock free queue.
-        /// Creates a SLogElement of the correct type and writes it to the lock free queue.
-        auto PushValue(const SLogElement &logElement) noexcept
-        {
-            *(m_queue.GetNextToWriteTo()) = logElement;
-            m_queue.UpdateWriteIndex();
-        }
-
-        auto PushValue(const char value) noexcept
-        {
-            PushValue(SLogElement{ELogType::CHAR, {.c = value}});
-        }
-
-        auto PushValue(const int value) noexcept
-        {
-            PushValue(SLogElement{ELogType::INTEGER, {.i = value}});
-        }
-
-        auto PushValue(const long value) noexcept
-        {
-            PushValue(SLogElement{ELogType::LONG_INTEGER, {.l = value}});
-        }
-
-        auto PushValue(const long long value) noexcept
-        {
-            PushValue(SLogElement{ELogType::LONG_LONG_INTEGER, {.ll = value}});
-        }
-
-        auto PushValue(const unsigned value) noexcept
-        {
-            PushValue(SLogElement{ELogType::UNSIGNED_INTEGER, {.u = value}});
-        }
-
-        auto PushValue(const unsigned long value) noexcept
-        {
-            PushValue(SLogElement{ELogType::UNSIGNED_LONG_INTEGER, {.ul = value}});
-        }
-
-        auto PushValue(const unsigned long long value) noexcept
+        /// Write one record, the address of the decoder for the argument types, the address of the format's compile time split chunks, the level,
+        /// an rdtsc() timestamp and the raw bytes of the arguments, to the lock free queue. The format is checked at compile time, one % per argument.
+        /// Pass the format as LOG_FORMAT("..."), the decoder then never has to scan it for placeholders.
+        /// All the formatting, including turning the timestamp into wall clock time, happens on the CLogService thread.
+        /// Call it through the LOG_TRACE() .. LOG_FATAL() macros, which check the level first.
+        template <typename... A>
+            requires((Loggable<A> && ...))
+        auto Log(ELogLevel level, CLogFormat<std::type_identity_t<A>...> format, const A &...args) noexcept
         {
-            PushValue(SLogElement{ELogType::UNSIGNED_LONG_LONG_INTEGER, {.ull = value}});
+            PushLogRecord(m_queue, level, format.Get(), LogArg(args)...);
         }
 
-        auto PushValue(const float value) noexcept
+        /// Unconditional INFO record.
+        template <typename... A>
+            requires((Loggable<A> && ...))
+        auto Log(CLogFormat<std::type_identity_t<A>...> format, const A &...args) noexcept
         {
-            PushValue(SLogElement{ELogType::FLOAT, {.f = value}});
+            PushLogRecord(m_queue, ELogLevel::INFO, format.Get(), LogArg(args)...);
         }
 
-        auto PushValue(const double value) noexcept
+        auto IsEnabled(ELogLevel level) const noexcept
         {
-            PushValue(SLogElement{ELogType::DOUBLE, {.d = value}});
+            return level >= m_level.load(std::memory_order_relaxed);
         }
 
-        auto PushValue(const char* pValue) noexcept
+        auto Level() const noexcept -> ELogLevel
         {
-            while (*pValue)
-            {
-                PushValue(*pValue);
-                ++pValue;
-            }
+            return m_level.load(std::memory_order_relaxed);
         }
 
-        auto PushValue(const std::string &value) noexcept
+        /// Runtime threshold, records below it are not written. Levels below LOG_COMPILE_LEVEL are compiled out whatever this is set to.
+        auto SetLevel(ELogLevel level) noexcept -> void
         {
-            PushValue(value.c_str());
+            m_level.store(level, std::memory_order_relaxed);
         }
 
-        /// Parse the format string, substitute % with the variable number of arguments passed and write the string to the lock free queue.
-        template <typename T, typename... A>
-        auto Log(const char* szBuffer, const T &value, A... args) noexcept
+        auto QueueStats() const noexcept
         {
-            while (*szBuffer)
-            {
-                if (*szBuffer == '%')
-                {
-                    if (UNLIKELY(*(szBuffer + 1) == '%'))
-                    { // to allow %% -> % escape character.
-                        ++szBuffer;
-                    }
-                    else
-                    {
-                        PushValue(value);    // substitute % with the value specified in the arguments.
-                        Log(szBuffer + 1, args...); // pop an argument and call self recursively.
-                        return;
-                    }
-                }
-                PushValue(*szBuffer++);
-            }
-            FATAL("extra arguments provided to log()");
+            return m_queue.Stats();
         }
 
-        /// Overload for case where no substitution in the string is necessary.
-        /// Note that this is overloading not specialization. gcc does not allow inline specializations.
-        auto Log(const char *szBuffer) noexcept
+        /// Only consistent once the logger is idle, the CLogService thread updates it without synchronization.
+        auto WriterStats() const noexcept
         {
-            while (*szBuffer)
-            {
-                if (*szBuffer == '%')
-                {
-                    if (UNLIKELY(*(szBuffer + 1) == '%'))
-                    { // to allow %% -> % escape character.
-                        ++szBuffer;
-                    }
-                    else
-                    {
-                        FATAL("missing arguments to log()");
-                    }
-                }
-                PushValue(*szBuffer++);
-            }
+            return m_writer.Stats();
         }
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -252,13 +141,19 @@ namespace Common
     private:
         /// File to which the log entries will be written.
         const std::string m_fileName;
-        std::ofstream     m_file;
+        CLogFileWriter    m_writer;
+        std::ostream      m_file;
+
+        /// Lock free queue of log records from main logging thread to the CLogService thread, which formats them and writes them to disk.
+        OptCommon::COptLockFreeQueue<char> m_queue;
+
+        /// Everything compiled in is logged until a .level file or SetLevel() says otherwise.
+        std::atomic<ELogLevel> m_level = {LOG_COMPILE_FLOOR};
 
-        /// Lock free queue of log elements from main logging thread to background formatting and disk writer thread.
-        CLockFreeQueue<SLogElement> m_queue;
-        std::atomic<bool>           m_isRrunning = {true};
+        /// Owned by the CLogService thread, renders the TSC timestamp every record is stamped with.
+        CTscTimeFormatter m_timeFormatter;
 
-        /// Background logging thread.
-        std::thread* m_pLoggerThread = nullptr;
+        /// When Drain() next looks for a .level file.
+        Nanos m_nextLevelCheck = 0;
     };
 }
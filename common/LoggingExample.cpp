@@ -14,10 +14,10 @@ int main(int, char **)
 
     CLogger logger("logging_example.log");
 
-    logger.Log("Logging a char:% an int:% and an unsigned:%\n", c, i, ul);
-    logger.Log("Logging a float:% and a double:%\n", f, d);
-    logger.Log("Logging a C-string:'%'\n", s);
-    logger.Log("Logging a string:'%'\n", ss);
+    logger.Log(LOG_FORMAT("Logging a char:% an int:% and an unsigned:%\n"), c, i, ul);
+    logger.Log(LOG_FORMAT("Logging a float:% and a double:%\n"), f, d);
+    logger.Log(LOG_FORMAT("Logging a C-string:'%'\n"), s);
+    logger.Log(LOG_FORMAT("Logging a string:'%'\n"), ss);
 
     return 0;
 }
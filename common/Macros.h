@@ -1,26 +1,77 @@
 #pragma once
 
 #include <cstring>
+#include <string>
 #include <iostream>
 
 /// Branch prediction hints.
 #define LIKELY(x) __builtin_expect(!!(x), 1)
 #define UNLIKELY(x) __builtin_expect(!!(x), 0)
 
-/// Check condition and exit if not true.
-inline auto ASSERT(bool cond, const std::string &msg) noexcept
-{
-    if (UNLIKELY(!cond))
-    {
-        std::cerr << "ASSERT : " << msg << std::endl;
+/// Size of a cache line, used to keep data written by different threads on separate lines.
+constexpr size_t CACHE_LINE_SIZE = 64;
 
-        exit(EXIT_FAILURE);
-    }
-}
+/// Contract check levels. A check is compiled out, condition and message included, when its level is above CONTRACT_CHECK_LEVEL.
+/// ALWAYS checks guard against bad input and broken invariants that must stop the process in any build,
+/// DEBUG checks guard hot path invariants of our own code, PARANOID checks are too expensive or too unlikely to fail to run by default.
+#define CONTRACT_LEVEL_ALWAYS 0
+#define CONTRACT_LEVEL_DEBUG 1
+#define CONTRACT_LEVEL_PARANOID 2
 
-inline auto FATAL(const std::string &msg) noexcept
+#if !defined(CONTRACT_CHECK_LEVEL)
+#if defined(NDEBUG)
+#define CONTRACT_CHECK_LEVEL CONTRACT_LEVEL_ALWAYS
+#else
+#define CONTRACT_CHECK_LEVEL CONTRACT_LEVEL_DEBUG
+#endif
+#endif
+
+/// Called by ContractFailed() after the report and before exiting, CFlightRecorderRegistry dumps the flight recorders from it.
+inline void (*pContractFailedHook)() noexcept = nullptr;
+
+/// Report a failed check and exit. Out of line and cold so the checks leave only a compare and a not-taken branch on the hot path.
+[[noreturn]] __attribute__((cold, noinline)) inline void ContractFailed(const char *kind, const char *file, int line, const std::string &msg) noexcept
 {
-    std::cerr << "FATAL : " << msg << std::endl;
+    std::cerr << kind << " : " << file << ":" << line << " " << msg << std::endl;
+
+    if (pContractFailedHook)
+    {
+        pContractFailedHook();
+    }
 
     exit(EXIT_FAILURE);
 }
+
+/// Check condition and exit if not true. msg is only evaluated when the check fails, so it is free to build a string.
+#define CONTRACT_CHECK(cond, msg)                                           \
+    do                                                                      \
+    {                                                                       \
+        if (UNLIKELY(!(cond)))                                              \
+        {                                                                   \
+            ContractFailed("ASSERT", __FILE__, __LINE__, (msg));            \
+        }                                                                   \
+    } while (false)
+
+/// Compiled out check, the condition is kept in an unevaluated context so it still has to compile and its variables count as used.
+#define CONTRACT_IGNORE(cond, msg)                                          \
+    do                                                                      \
+    {                                                                       \
+        (void)sizeof(!(cond));                                              \
+    } while (false)
+
+#define ASSERT(cond, msg) CONTRACT_CHECK(cond, msg)
+
+#if CONTRACT_CHECK_LEVEL >= CONTRACT_LEVEL_DEBUG
+#define DEBUG_ASSERT(cond, msg) CONTRACT_CHECK(cond, msg)
+#else
+#define DEBUG_ASSERT(cond, msg) CONTRACT_IGNORE(cond, msg)
+#endif
+
+#if CONTRACT_CHECK_LEVEL >= CONTRACT_LEVEL_PARANOID
+#define PARANOID_ASSERT(cond, msg) CONTRACT_CHECK(cond, msg)
+#else
+#define PARANOID_ASSERT(cond, msg) CONTRACT_IGNORE(cond, msg)
+#endif
+
+/// Unconditional failure.
+#define FATAL(msg) ContractFailed("FATAL", __FILE__, __LINE__, (msg))
@@ -1,46 +1,90 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <string>
 
+#include "HugePages.h"
 #include "Macros.h"
+#include "Metrics.h"
 
 namespace Common
 {
+    /// Fixed size pool of T objects with constant time Allocate() / Deallocate().
+    /// Free blocks form an intrusive singly linked list threaded through the storage of the dead objects themselves.
+    /// The list is LIFO, so the next allocation reuses the block freed last, which is the one most likely still in cache.
     template <typename T>
     class CMemoryPool final
     {
     public:
-        explicit CMemoryPool(std::size_t numElems) : m_store(numElems, {T(), true}) /* pre-allocation of vector storage. */
+        /// A named pool publishes how many of its blocks are in use as a CMetricsRegistry gauge, an empty name keeps it out of the registry.
+        explicit CMemoryPool(std::size_t numElems, const std::string &name = "")
+            : m_store(numElems, CHugePageAllocator<SObjectBlock>("Common::CMemoryPool")) /* pre-allocation of pre-faulted, huge page backed storage. */
+            , m_isNamed(!name.empty())
         {
             ASSERT(reinterpret_cast<const SObjectBlock *>(&(m_store[0].object)) == &(m_store[0]), "T object should be first member of SObjectBlock.");
+
+            // Thread every block onto the free list in address order, so a fresh pool hands out blocks sequentially.
+            for (size_t i = 0; i + 1 < m_store.size(); ++i)
+            {
+                m_store[i].pNextFree = &m_store[i + 1];
+            }
+            m_pFreeHead = &m_store[0];
+
+            if (m_isNamed)
+            {
+                CMetricsRegistry::Instance().Sample(this, name, [this]() { return static_cast<int64_t>(UsedCount()); });
+            }
+        }
+
+        ~CMemoryPool()
+        {
+            if (m_isNamed)
+            {
+                CMetricsRegistry::Instance().Unsample(this);
+            }
         }
 
         /// Allocate a new object of type T, use placement new to initialize the object, mark the block as in-use and return the object.
         template <typename... Args>
         T* Allocate(Args... args) noexcept
         {
-            auto pObjBlock = &(m_store[m_nextFreeIndex]);
-            ASSERT(pObjBlock->isFree, "Expected free SObjectBlock at index:" + std::to_string(m_nextFreeIndex));
+            auto pObjBlock = m_pFreeHead;
+            ASSERT(pObjBlock != nullptr, "Memory Pool out of space.");
+            ASSERT(pObjBlock->isFree, "Expected free SObjectBlock at index:" + std::to_string(pObjBlock - &m_store[0]));
+            m_pFreeHead = pObjBlock->pNextFree;
+
             T *pRet = &(pObjBlock->object);
             pRet = new (pRet) T(args...); // placement new.
             pObjBlock->isFree = false;
+            m_numUsed.store(m_numUsed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 
-            UpdateNextFreeIndex();
             return pRet;
         }
 
-        /// Return the object back to the pool by marking the block as free again.
+        /// Return the object back to the pool by pushing its block on the front of the free list.
         /// Destructor is not called for the object.
         auto Deallocate(const T *elem) noexcept
         {
             const auto elemIndex = (reinterpret_cast<const SObjectBlock *>(elem) - &m_store[0]);
 
             ASSERT(elemIndex >= 0 && static_cast<size_t>(elemIndex) < m_store.size(), "Element being deallocated does not belong to this Memory pool.");
-            ASSERT(!m_store[elemIndex].isFree, "Expected in-use SObjectBlock at index:" + std::to_string(elemIndex));
+            PARANOID_ASSERT((reinterpret_cast<const char *>(elem) - reinterpret_cast<const char *>(&m_store[0])) % sizeof(SObjectBlock) == 0,
+                            "Element being deallocated is not at the start of a SObjectBlock.");
+            ASSERT(!m_store[elemIndex].isFree, "Double free of SObjectBlock at index:" + std::to_string(elemIndex));
+
+            auto pObjBlock = &m_store[elemIndex];
+            pObjBlock->isFree = true;
+            pObjBlock->pNextFree = m_pFreeHead;
+            m_pFreeHead = pObjBlock;
+            m_numUsed.store(m_numUsed.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
 
-            m_store[elemIndex].isFree = true;
+        /// Blocks currently allocated, safe to read from any thread.
+        auto UsedCount() const noexcept
+        {
+            return m_numUsed.load(std::memory_order_relaxed);
         }
 
         // Deleted default, copy & move constructors and assignment-operators.
@@ -55,37 +99,37 @@ namespace Common
         CMemoryPool &operator=(const CMemoryPool &&) = delete;
 
     private:
-        /// Find the next available free block to be used for the next allocation.
-        auto UpdateNextFreeIndex() noexcept
-        {
-            const auto initialFreeIndex = m_nextFreeIndex;
-            while (!m_store[m_nextFreeIndex].isFree)
-            {
-                ++m_nextFreeIndex;
-                if (UNLIKELY(m_nextFreeIndex == m_store.size()))
-                { // hardware branch predictor should almost always predict this to be false any ways.
-                    m_nextFreeIndex = 0;
-                }
-                if (UNLIKELY(initialFreeIndex == m_nextFreeIndex))
-                {
-                    ASSERT(initialFreeIndex != m_nextFreeIndex, "Memory Pool out of space.");
-                }
-            }
-        }
-
         /// It is better to have one vector of structs with two objects than two vectors of one object.
         /// Consider how these are accessed and cache performance.
+        /// A free block reuses the object's storage for the free list link, isFree is what catches double frees.
         struct SObjectBlock
         {
-            T object;
+            union
+            {
+                T object;
+                SObjectBlock *pNextFree;
+            };
             bool isFree = true;
+
+            SObjectBlock() : pNextFree(nullptr)
+            {
+            }
+
+            ~SObjectBlock()
+            {
+            }
         };
 
         /// We could've chosen to use a std::array that would Allocate the memory on the stack instead of the heap.
         /// We would have to measure to see which one yields better performance.
         /// It is good to have objects on the stack but performance starts getting worse as the size of the pool increases.
-        std::vector<SObjectBlock> m_store;
+        std::vector<SObjectBlock, CHugePageAllocator<SObjectBlock>> m_store;
+
+        /// Most recently freed block, nullptr when the pool is exhausted.
+        SObjectBlock *m_pFreeHead = nullptr;
 
-        size_t m_nextFreeIndex = 0;
+        /// Written only by the owner, a plain load and store instead of a locked read-modify-write, atomic so the registry thread can sample it.
+        std::atomic<size_t> m_numUsed = {0};
+        const bool          m_isNamed;
     };
 }
@@ -0,0 +1,157 @@
+#include "Metrics.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "QueueStats.h"
+#include "ThreadUtils.h"
+#include "TimeUtils.h"
+
+namespace Common
+{
+    namespace
+    {
+        auto CopyName(char *pDest, size_t size, std::string_view name) noexcept
+        {
+            const auto length = std::min(name.size(), size - 1);
+            std::memcpy(pDest, name.data(), length);
+            pDest[length] = '\0';
+        }
+    }
+
+    CMetricsRegistry::CMetricsRegistry()
+        : m_shmName(std::string("/").append(METRICS_SHM_PREFIX).append(program_invocation_short_name).append(".").append(std::to_string(getpid())))
+    {
+        // Remove a stale segment of an earlier process that had the same pid.
+        shm_unlink(m_shmName.c_str());
+
+        const auto fd = shm_open(m_shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        ASSERT(fd >= 0, "shm_open() failed for:" + m_shmName + " error:" + std::string(std::strerror(errno)));
+        ASSERT(ftruncate(fd, sizeof(SMetricsSegment)) == 0, "ftruncate() failed for:" + m_shmName + " error:" + std::string(std::strerror(errno)));
+
+        auto p = mmap(nullptr, sizeof(SMetricsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        ASSERT(p != MAP_FAILED, "mmap() failed for:" + m_shmName + " error:" + std::string(std::strerror(errno)));
+        m_pSegment = reinterpret_cast<SMetricsSegment *>(p);
+
+        auto pHeader = new (&m_pSegment->header) SMetricsHeader();
+        pHeader->layoutVersion = METRICS_LAYOUT_VERSION;
+        pHeader->pid = getpid();
+        CopyName(pHeader->process, sizeof(pHeader->process), program_invocation_short_name);
+        // The magic goes last, a reader that races the creation sees a segment that is not ours yet.
+        pHeader->magic.store(METRICS_MAGIC, std::memory_order_release);
+
+        m_pUnpublishedHistograms = FindOrAddValueLocked("metrics:unpublished_histograms", EMetricType::COUNTER);
+
+        // Constructed before the registry so they are destroyed after it, the registry thread uses both until the destructor stops it.
+        CTscClock::Instance();
+        OptCommon::CQueueStatsRegistry::Instance();
+
+        m_isRunning = true;
+        m_pThread = CreateAndStartThread(-1, "Common/CMetricsRegistry", [this]() { Run(); });
+        ASSERT(m_pThread != nullptr, "Failed to start CMetricsRegistry thread.");
+    }
+
+    CMetricsRegistry::~CMetricsRegistry()
+    {
+        if (m_pThread)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_isRunning = false;
+            }
+            m_wakeup.notify_one();
+            m_pThread->join();
+
+            delete m_pThread;
+            m_pThread = nullptr;
+        }
+
+        shm_unlink(m_shmName.c_str());
+    }
+
+    auto CMetricsRegistry::Histogram(std::string_view tag, EHistogramUnit unit) -> CLatencyHistogram *
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto &header = m_pSegment->header;
+        const auto index = header.numHistograms.load(std::memory_order_relaxed);
+        if (UNLIKELY(index == METRICS_MAX_HISTOGRAMS))
+        {
+            m_pUnpublishedHistograms->value.fetch_add(1, std::memory_order_relaxed);
+            return new CLatencyHistogram();
+        }
+
+        auto pSlot = new (&m_pSegment->histograms[index]) SMetricHistogram();
+        CopyName(pSlot->name, sizeof(pSlot->name), tag);
+        pSlot->unit = unit;
+        header.numHistograms.store(index + 1, std::memory_order_release);
+
+        return &pSlot->histogram;
+    }
+
+    auto CMetricsRegistry::FindOrAddValueLocked(std::string_view name, EMetricType type) -> SMetricValue *
+    {
+        auto &header = m_pSegment->header;
+        const auto count = header.numValues.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto &slot = m_pSegment->values[i];
+            if (name.substr(0, METRICS_NAME_SIZE - 1) == slot.name)
+            {
+                ASSERT(slot.type == type, "Metric:" + std::string(name) + " already exists with another type.");
+                return &slot;
+            }
+        }
+
+        if (UNLIKELY(count == METRICS_MAX_VALUES))
+        {
+            return &m_overflowValue;
+        }
+
+        auto pSlot = new (&m_pSegment->values[count]) SMetricValue();
+        pSlot->type = type;
+        CopyName(pSlot->name, sizeof(pSlot->name), name);
+        header.numValues.store(count + 1, std::memory_order_release);
+
+        return pSlot;
+    }
+
+    auto CMetricsRegistry::Run() -> void
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_isRunning)
+        {
+            SampleLocked();
+            m_wakeup.wait_for(lock, METRICS_SAMPLE_INTERVAL, [this]() { return !m_isRunning; });
+        }
+    }
+
+    auto CMetricsRegistry::SampleLocked() -> void
+    {
+        for (const auto &sampled : m_sampled)
+        {
+            sampled.pSlot->value.store(sampled.getValue(), std::memory_order_relaxed);
+        }
+
+        // Queues register with CQueueStatsRegistry on their own, their gauges are created the first time they are seen.
+        for (const auto &stats : OptCommon::CQueueStatsRegistry::Instance().Snapshot())
+        {
+            const auto set = [&](const char *suffix, EMetricType type, size_t value)
+            {
+                FindOrAddValueLocked(stats.name + suffix, type)->value.store(static_cast<int64_t>(value), std::memory_order_relaxed);
+            };
+            set(".size", EMetricType::GAUGE, stats.size);
+            set(".high_water", EMetricType::GAUGE, stats.highWaterMark);
+            set(".full", EMetricType::COUNTER, stats.fullCount);
+            set(".dropped", EMetricType::COUNTER, stats.dropCount);
+        }
+
+        auto &header = m_pSegment->header;
+        header.nanosPerTick.store(CTscClock::Instance().NanosPerTick(), std::memory_order_relaxed);
+        header.sampleNanos.store(GetCurrentNanos(), std::memory_order_release);
+    }
+}
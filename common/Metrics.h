@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "Macros.h"
+
+namespace Common
+{
+    /// Bumped every time the segment layout below changes, so a stats_reader built against another layout refuses to read it.
+    constexpr uint32_t METRICS_LAYOUT_VERSION = 3;
+
+    /// Identifies a segment created by CMetricsRegistry, "ULLMETR\0" in little endian.
+    constexpr uint64_t METRICS_MAGIC = 0x005254454d4c4c55;
+
+    /// Every process publishes its metrics in /dev/shm/ull_metrics.<process name>.<pid>, what stats_reader lists and attaches to.
+    constexpr std::string_view METRICS_SHM_PREFIX = "ull_metrics.";
+
+    constexpr size_t METRICS_MAX_VALUES = 1024;
+
+    /// One histogram per thread and tag. trading_main alone preregisters ~150 with ENABLE_PERF_COUNTERS, each tag also gets a histogram per counter.
+    /// A slot is ~30 KB but only the pages of slots handed out are ever touched. Past the cap metrics:unpublished_histograms counts what stats_reader misses.
+    constexpr size_t METRICS_MAX_HISTOGRAMS = 512;
+    constexpr size_t METRICS_NAME_SIZE = 48;
+
+    /// How often the registry thread refreshes the sampled gauges: queue statistics, pool occupancy and anything else registered with Sample().
+    constexpr auto METRICS_SAMPLE_INTERVAL = std::chrono::milliseconds(100);
+
+    enum class EMetricType : uint8_t
+    {
+        COUNTER = 0, /// Only ever goes up, the reader shows its rate.
+        GAUGE = 1    /// Current level of something.
+    };
+
+    /// One counter or gauge, a cache line each so the owners of neighbouring metrics never write to the same line.
+    struct alignas(CACHE_LINE_SIZE) SMetricValue
+    {
+        std::atomic<int64_t> value = {0};
+        EMetricType          type = EMetricType::COUNTER;
+        char                 name[METRICS_NAME_SIZE] = {};
+    };
+
+    static_assert(sizeof(SMetricValue) == CACHE_LINE_SIZE);
+
+    /// One thread's histogram of a tag, the reader merges every histogram of the same tag like CLatencyService does.
+    struct alignas(CACHE_LINE_SIZE) SMetricHistogram
+    {
+        char              name[METRICS_NAME_SIZE] = {};
+        EHistogramUnit    unit = EHistogramUnit::TICKS;
+        CLatencyHistogram histogram;
+    };
+
+    /// Start of the segment. A slot is published by bumping its count with release semantics after its name and type are written,
+    /// the reader only looks at the first count slots it loaded with acquire semantics.
+    struct alignas(CACHE_LINE_SIZE) SMetricsHeader
+    {
+        std::atomic<uint64_t> magic = {0};
+        uint32_t              layoutVersion = 0;
+        int32_t               pid = 0;
+        char                  process[32] = {};
+        std::atomic<uint32_t> numValues = {0};
+        std::atomic<uint32_t> numHistograms = {0};
+
+        /// Refreshed with the sampled gauges: converts the histograms' TSC ticks to nanoseconds, and tells the reader how fresh the segment is.
+        std::atomic<double>  nanosPerTick = {0.0};
+        std::atomic<int64_t> sampleNanos = {0};
+    };
+
+    /// The whole segment. Only the header is written when it is created, a slot is constructed when it is handed out,
+    /// so the pages of slots never used stay untouched zeroes.
+    struct SMetricsSegment
+    {
+        SMetricsHeader                                       header;
+        std::array<SMetricValue, METRICS_MAX_VALUES>         values;
+        std::array<SMetricHistogram, METRICS_MAX_HISTOGRAMS> histograms;
+    };
+
+    /// Handle to a counter in the segment, incremented by its owning thread only.
+    class CMetricCounter final
+    {
+    public:
+        explicit CMetricCounter(SMetricValue *pSlot) noexcept : m_pValue(&pSlot->value)
+        {
+        }
+
+        /// A plain load and store instead of a locked read-modify-write, the owner is the only writer.
+        auto Increment(int64_t n = 1) const noexcept
+        {
+            m_pValue->store(m_pValue->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        auto Value() const noexcept
+        {
+            return m_pValue->load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<int64_t> *m_pValue = nullptr;
+    };
+
+    /// Handle to a gauge in the segment, set by its owning thread only.
+    class CMetricGauge final
+    {
+    public:
+        explicit CMetricGauge(SMetricValue *pSlot) noexcept : m_pValue(&pSlot->value)
+        {
+        }
+
+        auto Set(int64_t value) const noexcept
+        {
+            m_pValue->store(value, std::memory_order_relaxed);
+        }
+
+        auto Add(int64_t n) const noexcept
+        {
+            m_pValue->store(m_pValue->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        auto Value() const noexcept
+        {
+            return m_pValue->load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<int64_t> *m_pValue = nullptr;
+    };
+
+    /// Process wide live metrics, kept in a shared memory segment so stats_reader can attach read-only and watch them without the process doing anything.
+    /// Owning threads update counters, gauges and histograms in place with relaxed stores, there is no lock, copy or syscall on the hot path.
+    /// A background thread refreshes every METRICS_SAMPLE_INTERVAL the gauges of values their owners already keep for themselves:
+    /// CQueueStatsRegistry's queues and whatever was registered with Sample(), pool occupancy for one.
+    /// Handing out a metric takes a lock and is meant for constructors, metrics are never removed.
+    class CMetricsRegistry final
+    {
+    public:
+        static auto Instance() -> CMetricsRegistry &
+        {
+            static CMetricsRegistry registry;
+            return registry;
+        }
+
+        /// The counter / gauge called name, created on first use. Every caller asking for the same name gets the same metric.
+        auto Counter(std::string_view name) -> CMetricCounter
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return CMetricCounter(FindOrAddValueLocked(name, EMetricType::COUNTER));
+        }
+
+        auto Gauge(std::string_view name) -> CMetricGauge
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return CMetricGauge(FindOrAddValueLocked(name, EMetricType::GAUGE));
+        }
+
+        /// A new histogram for the calling thread to record tag into. Past METRICS_MAX_HISTOGRAMS it is allocated privately and not published,
+        /// and counted in metrics:unpublished_histograms.
+        auto Histogram(std::string_view tag, EHistogramUnit unit = EHistogramUnit::TICKS) -> CLatencyHistogram *;
+
+        /// Have the registry thread set gauge name to getValue() every METRICS_SAMPLE_INTERVAL, until Unsample(pOwner).
+        auto Sample(const void *pOwner, std::string_view name, std::function<int64_t()> getValue) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_sampled.push_back({pOwner, FindOrAddValueLocked(name, EMetricType::GAUGE), std::move(getValue)});
+        }
+
+        auto Unsample(const void *pOwner) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::erase_if(m_sampled, [pOwner](const auto &sampled) { return sampled.pOwner == pOwner; });
+        }
+
+        /// The segment name is unlinked so stats_reader stops listing the process, it stays mapped: threads still running during static destruction
+        /// may be recording into it, CLatencyService's histograms live in it.
+        ~CMetricsRegistry();
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CMetricsRegistry(const CMetricsRegistry &) = delete;
+
+        CMetricsRegistry(const CMetricsRegistry &&) = delete;
+
+        CMetricsRegistry &operator=(const CMetricsRegistry &) = delete;
+
+        CMetricsRegistry &operator=(const CMetricsRegistry &&) = delete;
+
+    private:
+        CMetricsRegistry();
+
+        auto Run() -> void;
+
+        auto SampleLocked() -> void;
+
+        auto FindOrAddValueLocked(std::string_view name, EMetricType type) -> SMetricValue *;
+
+        struct SSampled
+        {
+            const void              *pOwner = nullptr;
+            SMetricValue            *pSlot = nullptr;
+            std::function<int64_t()> getValue;
+        };
+
+        const std::string m_shmName;
+        SMetricsSegment  *m_pSegment = nullptr;
+
+        /// Stands in for the slots past METRICS_MAX_VALUES, so an owner always gets a metric to write to.
+        SMetricValue m_overflowValue;
+
+        /// Histograms handed out past METRICS_MAX_HISTOGRAMS, so an incomplete latency report shows up as such.
+        SMetricValue *m_pUnpublishedHistograms = nullptr;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_wakeup;
+        std::vector<SSampled>   m_sampled;
+
+        std::thread *m_pThread = nullptr;
+        bool         m_isRunning = false;
+    };
+}
@@ -39,7 +39,7 @@ namespace Common
         if (n_rcv > 0)
         {
             m_nextRecvValidIndex += n_rcv;
-            m_logger.Log("%:% %() % read socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), m_fd,
+            LOG_TRACE(m_logger, "%:% %() read socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, m_fd,
                         m_nextRecvValidIndex);
             m_recvCallback(this);
         }
@@ -61,7 +61,7 @@ namespace Common
                 break;
             }
 
-            m_logger.Log("%:% %() % send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), m_fd, n);
+            LOG_TRACE(m_logger, "%:% %() send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, m_fd, n);
 
             n_send -= n;
             ASSERT(n == n_send_this_msg, "Don't support partial send lengths yet.");
@@ -2,6 +2,7 @@
 
 #include <functional>
 
+#include "HugePages.h"
 #include "SocketUtils.h"
 
 #include "Logging.h"
@@ -16,8 +17,8 @@ namespace Common
         SMultiCastSocket(CLogger &logger)
             : m_logger(logger)
         {
-            m_pSendBuffer = new char[MultiCastBufferSize];
-            m_pRecvBuffer = new char[MultiCastBufferSize];
+            m_pSendBuffer = static_cast<char *>(AllocateHugePages(MultiCastBufferSize, "Common::SMultiCastSocket send buffer"));
+            m_pRecvBuffer = static_cast<char *>(AllocateHugePages(MultiCastBufferSize, "Common::SMultiCastSocket recv buffer"));
             m_recvCallback = [this](auto pSocket)
             {
                 DefaultRecvCallback(pSocket);
@@ -28,10 +29,10 @@ namespace Common
         {
             Destroy();
 
-            delete[] m_pSendBuffer;            
+            FreeHugePages(m_pSendBuffer);
             m_pSendBuffer = nullptr;
 
-            delete[] m_pRecvBuffer;
+            FreeHugePages(m_pRecvBuffer);
             m_pRecvBuffer = nullptr;
         }
 
@@ -55,7 +56,7 @@ namespace Common
 
         void DefaultRecvCallback(SMultiCastSocket* pSocket) noexcept
         {
-            m_logger.Log("%:% %() % SMultiCastSocket::DefaultRecvCallback() socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), pSocket->m_fd, pSocket->m_nextRecvValidIndex);
+            LOG_TRACE(m_logger, "%:% %() SMultiCastSocket::DefaultRecvCallback() socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, pSocket->m_fd, pSocket->m_nextRecvValidIndex);
         }
 
         int  m_fd = -1;
@@ -71,7 +72,6 @@ namespace Common
         /// Function wrapper for the method to call when data is read.
         std::function<void(SMultiCastSocket*)> m_recvCallback;
 
-        std::string m_timeStr;
-        CLogger&    m_logger;
+        CLogger& m_logger;
     };
 }
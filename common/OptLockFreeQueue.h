@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "HugePages.h"
+#include "Macros.h"
+#include "RingSlots.h"
+#include "QueueStats.h"
+#include "WaitStrategy.h"
+
+namespace OptCommon
+{
+    /// Single producer / single consumer lock free queue.
+    /// Capacity is rounded up to a power of two so indices wrap with a mask instead of a modulo.
+    /// Producer and consumer indices live on separate cache lines and each side keeps a cached copy of the other side's index,
+    /// so the shared cache line is only touched when the cached copy says the queue is full / empty.
+    /// What happens when the queue really is full is decided by the EQueueFullPolicy, named queues report their occupancy through CQueueStatsRegistry.
+    template <typename T>
+    class COptLockFreeQueue final
+    {
+    public:
+        /// A run of consecutive slots in the ring, split in two spans when it wraps around the end of the buffer.
+        template <typename U>
+        using SSlots = OptCommon::SSlots<U>;
+
+        /// An empty name keeps the queue out of CQueueStatsRegistry.
+        explicit COptLockFreeQueue(std::size_t numElements, const std::string &name = "", EQueueFullPolicy fullPolicy = EQueueFullPolicy::SPIN)
+            : m_store(std::bit_ceil(numElements), T(), Common::CHugePageAllocator<T>("OptCommon::COptLockFreeQueue")) /* pre-allocation of pre-faulted, huge page backed storage. */
+            , m_mask(m_store.size() - 1)
+            , m_name(name)
+            , m_fullPolicy(fullPolicy)
+        {
+            if (!m_name.empty())
+            {
+                CQueueStatsRegistry::Instance().Register(this, [this]() { return Stats(); });
+            }
+        }
+
+        ~COptLockFreeQueue()
+        {
+            if (!m_name.empty())
+            {
+                CQueueStatsRegistry::Instance().Unregister(this);
+            }
+        }
+
+        /// Never overwrites elements the consumer has not read yet, a full queue is handled according to the EQueueFullPolicy.
+        /// With EQueueFullPolicy::DROP the returned slot is a scratch element and the following UpdateWriteIndex() discards it.
+        auto GetNextToWriteTo() noexcept
+        {
+            const auto writeIndex = m_producer.writeIndex.load(std::memory_order_relaxed);
+            m_producer.isDropping = !WaitForSpace(writeIndex, 1);
+            if (UNLIKELY(m_producer.isDropping))
+            {
+                return &m_producer.dropSlot;
+            }
+
+            return &m_store[writeIndex & m_mask];
+        }
+
+        auto UpdateWriteIndex() noexcept
+        {
+            if (UNLIKELY(m_producer.isDropping))
+            {
+                m_producer.dropCount.store(m_producer.dropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+
+            const auto writeIndex = m_producer.writeIndex.load(std::memory_order_relaxed);
+            m_producer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+            WakeConsumer();
+            SampleOccupancyEvery(writeIndex, writeIndex + 1);
+        }
+
+        auto GetNextToRead() const noexcept -> const T *
+        {
+            const auto readIndex = m_consumer.readIndex.load(std::memory_order_relaxed);
+            if (readIndex == m_consumer.cachedWriteIndex)
+            {
+                m_consumer.cachedWriteIndex = m_producer.writeIndex.load(std::memory_order_acquire);
+                if (readIndex == m_consumer.cachedWriteIndex)
+                {
+                    return nullptr;
+                }
+            }
+
+            return &m_store[readIndex & m_mask];
+        }
+
+        auto UpdateReadIndex() noexcept
+        {
+            const auto readIndex = m_consumer.readIndex.load(std::memory_order_relaxed);
+            DEBUG_ASSERT(readIndex != m_consumer.cachedWriteIndex, "Read an invalid element in:" + std::to_string(pthread_self()));
+            m_consumer.readIndex.store(readIndex + 1, std::memory_order_release);
+        }
+
+        /// Reserve min(count, capacity()) slots for a burst of writes, a full queue is handled according to the EQueueFullPolicy.
+        /// With EQueueFullPolicy::DROP fewer slots than requested may be returned, callers only write and commit size() of them.
+        /// Nothing becomes visible to the consumer until CommitWrite() publishes the whole batch with a single index update.
+        auto ReserveWrite(size_t count) noexcept -> SSlots<T>
+        {
+            count = std::min(count, m_store.size());
+            const auto writeIndex = m_producer.writeIndex.load(std::memory_order_relaxed);
+            const auto available = WaitForSpace(writeIndex, count);
+            if (UNLIKELY(available < count))
+            {
+                m_producer.dropCount.store(m_producer.dropCount.load(std::memory_order_relaxed) + count - available, std::memory_order_relaxed);
+            }
+
+            return Slice(m_store.data(), writeIndex, available);
+        }
+
+        auto CommitWrite(size_t count) noexcept
+        {
+            const auto writeIndex = m_producer.writeIndex.load(std::memory_order_relaxed);
+            m_producer.writeIndex.store(writeIndex + count, std::memory_order_release);
+            WakeConsumer();
+            SampleOccupancyEvery(writeIndex, writeIndex + count);
+        }
+
+        /// The consumer thread's wait strategy, unparked after every publish so a consumer with EWaitStrategy::PARK only sleeps while the queue is empty.
+        /// Only call before the producer starts.
+        auto SetConsumerWaitStrategy(Common::CWaitStrategy *pWaitStrategy) noexcept
+        {
+            m_producer.pConsumerWaitStrategy = pWaitStrategy;
+        }
+
+        /// Return up to maxCount elements that are ready to be read, without consuming them.
+        auto PeekRead(size_t maxCount) const noexcept -> SSlots<const T>
+        {
+            const auto readIndex = m_consumer.readIndex.load(std::memory_order_relaxed);
+            if (readIndex + maxCount > m_consumer.cachedWriteIndex)
+            {
+                m_consumer.cachedWriteIndex = m_producer.writeIndex.load(std::memory_order_acquire);
+            }
+
+            return Slice(m_store.data(), readIndex, std::min(maxCount, m_consumer.cachedWriteIndex - readIndex));
+        }
+
+        /// Consume the first count elements returned by PeekRead() with a single index update.
+        auto ReleaseRead(size_t count) noexcept
+        {
+            const auto readIndex = m_consumer.readIndex.load(std::memory_order_relaxed);
+            DEBUG_ASSERT(readIndex + count <= m_consumer.cachedWriteIndex, "Released more elements than were read in:" + std::to_string(pthread_self()));
+            m_consumer.readIndex.store(readIndex + count, std::memory_order_release);
+        }
+
+        /// Read index is loaded first so the result can never underflow, it only ever lags behind the true size.
+        auto size() const noexcept
+        {
+            const auto readIndex = m_consumer.readIndex.load(std::memory_order_acquire);
+            return m_producer.writeIndex.load(std::memory_order_acquire) - readIndex;
+        }
+
+        auto capacity() const noexcept
+        {
+            return m_store.size();
+        }
+
+        /// Safe to call from any thread, the counters are only ever written by the producer.
+        auto Stats() const -> SQueueStats
+        {
+            return {m_name, m_fullPolicy, capacity(), size(),
+                    m_producer.highWaterMark.load(std::memory_order_relaxed),
+                    m_producer.fullCount.load(std::memory_order_relaxed),
+                    m_producer.dropCount.load(std::memory_order_relaxed)};
+        }
+
+        /// Deleted default, copy & move constructors and assignment-operators.
+        COptLockFreeQueue() = delete;
+
+        COptLockFreeQueue(const COptLockFreeQueue &) = delete;
+
+        COptLockFreeQueue(const COptLockFreeQueue &&) = delete;
+
+        COptLockFreeQueue &operator=(const COptLockFreeQueue &) = delete;
+
+        COptLockFreeQueue &operator=(const COptLockFreeQueue &&) = delete;
+
+    private:
+        /// Return how many of the count slots starting at writeIndex are free.
+        /// Only the first check runs in the common case, the rest is the full path: refresh the consumer index and apply the EQueueFullPolicy.
+        auto WaitForSpace(size_t writeIndex, size_t count) noexcept -> size_t
+        {
+            if (LIKELY(writeIndex + count - m_producer.cachedReadIndex <= m_store.size()))
+            {
+                return count;
+            }
+
+            m_producer.cachedReadIndex = m_consumer.readIndex.load(std::memory_order_acquire);
+            SampleOccupancy(writeIndex, m_producer.cachedReadIndex);
+            if (writeIndex + count - m_producer.cachedReadIndex <= m_store.size())
+            {
+                return count;
+            }
+
+            m_producer.fullCount.store(m_producer.fullCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            switch (m_fullPolicy)
+            {
+                case EQueueFullPolicy::SPIN:
+                    while (writeIndex + count - m_producer.cachedReadIndex > m_store.size())
+                    {
+                        m_producer.cachedReadIndex = m_consumer.readIndex.load(std::memory_order_acquire);
+                    }
+                    return count;
+                case EQueueFullPolicy::DROP:
+                    return m_store.size() - (writeIndex - m_producer.cachedReadIndex);
+                case EQueueFullPolicy::FAIL_FAST:
+                    FATAL("Lock free queue full:" + Stats().ToString());
+            }
+
+            return 0;
+        }
+
+        auto WakeConsumer() noexcept
+        {
+            if (m_producer.pConsumerWaitStrategy)
+            {
+                m_producer.pConsumerWaitStrategy->Unpark();
+            }
+        }
+
+        auto SampleOccupancy(size_t writeIndex, size_t readIndex) noexcept
+        {
+            if (writeIndex - readIndex > m_producer.highWaterMark.load(std::memory_order_relaxed))
+            {
+                m_producer.highWaterMark.store(writeIndex - readIndex, std::memory_order_relaxed);
+            }
+        }
+
+        /// Sample exactly when the writes from oldWriteIndex to writeIndex crossed a QUEUE_STATS_SAMPLE_INTERVAL boundary, single writes and batch
+        /// commits alike. The consumer's cache line is only pulled over then, and the fresh index refreshes the producer's cached copy on the way.
+        auto SampleOccupancyEvery(size_t oldWriteIndex, size_t writeIndex) noexcept
+        {
+            if (UNLIKELY((oldWriteIndex ^ writeIndex) & ~(QUEUE_STATS_SAMPLE_INTERVAL - 1)))
+            {
+                m_producer.cachedReadIndex = m_consumer.readIndex.load(std::memory_order_acquire);
+                SampleOccupancy(writeIndex, m_producer.cachedReadIndex);
+            }
+        }
+
+        template <typename U>
+        auto Slice(U *pBase, size_t index, size_t count) const noexcept -> SSlots<U>
+        {
+            return SliceRing(pBase, m_mask, index, count);
+        }
+
+        /// Underlying container of data accessed in FIFO order, size is always a power of two.
+        /// Read-only after construction so it can share a cache line between both threads.
+        alignas(CACHE_LINE_SIZE) std::vector<T, Common::CHugePageAllocator<T>> m_store;
+        const size_t m_mask;
+
+        const std::string      m_name;
+        const EQueueFullPolicy m_fullPolicy;
+
+        /// Written only by the producer, the consumer reads writeIndex when its cached copy runs out.
+        /// The statistics are atomics only so Stats() can read them from another thread, the producer updates them with plain relaxed stores.
+        struct alignas(CACHE_LINE_SIZE) SProducerState
+        {
+            std::atomic<size_t> writeIndex = {0};
+            size_t cachedReadIndex = 0;
+            bool isDropping = false;
+            Common::CWaitStrategy *pConsumerWaitStrategy = nullptr;
+
+            std::atomic<size_t> highWaterMark = {0};
+            std::atomic<size_t> fullCount = {0};
+            std::atomic<size_t> dropCount = {0};
+
+            /// Scratch element handed out by GetNextToWriteTo() while dropping.
+            T dropSlot = T();
+        } m_producer;
+
+        /// Written only by the consumer, the producer reads readIndex when its cached copy says the queue is full.
+        struct alignas(CACHE_LINE_SIZE) SConsumerState
+        {
+            std::atomic<size_t> readIndex = {0};
+            mutable size_t cachedWriteIndex = 0;
+        } m_consumer;
+    };
+}
@@ -4,47 +4,62 @@
 #include <vector>
 #include <string>
 
+#include "HugePages.h"
 #include "Macros.h"
 
 namespace OptCommon
 {
+    /// Fixed size pool of T objects with constant time Allocate() / Deallocate() through a LIFO intrusive free list.
+    /// Same layout as Common::CMemoryPool, but ownership / double free / exhaustion checks are DEBUG_ASSERTs, compiled out of release builds.
     template <typename T>
     class COptMemPool final
     {
     public:
         explicit COptMemPool(std::size_t numElems)
-            : m_store(numElems, {T(), true}) /* pre-allocation of vector storage. */
+            : m_store(numElems, Common::CHugePageAllocator<SObjectBlock>("OptCommon::COptMemPool")) /* pre-allocation of pre-faulted, huge page backed storage. */
         {
             ASSERT(reinterpret_cast<const SObjectBlock *>(&(m_store[0].object)) == &(m_store[0]), "T object should be first member of SObjectBlock.");
+
+            // Thread every block onto the free list in address order, so a fresh pool hands out blocks sequentially.
+            for (size_t i = 0; i + 1 < m_store.size(); ++i)
+            {
+                m_store[i].pNextFree = &m_store[i + 1];
+            }
+            m_pFreeHead = &m_store[0];
         }
 
         /// Allocate a new object of type T, use placement new to initialize the object, mark the block as in-use and return the object.
         template <typename... Args>
         T *Allocate(Args... args) noexcept
         {
-            auto obj_block = &(m_store[m_nextFreeIndex]);
-#if !defined(NDEBUG)
-            ASSERT(obj_block->isFree, "Expected free SObjectBlock at index:" + std::to_string(m_nextFreeIndex));
+            auto obj_block = m_pFreeHead;
+            DEBUG_ASSERT(obj_block != nullptr, "Memory Pool out of space.");
+            DEBUG_ASSERT(obj_block->isFree, "Expected free SObjectBlock at index:" + std::to_string(obj_block - &m_store[0]));
+#if CONTRACT_CHECK_LEVEL >= CONTRACT_LEVEL_DEBUG
+            obj_block->isFree = false;
 #endif
+            m_pFreeHead = obj_block->pNextFree;
+
             T *ret = &(obj_block->object);
             ret = new (ret) T(args...); // placement new.
-            obj_block->isFree = false;
-
-            UpdateNextFreeIndex();
 
             return ret;
         }
 
-        /// Return the object back to the pool by marking the block as free again.
+        /// Return the object back to the pool by pushing its block on the front of the free list.
         /// Destructor is not called for the object.
         auto Deallocate(const T *elem) noexcept
         {
-            const auto elem_index = (reinterpret_cast<const SObjectBlock *>(elem) - &m_store[0]);
-#if !defined(NDEBUG)
-            ASSERT(elem_index >= 0 && static_cast<size_t>(elem_index) < m_store.size(), "Element being deallocated does not belong to this Memory pool.");
-            ASSERT(!m_store[elem_index].isFree, "Expected in-use SObjectBlock at index:" + std::to_string(elem_index));
+            auto obj_block = const_cast<SObjectBlock *>(reinterpret_cast<const SObjectBlock *>(elem));
+            DEBUG_ASSERT(obj_block >= &m_store[0] && obj_block < &m_store[0] + m_store.size(), "Element being deallocated does not belong to this Memory pool.");
+            PARANOID_ASSERT((reinterpret_cast<const char *>(elem) - reinterpret_cast<const char *>(&m_store[0])) % sizeof(SObjectBlock) == 0,
+                            "Element being deallocated is not at the start of a SObjectBlock.");
+            DEBUG_ASSERT(!obj_block->isFree, "Double free of SObjectBlock at index:" + std::to_string(obj_block - &m_store[0]));
+#if CONTRACT_CHECK_LEVEL >= CONTRACT_LEVEL_DEBUG
+            obj_block->isFree = true;
 #endif
-            m_store[elem_index].isFree = true;
+            obj_block->pNextFree = m_pFreeHead;
+            m_pFreeHead = obj_block;
         }
 
         // Deleted default, copy & move constructors and assignment-operators.
@@ -59,39 +74,33 @@ namespace OptCommon
         COptMemPool &operator=(const COptMemPool &&) = delete;
 
     private:
-        /// Find the next available free block to be used for the next allocation.
-        auto UpdateNextFreeIndex() noexcept
-        {
-            const auto initial_free_index = m_nextFreeIndex;
-            while (!m_store[m_nextFreeIndex].isFree)
-            {
-                ++m_nextFreeIndex;
-                if (UNLIKELY(m_nextFreeIndex == m_store.size()))
-                { // hardware branch predictor should almost always predict this to be false any ways.
-                    m_nextFreeIndex = 0;
-                }
-                if (UNLIKELY(initial_free_index == m_nextFreeIndex))
-                {
-#if !defined(NDEBUG)
-                    ASSERT(initial_free_index != m_nextFreeIndex, "Memory Pool out of space.");
-#endif
-                }
-            }
-        }
-
         /// It is better to have one vector of structs with two objects than two vectors of one object.
         /// Consider how these are accessed and cache performance.
+        /// A free block reuses the object's storage for the free list link, isFree is only maintained when DEBUG_ASSERTs are compiled in, to catch double frees.
         struct SObjectBlock
         {
-            T object;
+            union
+            {
+                T object;
+                SObjectBlock *pNextFree;
+            };
             bool isFree = true;
+
+            SObjectBlock() : pNextFree(nullptr)
+            {
+            }
+
+            ~SObjectBlock()
+            {
+            }
         };
 
         /// We could've chosen to use a std::array that would Allocate the memory on the stack instead of the heap.
         /// We would have to measure to see which one yields better performance.
         /// It is good to have objects on the stack but performance starts getting worse as the size of the pool increases.
-        std::vector<SObjectBlock> m_store;
+        std::vector<SObjectBlock, Common::CHugePageAllocator<SObjectBlock>> m_store;
 
-        size_t m_nextFreeIndex = 0;
+        /// Most recently freed block, nullptr when the pool is exhausted.
+        SObjectBlock *m_pFreeHead = nullptr;
     };
 }
@@ -0,0 +1,141 @@
+#include "PerfCounters.h"
+
+#include <errno.h>
+#include <iostream>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Common
+{
+    struct CPerfCounters::SEvent
+    {
+        const char *name;
+        uint32_t    type;
+        uint64_t    config;
+    };
+
+    namespace
+    {
+        constexpr auto HwCacheMiss(uint64_t cache) noexcept
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+
+        auto PerfEventOpen(perf_event_attr *pAttr, int groupFd) noexcept
+        {
+            return static_cast<int>(syscall(SYS_perf_event_open, pAttr, 0 /* calling thread */, -1 /* any cpu */, groupFd, 0));
+        }
+    }
+
+    CPerfCounters::CPerfCounters()
+    {
+        // Cycles and instructions take the fixed counters on Intel, the four others fit in the general purpose ones, so the pinned group is never multiplexed.
+        static constexpr std::array<SEvent, PERF_MAX_COUNTERS> hardwareEvents = {{
+            {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {"l1d_misses", PERF_TYPE_HW_CACHE, HwCacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+            {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {"dtlb_misses", PERF_TYPE_HW_CACHE, HwCacheMiss(PERF_COUNT_HW_CACHE_DTLB)},
+        }};
+        static constexpr std::array<SEvent, 4> softwareEvents = {{
+            {"task_clock_nanos", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+            {"context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+            {"cpu_migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+        }};
+
+        const auto hardwareError = OpenGroup(hardwareEvents.data(), hardwareEvents.size());
+        if (!hardwareError)
+        {
+            // rdpmc is only usable when the kernel lets user space read every counter of the group.
+            m_isRdpmc = true;
+            for (size_t i = 0; i < m_numCounters; ++i)
+            {
+                m_isRdpmc = m_isRdpmc && m_counters[i].pPage && m_counters[i].pPage->cap_user_rdpmc;
+            }
+            std::cerr << "CPerfCounters " << m_numCounters << " hardware counters read with " << (m_isRdpmc ? "rdpmc" : "read()") << std::endl;
+            return;
+        }
+
+        const auto softwareError = OpenGroup(softwareEvents.data(), softwareEvents.size());
+        if (!softwareError)
+        {
+            std::cerr << "CPerfCounters no hardware counters error:" << std::strerror(hardwareError) << ", " << m_numCounters
+                      << " software counters read with read()" << std::endl;
+            return;
+        }
+
+        std::cerr << "CPerfCounters no hardware counters error:" << std::strerror(hardwareError) << ", no software counters error:" << std::strerror(softwareError)
+                  << ", measurements record no counters" << std::endl;
+    }
+
+    CPerfCounters::~CPerfCounters()
+    {
+        CloseGroup();
+    }
+
+    auto CPerfCounters::OpenGroup(const SEvent *pEvents, size_t numEvents) -> int
+    {
+        for (size_t i = 0; i < numEvents; ++i)
+        {
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = pEvents[i].type;
+            attr.config = pEvents[i].config;
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.pinned = (m_numCounters == 0);
+
+            const auto fd = PerfEventOpen(&attr, m_numCounters ? m_counters[0].fd : -1);
+            if (fd < 0)
+            {
+                if (m_numCounters == 0)
+                {
+                    return errno;
+                }
+                continue;
+            }
+
+            auto &counter = m_counters[m_numCounters++];
+            counter.name = pEvents[i].name;
+            counter.fd = fd;
+
+            auto p = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd, 0);
+            counter.pPage = (p != MAP_FAILED ? reinterpret_cast<perf_event_mmap_page *>(p) : nullptr);
+        }
+
+        return 0;
+    }
+
+    auto CPerfCounters::CloseGroup() -> void
+    {
+        for (size_t i = 0; i < m_numCounters; ++i)
+        {
+            if (m_counters[i].pPage)
+            {
+                munmap(m_counters[i].pPage, sysconf(_SC_PAGESIZE));
+            }
+            close(m_counters[i].fd);
+            m_counters[i] = {};
+        }
+        m_numCounters = 0;
+        m_isRdpmc = false;
+    }
+
+    auto CPerfCounters::ReadGroup(SPerfSample &sample) const noexcept -> void
+    {
+        // PERF_FORMAT_GROUP: the number of events, then their values in the order they joined the group.
+        std::array<uint64_t, PERF_MAX_COUNTERS + 1> buffer = {};
+        if (read(m_counters[0].fd, buffer.data(), sizeof(buffer)) > 0)
+        {
+            for (size_t i = 0; i < std::min<size_t>(buffer[0], m_numCounters); ++i)
+            {
+                sample.values[i] = buffer[i + 1];
+            }
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <linux/perf_event.h>
+
+#include "LatencyService.h"
+#include "Macros.h"
+
+namespace Common
+{
+    /// Most events one thread's CPerfCounters group holds.
+    constexpr size_t PERF_MAX_COUNTERS = 6;
+
+    /// Counter values read at one point, in the order of CPerfCounters::Name().
+    struct SPerfSample
+    {
+        std::array<uint64_t, PERF_MAX_COUNTERS> values = {};
+    };
+
+    /// The calling thread's perf_event_open() counters, for START_MEASURE() / END_MEASURE() when built with ENABLE_PERF_COUNTERS.
+    ///
+    /// Opens one pinned group per thread on first use, user space only: cycles, instructions, L1D read misses, LLC misses, branch misses and dTLB read misses.
+    /// Events the PMU does not support are left out, the rest of the group is kept. The group is read with rdpmc straight from user space,
+    /// a few tens of cycles per event and no syscall.
+    /// Where there is no hardware PMU, virtual machines mostly, or perf_event_paranoid forbids it, the group falls back to software events
+    /// (task clock, page faults, context switches, cpu migrations) read with a single read() of the group, far too slow for production but still attributed per tag.
+    /// With nothing available at all it reads nothing and END_MEASURE() records no counters. Either way the reason is printed once per thread.
+    class CPerfCounters final
+    {
+    public:
+        static auto Instance() -> CPerfCounters &
+        {
+            static thread_local CPerfCounters counters;
+            return counters;
+        }
+
+        auto NumCounters() const noexcept
+        {
+            return m_numCounters;
+        }
+
+        auto Name(size_t index) const noexcept
+        {
+            return m_counters[index].name;
+        }
+
+        /// Current value of every counter of the group.
+        auto Read() const noexcept -> SPerfSample
+        {
+            SPerfSample sample;
+            if (LIKELY(m_isRdpmc))
+            {
+                for (size_t i = 0; i < m_numCounters; ++i)
+                {
+                    sample.values[i] = ReadRdpmc(m_counters[i].pPage);
+                }
+            }
+            else if (m_numCounters)
+            {
+                ReadGroup(sample);
+            }
+
+            return sample;
+        }
+
+        ~CPerfCounters();
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CPerfCounters(const CPerfCounters &) = delete;
+
+        CPerfCounters(const CPerfCounters &&) = delete;
+
+        CPerfCounters &operator=(const CPerfCounters &) = delete;
+
+        CPerfCounters &operator=(const CPerfCounters &&) = delete;
+
+    private:
+        CPerfCounters();
+
+        struct SEvent;
+
+        /// Open the events as one group, the first as leader, skipping those that fail. Returns errno of the leader, 0 when it opened.
+        auto OpenGroup(const SEvent *pEvents, size_t numEvents) -> int;
+
+        auto CloseGroup() -> void;
+
+        /// The syscall fallback, for software events and for kernels that do not allow rdpmc.
+        auto ReadGroup(SPerfSample &sample) const noexcept -> void;
+
+        /// Lock free read of an event's count: the page's seqlock guards the offset the kernel keeps and the hardware counter's index.
+        static auto ReadRdpmc(const perf_event_mmap_page *pPage) noexcept -> uint64_t
+        {
+            uint32_t seq;
+            uint64_t count;
+            do
+            {
+                seq = pPage->lock;
+                asm volatile("" ::: "memory");
+                count = pPage->offset;
+                const auto index = pPage->index;
+                if (LIKELY(index))
+                {
+                    // Only pmc_width bits are valid, sign extend them.
+                    const auto shift = 64 - pPage->pmc_width;
+                    count += static_cast<uint64_t>(static_cast<int64_t>(__builtin_ia32_rdpmc(static_cast<int>(index - 1)) << shift) >> shift);
+                }
+                asm volatile("" ::: "memory");
+            } while (pPage->lock != seq);
+
+            return count;
+        }
+
+        struct SCounter
+        {
+            const char            *name = nullptr;
+            int                    fd = -1;
+            perf_event_mmap_page  *pPage = nullptr;
+        };
+
+        std::array<SCounter, PERF_MAX_COUNTERS> m_counters;
+        size_t                                  m_numCounters = 0;
+        bool                                    m_isRdpmc = false;
+    };
+
+    /// The histograms one thread records one tag's counter deltas into, "<tag>.<counter>" in CLatencyService and stats_reader.
+    class CPerfHistograms final
+    {
+    public:
+        explicit CPerfHistograms(const char *tag)
+        {
+            const auto &counters = CPerfCounters::Instance();
+            for (size_t i = 0; i < counters.NumCounters(); ++i)
+            {
+                // Built on the stack, so a thread that preregistered its tags finds them again without allocating.
+                char counterTag[LATENCY_MAX_TAG_LENGTH];
+                snprintf(counterTag, sizeof(counterTag), "%s.%s", tag, counters.Name(i));
+                m_pHistograms[i] = CLatencyService::Instance().ThreadHistogram(counterTag, EHistogramUnit::COUNT);
+            }
+            m_numHistograms = counters.NumCounters();
+        }
+
+        auto Record(const SPerfSample &start, const SPerfSample &stop) noexcept
+        {
+            for (size_t i = 0; i < m_numHistograms; ++i)
+            {
+                m_pHistograms[i]->Record(stop.values[i] - start.values[i]);
+            }
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CPerfHistograms(const CPerfHistograms &) = delete;
+
+        CPerfHistograms(const CPerfHistograms &&) = delete;
+
+        CPerfHistograms &operator=(const CPerfHistograms &) = delete;
+
+        CPerfHistograms &operator=(const CPerfHistograms &&) = delete;
+
+    private:
+        std::array<CLatencyHistogram *, PERF_MAX_COUNTERS> m_pHistograms = {};
+        size_t                                             m_numHistograms = 0;
+    };
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <initializer_list>
+#include <x86intrin.h>
+
 namespace Common
 {
     /// Read from the TSC register and return a uint64_t value to represent elapsed CPU clock cycles.
@@ -10,23 +14,83 @@ namespace Common
                              : "=a"(lo), "=d"(hi));
         return ((uint64_t)hi << 32) | lo;
     }
+
+    /// rdtsc() for the start of a measured region: the lfence before keeps it from being read ahead of earlier instructions,
+    /// the one after keeps the region's instructions from starting before it is read.
+    inline auto rdtscStart() noexcept -> uint64_t
+    {
+        _mm_lfence();
+        const auto tsc = __rdtsc();
+        _mm_lfence();
+        return tsc;
+    }
+
+    /// rdtscp for the end of a measured region: it waits for every earlier instruction to finish, the lfence after keeps later ones out of the region.
+    inline auto rdtscStop() noexcept -> uint64_t
+    {
+        unsigned int aux;
+        const auto tsc = __rdtscp(&aux);
+        _mm_lfence();
+        return tsc;
+    }
 }
 
-/// Start latency measurement using rdtsc(). Creates a variable called TAG in the local scope.
-#define START_MEASURE(TAG) const auto TAG = Common::rdtsc()
+#include "LatencyService.h"
+
+#if defined(ENABLE_PERF_COUNTERS)
+#include "PerfCounters.h"
+#endif
 
-/// End latency measurement using rdtsc(). Expects a variable called TAG to already exist in the local scope.
-#define END_MEASURE(TAG, LOGGER)                                                                \
-    do                                                                                          \
-    {                                                                                           \
-        const auto end = Common::rdtsc();                                                       \
-        LOGGER.Log("% RDTSC " #TAG " %\n", Common::GetCurrentTimeStr(&m_timeStr), (end - TAG)); \
+namespace Common
+{
+    /// Create the calling thread's END_MEASURE() histograms for tags up front, from its run loop before it starts processing.
+    /// A tag is otherwise allocated the first time it is measured, which on a rare path can be long after the thread was held to allocating nothing.
+    inline auto PreregisterMeasures(std::initializer_list<const char *> tags) -> void
+    {
+        for (const auto *tag : tags)
+        {
+            CLatencyService::Instance().ThreadHistogram(tag);
+#if defined(ENABLE_PERF_COUNTERS)
+            CPerfHistograms perfHistograms(tag);
+#endif
+        }
+    }
+}
+
+#if defined(ENABLE_PERF_COUNTERS)
+
+/// Start latency measurement using rdtscStart(), after reading this thread's CPerfCounters.
+/// Creates variables called TAG and TAG_perf in the local scope.
+#define START_MEASURE(TAG)                                                                                              \
+    const auto TAG##_perf = Common::CPerfCounters::Instance().Read();                                                   \
+    const auto TAG = Common::rdtscStart()
+
+/// End latency measurement using rdtscStop() and record it into this thread's histogram for TAG, then record how much each of
+/// this thread's CPerfCounters moved into its histograms for TAG.<counter>, all reported by CLatencyService.
+/// Expects the variables START_MEASURE() created to already exist in the local scope.
+#define END_MEASURE(TAG)                                                                                                \
+    do                                                                                                                  \
+    {                                                                                                                   \
+        const auto TAG##_stop = Common::rdtscStop();                                                                    \
+        const auto TAG##_perfStop = Common::CPerfCounters::Instance().Read();                                           \
+        static thread_local auto *const TAG##_pHistogram = Common::CLatencyService::Instance().ThreadHistogram(#TAG);   \
+        TAG##_pHistogram->Record(TAG##_stop - TAG);                                                                     \
+        static thread_local Common::CPerfHistograms TAG##_perfHistograms(#TAG);                                         \
+        TAG##_perfHistograms.Record(TAG##_perf, TAG##_perfStop);                                                        \
     } while (false)
 
-/// Log a current timestamp at the time this macro is invoked.
-#define TTT_MEASURE(TAG, LOGGER)                                                      \
-    do                                                                                \
-    {                                                                                 \
-        const auto TAG = Common::GetCurrentNanos();                                   \
-        LOGGER.Log("% TTT " #TAG " %\n", Common::GetCurrentTimeStr(&m_timeStr), TAG); \
+#else
+
+/// Start latency measurement using rdtscStart(). Creates a variable called TAG in the local scope.
+#define START_MEASURE(TAG) const auto TAG = Common::rdtscStart()
+
+/// End latency measurement using rdtscStop() and record it into this thread's histogram for TAG, reported by CLatencyService.
+/// Expects a variable called TAG to already exist in the local scope.
+#define END_MEASURE(TAG)                                                                                                \
+    do                                                                                                                  \
+    {                                                                                                                   \
+        static thread_local auto *const TAG##_pHistogram = Common::CLatencyService::Instance().ThreadHistogram(#TAG);   \
+        TAG##_pHistogram->Record(Common::rdtscStop() - TAG);                                                            \
     } while (false)
+
+#endif
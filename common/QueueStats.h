@@ -0,0 +1,129 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Macros.h"
+
+namespace OptCommon
+{
+    /// What a producer does when the queue it writes to has no free slot.
+    enum class EQueueFullPolicy : int8_t
+    {
+        SPIN = 0,     /// Busy-wait until the consumer frees a slot, nothing is lost.
+        DROP = 1,     /// Discard the write and count it, the producer never blocks.
+        FAIL_FAST = 2 /// FATAL with the queue statistics, for queues that must never fill up.
+    };
+
+    inline auto QueueFullPolicyToString(EQueueFullPolicy policy) -> std::string
+    {
+        switch (policy)
+        {
+            case EQueueFullPolicy::SPIN:
+                return "SPIN";
+            case EQueueFullPolicy::DROP:
+                return "DROP";
+            case EQueueFullPolicy::FAIL_FAST:
+                return "FAIL_FAST";
+        }
+
+        return "UNKNOWN";
+    }
+
+    /// Occupancy is sampled exactly (by reading the consumer index) each time the writes cross a multiple of this many elements, whether they
+    /// come one at a time or in batch commits, and whenever the producer refreshes its cached consumer index because the queue looked full.
+    constexpr size_t QUEUE_STATS_SAMPLE_INTERVAL = 64;
+
+    /// Point in time view of a queue's occupancy and overflow counters.
+    struct SQueueStats
+    {
+        std::string      name;
+        EQueueFullPolicy policy = EQueueFullPolicy::SPIN;
+        size_t           capacity = 0;
+        size_t           size = 0;
+        size_t           highWaterMark = 0;
+        size_t           fullCount = 0;
+        size_t           dropCount = 0;
+
+        auto ToString() const
+        {
+            std::stringstream ss;
+            ss << "SQueueStats"
+               << " ["
+               << " name:" << name
+               << " policy:" << QueueFullPolicyToString(policy)
+               << " capacity:" << capacity
+               << " size:" << size
+               << " high-water:" << highWaterMark
+               << " full:" << fullCount
+               << " dropped:" << dropCount
+               << "]";
+            return ss.str();
+        }
+    };
+
+    /// Process wide list of named queues, so their statistics can be reported without the owners knowing about each other.
+    /// Only touched on queue construction / destruction and by whoever reports, never on the hot path.
+    class CQueueStatsRegistry final
+    {
+    public:
+        static auto Instance() -> CQueueStatsRegistry &
+        {
+            static CQueueStatsRegistry registry;
+            return registry;
+        }
+
+        auto Register(const void *pQueue, std::function<SQueueStats()> getStats) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_sources.push_back({pQueue, std::move(getStats)});
+        }
+
+        auto Unregister(const void *pQueue) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::erase_if(m_sources, [pQueue](const auto &source) { return source.pQueue == pQueue; });
+        }
+
+        auto Snapshot() const -> std::vector<SQueueStats>
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<SQueueStats> stats;
+            stats.reserve(m_sources.size());
+            for (const auto &source : m_sources)
+            {
+                stats.push_back(source.getStats());
+            }
+
+            return stats;
+        }
+
+        /// One line per registered queue.
+        auto ToString() const
+        {
+            std::string str;
+            for (const auto &stats : Snapshot())
+            {
+                str += stats.ToString() + "\n";
+            }
+
+            return str;
+        }
+
+    private:
+        CQueueStatsRegistry() = default;
+
+        struct SSource
+        {
+            const void                  *pQueue = nullptr;
+            std::function<SQueueStats()> getStats;
+        };
+
+        mutable std::mutex   m_mutex;
+        std::vector<SSource> m_sources;
+    };
+}
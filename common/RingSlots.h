@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+
+namespace OptCommon
+{
+    /// A run of consecutive slots in a power of two sized ring, split in two spans when it wraps around the end of the buffer.
+    /// Handed out by the batch APIs of COptLockFreeQueue, CShmLockFreeQueue and CBroadcastRing.
+    template <typename U>
+    struct SSlots
+    {
+        std::span<U> first;
+        std::span<U> second;
+
+        auto size() const noexcept
+        {
+            return first.size() + second.size();
+        }
+
+        auto &operator[](size_t i) const noexcept
+        {
+            return (i < first.size() ? first[i] : second[i - first.size()]);
+        }
+    };
+
+    /// The count slots starting at ring index index of the ring at pBase, whose capacity is mask + 1.
+    template <typename U>
+    inline auto SliceRing(U *pBase, size_t mask, size_t index, size_t count) noexcept -> SSlots<U>
+    {
+        const auto begin = (index & mask);
+        const auto firstCount = std::min(count, mask + 1 - begin);
+
+        return {{pBase + begin, firstCount}, {pBase, count - firstCount}};
+    }
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <immintrin.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "HugePages.h"
+#include "Macros.h"
+#include "Metrics.h"
+#include "ThreadUtils.h"
+
+namespace Common
+{
+    /// Storage of a CSegmentedMemoryPool is committed in chunks of this many bytes, one transparent huge page.
+    constexpr size_t POOL_CHUNK_BYTES = HUGE_PAGE_2MB_SIZE;
+
+    /// The pre-commit watermark: chunks are committed in the background whenever fewer than this many chunks of committed, never used storage remain.
+    /// Two so a burst that eats through one chunk still finds the next one committed while the committer catches up.
+    constexpr size_t POOL_PRECOMMIT_CHUNKS = 2;
+
+    /// Process wide background thread that commits storage ahead of the CSegmentedMemoryPools, so their owners never take the mmap / page fault cost.
+    /// Started by the first pool that registers, parked while no pool has asked for more storage.
+    class CPoolCommitter final
+    {
+    public:
+        static auto Instance() -> CPoolCommitter &
+        {
+            static CPoolCommitter committer;
+            return committer;
+        }
+
+        /// commitAhead is run on the committer thread and returns whether it committed anything.
+        auto Register(const void *pPool, std::function<bool()> commitAhead) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pools.push_back({pPool, std::move(commitAhead)});
+
+            if (!m_pThread)
+            {
+                m_isRunning = true;
+                m_pThread = CreateAndStartThread(-1, "Common/CPoolCommitter", [this]() { Run(); });
+                ASSERT(m_pThread != nullptr, "Failed to start CPoolCommitter thread.");
+            }
+        }
+
+        /// Once this returns the committer thread is not, and will not be, running the pool's commitAhead.
+        auto Unregister(const void *pPool) -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::erase_if(m_pools, [pPool](const auto &pool) { return pool.pPool == pPool; });
+        }
+
+        /// Called by a pool that crossed its watermark, costs one load when the committer is awake.
+        auto Wake() noexcept
+        {
+            m_waitStrategy.Unpark();
+        }
+
+        ~CPoolCommitter()
+        {
+            if (m_pThread)
+            {
+                m_isRunning = false;
+                Wake();
+                m_pThread->join();
+
+                delete m_pThread;
+                m_pThread = nullptr;
+            }
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CPoolCommitter(const CPoolCommitter &) = delete;
+
+        CPoolCommitter(const CPoolCommitter &&) = delete;
+
+        CPoolCommitter &operator=(const CPoolCommitter &) = delete;
+
+        CPoolCommitter &operator=(const CPoolCommitter &&) = delete;
+
+    private:
+        CPoolCommitter() = default;
+
+        auto Run() noexcept -> void
+        {
+            while (m_isRunning)
+            {
+                bool didWork = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    for (const auto &pool : m_pools)
+                    {
+                        didWork |= pool.commitAhead();
+                    }
+                }
+
+                m_waitStrategy.OnPoll(didWork);
+            }
+        }
+
+        struct SPool
+        {
+            const void           *pPool = nullptr;
+            std::function<bool()> commitAhead;
+        };
+
+        std::mutex         m_mutex;
+        std::vector<SPool> m_pools;
+
+        std::thread      *m_pThread = nullptr;
+        std::atomic<bool> m_isRunning = {false};
+
+        CWaitStrategy m_waitStrategy{EWaitStrategy::PARK};
+    };
+
+    /// Pool of up to numElems T objects with the same Allocate() / Deallocate() as CMemoryPool, for pools that are sized for the worst case but rarely fill up.
+    /// The address space for all numElems blocks is reserved up front, so objects never move, but memory is only committed (pre-faulted and mlock'd)
+    /// one chunk at a time as never used blocks are handed out. CPoolCommitter keeps preCommitChunks chunks committed ahead of the allocations.
+    /// The owner never commits itself: when it outruns the committer it spins until the committer catches up, counted in StallCount().
+    /// Freed blocks go on a LIFO intrusive free list exactly like CMemoryPool, never used blocks are only taken once the free list is empty.
+    template <typename T>
+    class CSegmentedMemoryPool final
+    {
+    public:
+        /// A named pool publishes how many of its blocks are in use as a CMetricsRegistry gauge, an empty name keeps it out of the registry.
+        explicit CSegmentedMemoryPool(std::size_t numElems, const std::string &name = "", size_t chunkBytes = POOL_CHUNK_BYTES,
+                                      size_t preCommitChunks = POOL_PRECOMMIT_CHUNKS)
+            : m_numElems(numElems)
+            , m_chunkBytes(RoundUpToPage(chunkBytes, SMALL_PAGE_SIZE))
+            , m_preCommitBytes(preCommitChunks * m_chunkBytes)
+            , m_reservedBytes(RoundUpToPage(numElems * sizeof(SObjectBlock), m_chunkBytes))
+            , m_isNamed(!name.empty())
+        {
+            // Reserve only, PROT_NONE and MAP_NORESERVE so none of it counts against memory until a chunk is committed.
+            auto p = MapAligned(m_reservedBytes, HUGE_PAGE_2MB_SIZE, PROT_NONE, MAP_NORESERVE, "Common::CSegmentedMemoryPool");
+            madvise(p, m_reservedBytes, MADV_HUGEPAGE);
+            m_pStore = reinterpret_cast<SObjectBlock *>(p);
+
+            {
+                std::lock_guard<std::mutex> lock(m_commitMutex);
+                CommitUntil(std::max(m_preCommitBytes, sizeof(SObjectBlock)));
+            }
+
+            CPoolCommitter::Instance().Register(this, [this]() { return CommitAhead(); });
+            if (m_isNamed)
+            {
+                CMetricsRegistry::Instance().Sample(this, name, [this]() { return static_cast<int64_t>(UsedCount()); });
+            }
+        }
+
+        ~CSegmentedMemoryPool()
+        {
+            if (m_isNamed)
+            {
+                CMetricsRegistry::Instance().Unsample(this);
+            }
+            CPoolCommitter::Instance().Unregister(this);
+            munmap(m_pStore, m_reservedBytes);
+        }
+
+        /// Allocate a new object of type T, use placement new to initialize the object, mark the block as in-use and return the object.
+        template <typename... Args>
+        T *Allocate(Args... args) noexcept
+        {
+            auto pObjBlock = m_pFreeHead;
+            if (LIKELY(pObjBlock != nullptr))
+            {
+                m_pFreeHead = pObjBlock->pNextFree;
+            }
+            else
+            {
+                pObjBlock = AllocateUnused();
+            }
+            ASSERT(pObjBlock->isFree, "Expected free SObjectBlock at index:" + std::to_string(pObjBlock - m_pStore));
+
+            T *pRet = &(pObjBlock->object);
+            pRet = new (pRet) T(args...); // placement new.
+            pObjBlock->isFree = false;
+            m_numUsed.store(m_numUsed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            return pRet;
+        }
+
+        /// Return the object back to the pool by pushing its block on the front of the free list.
+        /// Destructor is not called for the object.
+        auto Deallocate(const T *elem) noexcept
+        {
+            const auto elemIndex = (reinterpret_cast<const SObjectBlock *>(elem) - m_pStore);
+
+            ASSERT(elemIndex >= 0 && static_cast<size_t>(elemIndex) < m_nextUnusedIndex.load(std::memory_order_relaxed), "Element being deallocated does not belong to this Memory pool.");
+            PARANOID_ASSERT((reinterpret_cast<const char *>(elem) - reinterpret_cast<const char *>(m_pStore)) % sizeof(SObjectBlock) == 0,
+                            "Element being deallocated is not at the start of a SObjectBlock.");
+            ASSERT(!m_pStore[elemIndex].isFree, "Double free of SObjectBlock at index:" + std::to_string(elemIndex));
+
+            auto pObjBlock = &m_pStore[elemIndex];
+            pObjBlock->isFree = true;
+            pObjBlock->pNextFree = m_pFreeHead;
+            m_pFreeHead = pObjBlock;
+            m_numUsed.store(m_numUsed.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+
+        /// Blocks currently allocated, safe to read from any thread.
+        auto UsedCount() const noexcept
+        {
+            return m_numUsed.load(std::memory_order_relaxed);
+        }
+
+        auto ReservedBytes() const noexcept
+        {
+            return m_reservedBytes;
+        }
+
+        auto CommittedBytes() const noexcept
+        {
+            return m_committedBytes.load(std::memory_order_relaxed);
+        }
+
+        /// How many times the owner had to wait for the committer because it fell behind, non-zero means the watermark is too low.
+        auto StallCount() const noexcept
+        {
+            return m_stallCount.load(std::memory_order_relaxed);
+        }
+
+        // Deleted default, copy & move constructors and assignment-operators.
+        CSegmentedMemoryPool() = delete;
+
+        CSegmentedMemoryPool(const CSegmentedMemoryPool &) = delete;
+
+        CSegmentedMemoryPool(const CSegmentedMemoryPool &&) = delete;
+
+        CSegmentedMemoryPool &operator=(const CSegmentedMemoryPool &) = delete;
+
+        CSegmentedMemoryPool &operator=(const CSegmentedMemoryPool &&) = delete;
+
+    private:
+        /// Same layout as CMemoryPool's, the free list link reuses the storage of the dead object.
+        struct SObjectBlock
+        {
+            union
+            {
+                T object;
+                SObjectBlock *pNextFree;
+            };
+            bool isFree = true;
+
+            SObjectBlock() : pNextFree(nullptr)
+            {
+            }
+
+            ~SObjectBlock()
+            {
+            }
+        };
+
+        /// Free list is empty, hand out the first never used block, waiting for the committer if it has not committed its chunk yet.
+        auto AllocateUnused() noexcept -> SObjectBlock *
+        {
+            const auto index = m_nextUnusedIndex.load(std::memory_order_relaxed);
+            ASSERT(index != m_numElems, "Memory Pool out of space.");
+
+            const auto usedBytes = (index + 1) * sizeof(SObjectBlock);
+            if (UNLIKELY(usedBytes > m_committedBytes.load(std::memory_order_acquire)))
+            {
+                WaitForCommit(usedBytes);
+            }
+            m_nextUnusedIndex.store(index + 1, std::memory_order_relaxed);
+
+            if (usedBytes + m_preCommitBytes > m_committedBytes.load(std::memory_order_relaxed) && !m_isCommitRequested.load(std::memory_order_relaxed))
+            {
+                m_isCommitRequested.store(true, std::memory_order_release);
+                CPoolCommitter::Instance().Wake();
+            }
+
+            return new (&m_pStore[index]) SObjectBlock();
+        }
+
+        /// The owner outran the committer. Rather than take m_commitMutex and make the mprotect / mlock calls on its own thread, it asks the
+        /// committer for the chunk and spins until it is there. Cold, a well sized watermark keeps StallCount() at zero.
+        __attribute__((cold, noinline)) auto WaitForCommit(size_t bytes) noexcept -> void
+        {
+            m_stallCount.store(m_stallCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            m_isCommitRequested.store(true, std::memory_order_release);
+            CPoolCommitter::Instance().Wake();
+
+            while (m_committedBytes.load(std::memory_order_acquire) < bytes)
+            {
+                _mm_pause();
+            }
+        }
+
+        /// Run on the CPoolCommitter thread. The request is cleared before committing, so one raised meanwhile is seen on the next pass.
+        /// Commits past the block the owner is about to hand out, which WaitForCommit() may be spinning on.
+        auto CommitAhead() noexcept
+        {
+            if (!m_isCommitRequested.exchange(false, std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(m_commitMutex);
+            CommitUntil((m_nextUnusedIndex.load(std::memory_order_relaxed) + 1) * sizeof(SObjectBlock) + m_preCommitBytes);
+
+            return true;
+        }
+
+        /// Commit whole chunks until at least bytes are committed or the reservation is exhausted, m_commitMutex must be held.
+        auto CommitUntil(size_t bytes) noexcept -> void
+        {
+            auto committedBytes = m_committedBytes.load(std::memory_order_relaxed);
+            while (committedBytes < std::min(bytes, m_reservedBytes))
+            {
+                auto p = reinterpret_cast<char *>(m_pStore) + committedBytes;
+                const auto chunkBytes = std::min(m_chunkBytes, m_reservedBytes - committedBytes);
+                if (mprotect(p, chunkBytes, PROT_READ | PROT_WRITE) != 0)
+                {
+                    FATAL("mprotect() of " + std::to_string(chunkBytes) + " bytes failed for Common::CSegmentedMemoryPool error:" + std::string(std::strerror(errno)));
+                }
+                PrefaultPages(p, chunkBytes);
+                mlock(p, chunkBytes);
+
+                committedBytes += chunkBytes;
+                m_committedBytes.store(committedBytes, std::memory_order_release);
+            }
+        }
+
+        const size_t m_numElems;
+        const size_t m_chunkBytes;
+        const size_t m_preCommitBytes;
+        const size_t m_reservedBytes;
+
+        /// Start of the reservation, blocks [0, m_nextUnusedIndex) have been handed out at least once.
+        SObjectBlock *m_pStore = nullptr;
+
+        /// Most recently freed block, nullptr when every block handed out so far is in use.
+        SObjectBlock *m_pFreeHead = nullptr;
+
+        /// Written only by the owner, atomic so the committer can read how far ahead it has to commit.
+        std::atomic<size_t> m_nextUnusedIndex = {0};
+
+        /// Written only under m_commitMutex, by the constructor and then only by the committer.
+        std::atomic<size_t> m_committedBytes = {0};
+        std::atomic<bool>   m_isCommitRequested = {false};
+        std::atomic<size_t> m_stallCount = {0};
+        std::mutex          m_commitMutex;
+
+        /// Written only by the owner, atomic so the registry thread can sample it.
+        std::atomic<size_t> m_numUsed = {0};
+        const bool          m_isNamed;
+    };
+}
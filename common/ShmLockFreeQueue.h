@@ -0,0 +1,340 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Macros.h"
+#include "RingSlots.h"
+
+namespace OptCommon
+{
+    /// Bumped every time the shared memory layout below changes, so binaries built against different layouts refuse to attach.
+    constexpr uint32_t SHM_QUEUE_LAYOUT_VERSION = 1;
+
+    /// Identifies a segment created by CShmLockFreeQueue, "ULLSHMQ\0" in little endian.
+    constexpr uint64_t SHM_QUEUE_MAGIC = 0x00514d48534c4c55;
+
+    /// How a process obtains the shared memory segment backing the queue.
+    enum class EShmQueueMode : int8_t
+    {
+        CREATE = 0, /// Create (or recreate) the segment, initialize it and publish it to attaching processes.
+        ATTACH = 1  /// Wait for another process to create the segment and attach to it after validating the layout.
+    };
+
+    /// Single producer / single consumer lock free queue living in a named POSIX shared memory segment (/dev/shm/<name>),
+    /// so the producer and the consumer can be separate processes.
+    /// Exposes the same API as COptLockFreeQueue and uses the same cache-line isolated producer / consumer indices.
+    ///
+    /// Startup handshake:
+    /// - the creating process sizes and initializes the segment, then stores SHM_QUEUE_READY in the header with release semantics,
+    /// - an attaching process waits for the segment and the ready flag and then checks magic, layout version, element size / alignment and capacity,
+    ///   any mismatch is FATAL instead of silently reading garbage.
+    template <typename T>
+    class CShmLockFreeQueue final
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Elements are shared across processes so they must be trivially copyable.");
+
+    public:
+        /// A run of consecutive slots in the ring, split in two spans when it wraps around the end of the buffer.
+        template <typename U>
+        using SSlots = OptCommon::SSlots<U>;
+
+        /// numElements is only used in EShmQueueMode::CREATE, an attaching process takes the capacity from the header.
+        /// Attaching waits at most attachTimeoutSecs for the creator to publish the segment.
+        CShmLockFreeQueue(const std::string &name, EShmQueueMode mode, std::size_t numElements = 0, int attachTimeoutSecs = 30)
+            : m_name(name[0] == '/' ? name : "/" + name)
+            , m_mode(mode)
+        {
+            if (mode == EShmQueueMode::CREATE)
+            {
+                Create(std::bit_ceil(numElements));
+            }
+            else
+            {
+                Attach(attachTimeoutSecs);
+            }
+
+            m_pStore = reinterpret_cast<T *>(reinterpret_cast<char *>(m_pHeader) + StoreOffset());
+            m_mask = m_pHeader->capacity - 1;
+        }
+
+        /// The creator unlinks the name so a restarted creator starts from a fresh segment, attached processes keep their mapping until they exit.
+        ~CShmLockFreeQueue()
+        {
+            if (m_mode == EShmQueueMode::ATTACH)
+            {
+                m_pHeader->attached.store(0, std::memory_order_release);
+            }
+
+            munmap(m_pHeader, m_mapSize);
+            if (m_mode == EShmQueueMode::CREATE)
+            {
+                shm_unlink(m_name.c_str());
+            }
+        }
+
+        /// Block until another process has attached to this segment.
+        auto WaitForPeer() const noexcept
+        {
+            while (!m_pHeader->attached.load(std::memory_order_acquire))
+            {
+                using namespace std::literals::chrono_literals;
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+
+        /// Spins while the queue is full instead of overwriting elements the consumer has not read yet.
+        auto GetNextToWriteTo() noexcept
+        {
+            auto &producer = m_pHeader->producer;
+            const auto writeIndex = producer.writeIndex.load(std::memory_order_relaxed);
+            while (UNLIKELY(writeIndex - producer.cachedReadIndex == m_pHeader->capacity))
+            {
+                producer.cachedReadIndex = m_pHeader->consumer.readIndex.load(std::memory_order_acquire);
+            }
+
+            return &m_pStore[writeIndex & m_mask];
+        }
+
+        auto UpdateWriteIndex() noexcept
+        {
+            auto &producer = m_pHeader->producer;
+            producer.writeIndex.store(producer.writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        auto GetNextToRead() const noexcept -> const T *
+        {
+            auto &consumer = m_pHeader->consumer;
+            const auto readIndex = consumer.readIndex.load(std::memory_order_relaxed);
+            if (readIndex == consumer.cachedWriteIndex)
+            {
+                consumer.cachedWriteIndex = m_pHeader->producer.writeIndex.load(std::memory_order_acquire);
+                if (readIndex == consumer.cachedWriteIndex)
+                {
+                    return nullptr;
+                }
+            }
+
+            return &m_pStore[readIndex & m_mask];
+        }
+
+        auto UpdateReadIndex() noexcept
+        {
+            auto &consumer = m_pHeader->consumer;
+            const auto readIndex = consumer.readIndex.load(std::memory_order_relaxed);
+            DEBUG_ASSERT(readIndex != consumer.cachedWriteIndex, "Read an invalid element in:" + m_name);
+            consumer.readIndex.store(readIndex + 1, std::memory_order_release);
+        }
+
+        /// Reserve min(count, capacity()) slots for a burst of writes, spinning until all of them are free.
+        /// Nothing becomes visible to the consumer until CommitWrite() publishes the whole batch with a single index update.
+        auto ReserveWrite(size_t count) noexcept -> SSlots<T>
+        {
+            auto &producer = m_pHeader->producer;
+            count = std::min(count, capacity());
+            const auto writeIndex = producer.writeIndex.load(std::memory_order_relaxed);
+            while (UNLIKELY(writeIndex + count - producer.cachedReadIndex > capacity()))
+            {
+                producer.cachedReadIndex = m_pHeader->consumer.readIndex.load(std::memory_order_acquire);
+            }
+
+            return Slice(m_pStore, writeIndex, count);
+        }
+
+        auto CommitWrite(size_t count) noexcept
+        {
+            auto &producer = m_pHeader->producer;
+            producer.writeIndex.store(producer.writeIndex.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /// Return up to maxCount elements that are ready to be read, without consuming them.
+        auto PeekRead(size_t maxCount) const noexcept -> SSlots<const T>
+        {
+            auto &consumer = m_pHeader->consumer;
+            const auto readIndex = consumer.readIndex.load(std::memory_order_relaxed);
+            if (readIndex + maxCount > consumer.cachedWriteIndex)
+            {
+                consumer.cachedWriteIndex = m_pHeader->producer.writeIndex.load(std::memory_order_acquire);
+            }
+
+            return Slice(static_cast<const T *>(m_pStore), readIndex, std::min(maxCount, consumer.cachedWriteIndex - readIndex));
+        }
+
+        /// Consume the first count elements returned by PeekRead() with a single index update.
+        auto ReleaseRead(size_t count) noexcept
+        {
+            auto &consumer = m_pHeader->consumer;
+            const auto readIndex = consumer.readIndex.load(std::memory_order_relaxed);
+            DEBUG_ASSERT(readIndex + count <= consumer.cachedWriteIndex, "Released more elements than were read in:" + m_name);
+            consumer.readIndex.store(readIndex + count, std::memory_order_release);
+        }
+
+        /// Read index is loaded first so the result can never underflow, it only ever lags behind the true size.
+        auto size() const noexcept
+        {
+            const auto readIndex = m_pHeader->consumer.readIndex.load(std::memory_order_acquire);
+            return m_pHeader->producer.writeIndex.load(std::memory_order_acquire) - readIndex;
+        }
+
+        auto capacity() const noexcept -> size_t
+        {
+            return m_pHeader->capacity;
+        }
+
+        /// Deleted default, copy & move constructors and assignment-operators.
+        CShmLockFreeQueue() = delete;
+
+        CShmLockFreeQueue(const CShmLockFreeQueue &) = delete;
+
+        CShmLockFreeQueue(const CShmLockFreeQueue &&) = delete;
+
+        CShmLockFreeQueue &operator=(const CShmLockFreeQueue &) = delete;
+
+        CShmLockFreeQueue &operator=(const CShmLockFreeQueue &&) = delete;
+
+    private:
+        static constexpr uint32_t SHM_QUEUE_READY = 1;
+
+        /// Layout of the start of the shared memory segment, elements follow at StoreOffset().
+        /// Only lock free atomics and plain integers so both processes agree on the representation.
+        struct SHeader
+        {
+            /// Written once by the creator, then read-only.
+            uint64_t magic = 0;
+            uint32_t layoutVersion = 0;
+            uint32_t elementSize = 0;
+            uint32_t elementAlign = 0;
+            uint64_t capacity = 0;
+
+            /// Handshake flags, ready is published by the creator last, attached by the peer.
+            std::atomic<uint32_t> ready = {0};
+            std::atomic<uint32_t> attached = {0};
+
+            /// Written only by the producer process, the consumer reads writeIndex when its cached copy runs out.
+            struct alignas(CACHE_LINE_SIZE) SProducerState
+            {
+                std::atomic<size_t> writeIndex = {0};
+                size_t cachedReadIndex = 0;
+            } producer;
+
+            /// Written only by the consumer process, the producer reads readIndex when its cached copy says the queue is full.
+            struct alignas(CACHE_LINE_SIZE) SConsumerState
+            {
+                std::atomic<size_t> readIndex = {0};
+                size_t cachedWriteIndex = 0;
+            } consumer;
+        };
+
+        static_assert(std::atomic<size_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                      "Atomics shared across processes must be lock free.");
+
+        static constexpr auto StoreOffset() noexcept -> size_t
+        {
+            constexpr auto align = std::max(alignof(T), CACHE_LINE_SIZE);
+            return (sizeof(SHeader) + align - 1) / align * align;
+        }
+
+        auto Create(size_t capacity) noexcept -> void
+        {
+            // Remove a stale segment left behind by a crashed creator, attached processes of the old segment keep their own mapping.
+            shm_unlink(m_name.c_str());
+
+            const auto fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+            ASSERT(fd >= 0, "shm_open() failed for:" + m_name + " error:" + std::string(std::strerror(errno)));
+
+            m_mapSize = StoreOffset() + capacity * sizeof(T);
+            ASSERT(ftruncate(fd, m_mapSize) == 0, "ftruncate() failed for:" + m_name + " error:" + std::string(std::strerror(errno)));
+
+            Map(fd);
+
+            m_pHeader = new (m_pHeader) SHeader();
+            m_pHeader->magic = SHM_QUEUE_MAGIC;
+            m_pHeader->layoutVersion = SHM_QUEUE_LAYOUT_VERSION;
+            m_pHeader->elementSize = sizeof(T);
+            m_pHeader->elementAlign = alignof(T);
+            m_pHeader->capacity = capacity;
+            std::uninitialized_value_construct_n(reinterpret_cast<T *>(reinterpret_cast<char *>(m_pHeader) + StoreOffset()), capacity);
+
+            m_pHeader->ready.store(SHM_QUEUE_READY, std::memory_order_release);
+        }
+
+        auto Attach(int timeoutSecs) noexcept -> void
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSecs);
+            auto waitOrFail = [&](const std::string &what)
+            {
+                ASSERT(std::chrono::steady_clock::now() < deadline, "Timed out waiting for " + what + " of:" + m_name);
+
+                using namespace std::literals::chrono_literals;
+                std::this_thread::sleep_for(1ms);
+            };
+
+            // Wait for the creator to create the segment and size it past the header.
+            int fd = -1;
+            struct stat st = {};
+            while ((fd = shm_open(m_name.c_str(), O_RDWR, 0)) < 0 || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < StoreOffset())
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                waitOrFail("segment");
+            }
+
+            m_mapSize = st.st_size;
+            Map(fd);
+
+            while (m_pHeader->ready.load(std::memory_order_acquire) != SHM_QUEUE_READY)
+            {
+                waitOrFail("ready flag");
+            }
+
+            ASSERT(m_pHeader->magic == SHM_QUEUE_MAGIC, "Not a CShmLockFreeQueue segment:" + m_name);
+            ASSERT(m_pHeader->layoutVersion == SHM_QUEUE_LAYOUT_VERSION,
+                   "Layout version mismatch for:" + m_name + " segment:" + std::to_string(m_pHeader->layoutVersion) + " binary:" + std::to_string(SHM_QUEUE_LAYOUT_VERSION));
+            ASSERT(m_pHeader->elementSize == sizeof(T) && m_pHeader->elementAlign == alignof(T),
+                   "Element type mismatch for:" + m_name + " segment size:" + std::to_string(m_pHeader->elementSize) + " binary size:" + std::to_string(sizeof(T)));
+            ASSERT(std::has_single_bit(m_pHeader->capacity) && m_mapSize == StoreOffset() + m_pHeader->capacity * sizeof(T),
+                   "Corrupt capacity for:" + m_name + " capacity:" + std::to_string(m_pHeader->capacity));
+
+            m_pHeader->attached.store(1, std::memory_order_release);
+        }
+
+        auto Map(int fd) noexcept -> void
+        {
+            void *pMap = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            ASSERT(pMap != MAP_FAILED, "mmap() failed for:" + m_name + " error:" + std::string(std::strerror(errno)));
+
+            m_pHeader = static_cast<SHeader *>(pMap);
+        }
+
+        template <typename U>
+        auto Slice(U *pBase, size_t index, size_t count) const noexcept -> SSlots<U>
+        {
+            return SliceRing(pBase, m_mask, index, count);
+        }
+
+        const std::string   m_name;
+        const EShmQueueMode m_mode;
+
+        /// Process local view of the mapping, the segment itself holds all the shared state.
+        SHeader *m_pHeader = nullptr;
+        T       *m_pStore = nullptr;
+        size_t   m_mask = 0;
+        size_t   m_mapSize = 0;
+    };
+}
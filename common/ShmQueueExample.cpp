@@ -0,0 +1,60 @@
+#include <sys/wait.h>
+
+#include "ShmLockFreeQueue.h"
+
+struct MyStruct
+{
+    int data[3];
+};
+
+using namespace OptCommon;
+
+/// Runs in a forked child process, attaches to the queue created by the parent and reads everything it writes.
+auto ConsumeFunction()
+{
+    CShmLockFreeQueue<MyStruct> lfq("shm_queue_example", EShmQueueMode::ATTACH);
+
+    for (auto i = 0; i < 50;)
+    {
+        const auto d = lfq.GetNextToRead();
+        if (!d)
+        {
+            continue;
+        }
+
+        std::cout << "ConsumeFunction read elem:" << d->data[0] << "," << d->data[1] << "," << d->data[2] << " lfq-size:" << lfq.size() << std::endl;
+        lfq.UpdateReadIndex();
+        ++i;
+    }
+
+    std::cout << "ConsumeFunction exiting." << std::endl;
+}
+
+int main(int, char **)
+{
+    const auto pid = fork();
+    ASSERT(pid >= 0, "fork() failed.");
+    if (pid == 0)
+    {
+        ConsumeFunction();
+        return 0;
+    }
+
+    CShmLockFreeQueue<MyStruct> lfq("shm_queue_example", EShmQueueMode::CREATE, 20);
+    lfq.WaitForPeer();
+
+    for (auto i = 0; i < 50; ++i)
+    {
+        const MyStruct d{i, i * 10, i * 100};
+        *(lfq.GetNextToWriteTo()) = d;
+        lfq.UpdateWriteIndex();
+
+        std::cout << "main constructed elem:" << d.data[0] << "," << d.data[1] << "," << d.data[2] << " lfq-size:" << lfq.size() << std::endl;
+    }
+
+    waitpid(pid, nullptr, 0);
+
+    std::cout << "main exiting." << std::endl;
+
+    return 0;
+}
@@ -6,12 +6,11 @@ int main(int, char **)
 {
     using namespace Common;
 
-    std::string m_timeStr;
     CLogger m_logger("socket_example.log");
 
     auto tcpServerRecvCallback = [&](CTCPSocket *socket, Nanos rx_time) noexcept
     {
-        m_logger.Log("CTCPServer::DefaultRecvCallback() socket:% len:% rx:%\n",
+        m_logger.Log(LOG_FORMAT("CTCPServer::DefaultRecvCallback() socket:% len:% rx:%\n"),
                     socket->m_fd, socket->m_nextRecvValidIndex, rx_time);
 
         const std::string reply = "CTCPServer received msg:" + std::string(socket->m_pRecvBuffer, socket->m_nextRecvValidIndex);
@@ -22,7 +21,7 @@ int main(int, char **)
 
     auto tcpServerRecvFinishedCallback = [&]() noexcept
     {
-        m_logger.Log("CTCPServer::DefaultRecvFinishedCallback()\n");
+        m_logger.Log(LOG_FORMAT("CTCPServer::DefaultRecvFinishedCallback()\n"));
     };
 
     auto tcpClientRecvCallback = [&](CTCPSocket *socket, Nanos rx_time) noexcept
@@ -30,7 +29,7 @@ int main(int, char **)
         const std::string recv_msg = std::string(socket->m_pRecvBuffer, socket->m_nextRecvValidIndex);
         socket->m_nextRecvValidIndex = 0;
 
-        m_logger.Log("CTCPSocket::DefaultRecvCallback() socket:% len:% rx:% msg:%\n",
+        m_logger.Log(LOG_FORMAT("CTCPSocket::DefaultRecvCallback() socket:% len:% rx:% msg:%\n"),
                     socket->m_fd, socket->m_nextRecvValidIndex, rx_time, recv_msg);
     };
 
@@ -38,7 +37,7 @@ int main(int, char **)
     const std::string ip = "127.0.0.1";
     const int port = 12345;
 
-    m_logger.Log("Creating CTCPServer on iface:% port:%\n", iface, port);
+    m_logger.Log(LOG_FORMAT("Creating CTCPServer on iface:% port:%\n"), iface, port);
     CTCPServer server(m_logger);
     server.m_recvCallback = tcpServerRecvCallback;
     server.m_recvFinishedCallback = tcpServerRecvFinishedCallback;
@@ -51,7 +50,7 @@ int main(int, char **)
         clients[i] = new CTCPSocket(m_logger);
         clients[i]->m_recvCallback = tcpClientRecvCallback;
 
-        m_logger.Log("Connecting TCPClient-[%] on ip:% iface:% port:%\n", i, ip, iface, port);
+        m_logger.Log(LOG_FORMAT("Connecting TCPClient-[%] on ip:% iface:% port:%\n"), i, ip, iface, port);
         clients[i]->connect(ip, iface, port, false);
         server.Poll();
     }
@@ -63,7 +62,7 @@ int main(int, char **)
         for (size_t i = 0; i < clients.size(); ++i)
         {
             const std::string client_msg = "CLIENT-[" + std::to_string(i) + "] : Sending " + std::to_string(itr * 100 + i);
-            m_logger.Log("Sending TCPClient-[%] %\n", i, client_msg);
+            m_logger.Log(LOG_FORMAT("Sending TCPClient-[%] %\n"), i, client_msg);
             clients[i]->Send(client_msg.data(), client_msg.length());
             clients[i]->SendAndRecv();
 
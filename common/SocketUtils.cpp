@@ -81,11 +81,10 @@ namespace Common
     auto CreateSocket(CLogger &logger, const std::string &t_ip, const std::string &iface, int port,
                       bool is_udp, bool is_blocking, bool is_listening, int ttl, bool needs_so_timestamp) -> int
     {
-        std::string time_str;
 
         const auto ip = t_ip.empty() ? GetIFaceIP(iface) : t_ip;
-        logger.Log("%:% %() % ip:% iface:% port:% is_udp:% is_blocking:% is_listening:% ttl:% SO_time:%\n", __FILE__, __LINE__, __FUNCTION__,
-                   Common::GetCurrentTimeStr(&time_str), ip, iface, port, is_udp, is_blocking, is_listening, ttl, needs_so_timestamp);
+        LOG_INFO(logger, "%:% %() ip:% iface:% port:% is_udp:% is_blocking:% is_listening:% ttl:% SO_time:%\n", __FILE__, __LINE__, __FUNCTION__,
+                   ip, iface, port, is_udp, is_blocking, is_listening, ttl, needs_so_timestamp);
 
         addrinfo hints{};
         hints.ai_family = AF_INET;
@@ -100,7 +99,7 @@ namespace Common
         const auto rc = getaddrinfo(ip.c_str(), std::to_string(port).c_str(), &hints, &result);
         if (rc)
         {
-            logger.Log("getaddrinfo() failed. error:% errno:%\n", gai_strerror(rc), strerror(errno));
+            LOG_ERROR(logger, "getaddrinfo() failed. error:% errno:%\n", gai_strerror(rc), strerror(errno));
             return -1;
         }
 
@@ -111,31 +110,31 @@ namespace Common
             fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
             if (fd == -1)
             {
-                logger.Log("socket() failed. errno:%\n", strerror(errno));
+                LOG_ERROR(logger, "socket() failed. errno:%\n", strerror(errno));
                 return -1;
             }
             if (!is_blocking)
             {
                 if (!SetNonBlocking(fd))
                 { // set the socket to be non-blocking.
-                    logger.Log("SetNonBlocking() failed. errno:%\n", strerror(errno));
+                    LOG_ERROR(logger, "SetNonBlocking() failed. errno:%\n", strerror(errno));
                     return -1;
                 }
 
                 if (!is_udp && !SetNoDelay(fd))
                 { // disable Nagle for TCP sockets.
-                    logger.Log("SetNoDelay() failed. errno:%\n", strerror(errno));
+                    LOG_ERROR(logger, "SetNoDelay() failed. errno:%\n", strerror(errno));
                     return -1;
                 }
             }
             if (!is_listening && connect(fd, rp->ai_addr, rp->ai_addrlen) == 1 && !WouldBlock())
             { // establish connection to specified address.
-                logger.Log("connect() failed. errno:%\n", strerror(errno));
+                LOG_ERROR(logger, "connect() failed. errno:%\n", strerror(errno));
                 return -1;
             }
             if (is_listening && setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&one), sizeof(one)) == -1)
             { // allow re-using the address in the call to bind()
-                logger.Log("setsockopt() SO_REUSEADDR failed. errno:%\n", strerror(errno));
+                LOG_ERROR(logger, "setsockopt() SO_REUSEADDR failed. errno:%\n", strerror(errno));
                 return -1;
             }
             if (is_listening)
@@ -149,19 +148,19 @@ namespace Common
                 // bind to the specified port number.
                 if (is_udp && bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
                 {
-                    logger.Log("bind() failed. errno:%\n", strerror(errno));
+                    LOG_ERROR(logger, "bind() failed. errno:%\n", strerror(errno));
                     return -1;
                 }
                 else if (!is_udp && bind(fd, rp->ai_addr, rp->ai_addrlen) == -1)
                 {
-                    logger.Log("bind() failed. errno:%\n", strerror(errno));
+                    LOG_ERROR(logger, "bind() failed. errno:%\n", strerror(errno));
                     return -1;
                 }
             }
 
             if (!is_udp && is_listening && listen(fd, MaxTCPServerBacklog) == -1)
             { // listen for incoming TCP connections.
-                logger.Log("listen() failed. errno:%\n", strerror(errno));
+                LOG_ERROR(logger, "listen() failed. errno:%\n", strerror(errno));
                 return -1;
             }
             if (is_udp && ttl)
@@ -169,18 +168,18 @@ namespace Common
                 const bool is_multicast = atoi(ip.c_str()) & 0xe0;
                 if (is_multicast && !SetMultiCastTTL(fd, ttl))
                 {
-                    logger.Log("SetMultiCastTTL() failed. errno:%\n", strerror(errno));
+                    LOG_ERROR(logger, "SetMultiCastTTL() failed. errno:%\n", strerror(errno));
                     return -1;
                 }
                 if (!is_multicast && !SetTTL(fd, ttl))
                 {
-                    logger.Log("SetTTL() failed. errno:%\n", strerror(errno));
+                    LOG_ERROR(logger, "SetTTL() failed. errno:%\n", strerror(errno));
                     return -1;
                 }
             }
             if (needs_so_timestamp && !SetSOTimestamp(fd))
             { // enable software receive timestamps.
-                logger.Log("SetSOTimestamp() failed. errno:%\n", strerror(errno));
+                LOG_ERROR(logger, "SetSOTimestamp() failed. errno:%\n", strerror(errno));
                 return -1;
             }
         }
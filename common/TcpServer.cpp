@@ -37,7 +37,7 @@ namespace Common
     }
 
     /// Publish outgoing data from the send buffer and read incoming data from the receive buffer.
-    auto CTCPServer::SendAndRecv() noexcept -> void
+    auto CTCPServer::SendAndRecv() noexcept -> bool
     {
         bool recv = false;
 
@@ -53,6 +53,8 @@ namespace Common
         {
             pSocket->SendAndRecv();
         }
+
+        return recv;
     }
 
     auto CTCPServer::Del(CTCPSocket *pSocket)
@@ -87,25 +89,25 @@ namespace Common
             {
                 if (pSocket == &m_listenerSocket)
                 {
-                    m_logger.Log("%:% %() % EPOLLIN listener_socket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), pSocket->m_fd);
+                    LOG_TRACE(m_logger, "%:% %() EPOLLIN listener_socket:%\n", __FILE__, __LINE__, __FUNCTION__, pSocket->m_fd);
                     have_new_connection = true;
                     continue;
                 }
-                m_logger.Log("%:% %() % EPOLLIN pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), pSocket->m_fd);
+                LOG_TRACE(m_logger, "%:% %() EPOLLIN pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, pSocket->m_fd);
                 if (std::find(m_receiveSockets.begin(), m_receiveSockets.end(), pSocket) == m_receiveSockets.end())
                     m_receiveSockets.push_back(pSocket);
             }
 
             if (event.events & EPOLLOUT)
             {
-                m_logger.Log("%:% %() % EPOLLOUT pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), pSocket->m_fd);
+                LOG_TRACE(m_logger, "%:% %() EPOLLOUT pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, pSocket->m_fd);
                 if (std::find(m_sendSockets.begin(), m_sendSockets.end(), pSocket) == m_sendSockets.end())
                     m_sendSockets.push_back(pSocket);
             }
 
             if (event.events & (EPOLLERR | EPOLLHUP))
             {
-                m_logger.Log("%:% %() % EPOLLERR pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), pSocket->m_fd);
+                LOG_WARN(m_logger, "%:% %() EPOLLERR pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, pSocket->m_fd);
                 if (std::find(m_receiveSockets.begin(), m_receiveSockets.end(), pSocket) == m_receiveSockets.end())
                     m_receiveSockets.push_back(pSocket);
             }
@@ -114,7 +116,7 @@ namespace Common
         // Accept a new connection, create a CTCPSocket and add it to our containers.
         while (have_new_connection)
         {
-            m_logger.Log("%:% %() % have_new_connection\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_INFO(m_logger, "%:% %() have_new_connection\n", __FILE__, __LINE__, __FUNCTION__);
             sockaddr_storage addr;
             socklen_t addr_len = sizeof(addr);
             int fd = accept(m_listenerSocket.m_fd, reinterpret_cast<sockaddr *>(&addr), &addr_len);
@@ -123,7 +125,7 @@ namespace Common
 
             ASSERT(SetNonBlocking(fd) && SetNoDelay(fd), "Failed to set non-blocking or no-delay on pSocket:" + std::to_string(fd));
 
-            m_logger.Log("%:% %() % accepted pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), fd);
+            LOG_INFO(m_logger, "%:% %() accepted pSocket:%\n", __FILE__, __LINE__, __FUNCTION__, fd);
 
             CTCPSocket *pSocket = new CTCPSocket(m_logger);
             pSocket->m_fd = fd;
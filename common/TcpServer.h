@@ -9,12 +9,12 @@ namespace Common
         /// Methods to initialize member function wrappers.
         auto DefaultRecvCallback(CTCPSocket* pSocket, Nanos rx_time) noexcept
         {
-            m_logger.Log("%:% %() % CTCPServer::DefaultRecvCallback() socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), pSocket->m_fd, pSocket->m_nextRecvValidIndex, rx_time);
+            LOG_TRACE(m_logger, "%:% %() CTCPServer::DefaultRecvCallback() socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, pSocket->m_fd, pSocket->m_nextRecvValidIndex, rx_time);
         }
 
         auto DefaultRecvFinishedCallback() noexcept
         {
-            m_logger.Log("%:% %() % CTCPServer::DefaultRecvFinishedCallback()\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_TRACE(m_logger, "%:% %() CTCPServer::DefaultRecvFinishedCallback()\n", __FILE__, __LINE__, __FUNCTION__);
         }
 
         explicit CTCPServer(CLogger& logger)
@@ -41,7 +41,8 @@ namespace Common
         auto Poll() noexcept -> void;
 
         /// Publish outgoing data from the send buffer and read incoming data from the receive buffer.
-        auto SendAndRecv() noexcept -> void;
+        /// Returns true if any data was received.
+        auto SendAndRecv() noexcept -> bool;
 
     private:
         /// Add and remove pSocket file descriptors to and from the EPOLL list.
@@ -70,7 +71,6 @@ namespace Common
         /// Function wrapper to call back when all data across all TCPSockets has been read and dispatched this round.
         std::function<void()> m_recvFinishedCallback;
 
-        std::string m_timeStr;
-        CLogger&    m_logger;
+        CLogger& m_logger;
     };
 }
@@ -56,11 +56,12 @@ namespace Common
                 kernel_time = time_kernel.tv_sec * NANOS_TO_SECS + time_kernel.tv_usec * NANOS_TO_MICROS; // convert timestamp to nanoseconds.
             }
 
-            const auto user_time = GetCurrentNanos();
+            const auto user_time = CTscClock::Instance().Now();
 
-            m_logger.Log("%:% %() % read socket:% len:% utime:% ktime:% diff:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::GetCurrentTimeStr(&m_timeStr), m_fd, m_nextRecvValidIndex, user_time, kernel_time, (user_time - kernel_time));
-            m_recvCallback(this, kernel_time);
+            LOG_TRACE(m_logger, "%:% %() read socket:% len:% utime:% ktime:% diff:%\n", __FILE__, __LINE__, __FUNCTION__,
+                        m_fd, m_nextRecvValidIndex, user_time, kernel_time, (user_time - kernel_time));
+            // Without a kernel timestamp fall back to when we read the data, on the same wall clock.
+            m_recvCallback(this, kernel_time ? kernel_time : user_time);
         }
 
         ssize_t n_send = std::min(TCPBufferSize, m_nextSendValidIndex);
@@ -78,7 +79,7 @@ namespace Common
                 break;
             }
 
-            m_logger.Log("%:% %() % send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), m_fd, n);
+            LOG_TRACE(m_logger, "%:% %() send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, m_fd, n);
 
             n_send -= n;
             ASSERT(n == n_send_this_msg, "Don't support partial send lengths yet.");
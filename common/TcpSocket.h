@@ -2,6 +2,7 @@
 
 #include <functional>
 
+#include "HugePages.h"
 #include "SocketUtils.h"
 #include "Logging.h"
 
@@ -15,15 +16,15 @@ namespace Common
         /// Default callback to be used to receive and process data.
         auto DefaultRecvCallback(CTCPSocket *socket, Nanos rx_time) noexcept
         {
-            m_logger.Log("%:% %() % CTCPSocket::DefaultRecvCallback() socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::GetCurrentTimeStr(&m_timeStr), socket->m_fd, socket->m_nextRecvValidIndex, rx_time);
+            LOG_TRACE(m_logger, "%:% %() CTCPSocket::DefaultRecvCallback() socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__,
+                        socket->m_fd, socket->m_nextRecvValidIndex, rx_time);
         }
 
         explicit CTCPSocket(CLogger& logger)
             : m_logger(logger)
         {
-            m_pSendBuffer = new char[TCPBufferSize];
-            m_pRecvBuffer = new char[TCPBufferSize];
+            m_pSendBuffer = static_cast<char *>(AllocateHugePages(TCPBufferSize, "Common::CTCPSocket send buffer"));
+            m_pRecvBuffer = static_cast<char *>(AllocateHugePages(TCPBufferSize, "Common::CTCPSocket recv buffer"));
             m_recvCallback = [this](auto socket, auto rx_time)
             {
                 DefaultRecvCallback(socket, rx_time);
@@ -36,10 +37,10 @@ namespace Common
         {
             Destroy();
 
-            delete[] m_pSendBuffer;
+            FreeHugePages(m_pSendBuffer);
             m_pSendBuffer = nullptr;
             
-            delete[] m_pRecvBuffer;
+            FreeHugePages(m_pRecvBuffer);
             m_pRecvBuffer = nullptr;
         }
 
@@ -78,7 +79,6 @@ namespace Common
         /// Function wrapper to callback when there is data to be processed.
         std::function<void(CTCPSocket *s, Nanos rx_time)> m_recvCallback;
 
-        std::string m_timeStr;
-        CLogger&    m_logger;
+        CLogger& m_logger;
     };
 }
@@ -7,6 +7,8 @@
 
 #include <sys/syscall.h>
 
+#include "WaitStrategy.h"
+
 namespace Common
 {
     /// Set affinity for current thread to be pinned to the provided core_id.
@@ -37,6 +39,12 @@ namespace Common
             }
             std::cerr << "Set core affinity for " << name << " " << pthread_self() << " to " << core_id << std::endl;
 
+            // Shows in top -H, gdb and the flight recorder dumps. The kernel keeps 15 characters, the part after the last '/' tells the threads apart.
+            if (!name.empty())
+            {
+                pthread_setname_np(pthread_self(), name.substr(name.rfind('/') + 1, 15).c_str());
+            }
+
             isRunning = true;
             std::forward<T>(func)((std::forward<A>(args))...);
         };
@@ -1,10 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <cmath>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
+#include <mutex>
+#include <thread>
+#include <cpuid.h>
 
+#include "Macros.h"
 #include "PerfUtils.h"
+#include "ThreadUtils.h"
 
 namespace Common
 {
@@ -25,7 +34,7 @@ namespace Common
     }
 
     /// Format current timestamp to a human readable string.
-    /// String formatting is inefficient.
+    /// String formatting is inefficient, keep it off the hot path. Loggers stamp every record with rdtsc() and format the time on their own thread.
     inline auto& GetCurrentTimeStr(std::string *time_str)
     {
         const auto clock = std::chrono::system_clock::now();
@@ -37,4 +46,234 @@ namespace Common
 
         return *time_str;
     }
+
+    /// How long CTscClock measures the TSC rate for before handing out its first conversion.
+    constexpr Nanos TSC_CALIBRATION_NANOS = 20 * NANOS_TO_MILLIS;
+
+    /// How often the CTscClock thread re-measures the TSC rate and re-anchors the conversion to the wall clock.
+    constexpr auto TSC_RECALIBRATION_INTERVAL = std::chrono::seconds(1);
+
+    /// NTP slews CLOCK_REALTIME by at most 500 ppm, a bigger difference from CLOCK_MONOTONIC_RAW means the clock was stepped.
+    constexpr double TSC_MAX_WALL_SLEW = 0.0005;
+
+    /// Maps rdtsc() readings to wall clock nanoseconds, so hot threads can stamp events with a single rdtsc() and leave the conversion to whoever reads them.
+    /// The TSC rate is measured against CLOCK_MONOTONIC_RAW, which NTP does not slew: over TSC_CALIBRATION_NANOS on first use, then by a background
+    /// thread every TSC_RECALIBRATION_INTERVAL over the whole time since start, which also re-anchors the conversion to CLOCK_REALTIME so drift
+    /// between the two never builds up. Readers get the latest calibration through a seqlock, a conversion is a few loads and a multiply.
+    /// Assumes an invariant TSC synchronized across cores, and warns at startup when the CPU does not report one.
+    class CTscClock final
+    {
+    public:
+        static auto Instance() -> const CTscClock &
+        {
+            static CTscClock clock;
+            return clock;
+        }
+
+        auto ToNanos(uint64_t tsc) const noexcept -> Nanos
+        {
+            uint64_t sequence, baseTsc;
+            Nanos baseNanos;
+            double nanosPerTick;
+            do
+            {
+                sequence = m_sequence.load(std::memory_order_acquire);
+                baseTsc = m_baseTsc.load(std::memory_order_relaxed);
+                baseNanos = m_baseNanos.load(std::memory_order_relaxed);
+                nanosPerTick = m_wallNanosPerTick.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+            } while (UNLIKELY((sequence & 1) || sequence != m_sequence.load(std::memory_order_relaxed)));
+
+            return baseNanos + static_cast<Nanos>(static_cast<double>(static_cast<int64_t>(tsc - baseTsc)) * nanosPerTick);
+        }
+
+        /// Wall clock nanoseconds now, without the vDSO call GetCurrentNanos() makes.
+        auto Now() const noexcept -> Nanos
+        {
+            return ToNanos(rdtscStop());
+        }
+
+        /// Length in nanoseconds of an interval measured in TSC ticks, at the TSC's true rate.
+        auto TicksToNanos(uint64_t ticks) const noexcept -> Nanos
+        {
+            return static_cast<Nanos>(static_cast<double>(ticks) * NanosPerTick());
+        }
+
+        auto NanosPerTick() const noexcept -> double
+        {
+            return m_nanosPerTick.load(std::memory_order_relaxed);
+        }
+
+        auto IsInvariant() const noexcept
+        {
+            return m_isInvariant;
+        }
+
+        ~CTscClock()
+        {
+            if (m_pThread)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_isRunning = false;
+                }
+                m_wakeup.notify_one();
+                m_pThread->join();
+
+                delete m_pThread;
+                m_pThread = nullptr;
+            }
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CTscClock(const CTscClock &) = delete;
+
+        CTscClock(const CTscClock &&) = delete;
+
+        CTscClock &operator=(const CTscClock &) = delete;
+
+        CTscClock &operator=(const CTscClock &&) = delete;
+
+    private:
+        CTscClock()
+        {
+            // CPUID leaf 0x80000007, EDX bit 8: the TSC ticks at a constant rate in every P-, C- and T-state.
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            m_isInvariant = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+            if (!m_isInvariant)
+            {
+                std::cerr << "CTscClock: the CPU does not report an invariant TSC, TSC based timestamps may drift with frequency changes." << std::endl;
+            }
+
+            m_start = m_last = Sample();
+            std::this_thread::sleep_for(std::chrono::nanoseconds(TSC_CALIBRATION_NANOS));
+            Calibrate();
+
+            m_isRunning = true;
+            m_pThread = CreateAndStartThread(-1, "Common/CTscClock", [this]() { Run(); });
+            ASSERT(m_pThread != nullptr, "Failed to start CTscClock thread.");
+        }
+
+        struct SSample
+        {
+            uint64_t tsc = 0;
+            Nanos    rawNanos = 0;
+            Nanos    wallNanos = 0;
+        };
+
+        static auto ClockNanos(clockid_t clock) noexcept -> Nanos
+        {
+            timespec ts;
+            clock_gettime(clock, &ts);
+            return ts.tv_sec * NANOS_TO_SECS + ts.tv_nsec;
+        }
+
+        /// A reading of the TSC and both clocks taken as close together as we can manage: the TSC is the midpoint of the two reads bracketing the
+        /// narrowest pair of clock calls.
+        static auto Sample() noexcept -> SSample
+        {
+            SSample best;
+            uint64_t bestWidth = UINT64_MAX;
+            for (int i = 0; i < 16; ++i)
+            {
+                const auto before = rdtscStart();
+                const auto rawNanos = ClockNanos(CLOCK_MONOTONIC_RAW);
+                const auto wallNanos = ClockNanos(CLOCK_REALTIME);
+                const auto after = rdtscStop();
+                if (after - before < bestWidth)
+                {
+                    bestWidth = after - before;
+                    best = {before + (after - before) / 2, rawNanos, wallNanos};
+                }
+            }
+
+            return best;
+        }
+
+        /// Measure the rate over everything since m_start and publish it anchored at a fresh sample. Wall clock conversions also follow the rate
+        /// NTP is slewing CLOCK_REALTIME at over the last interval, otherwise they would wander off it by a few microseconds between calibrations.
+        auto Calibrate() noexcept -> void
+        {
+            const auto sample = Sample();
+            const auto nanosPerTick = static_cast<double>(sample.rawNanos - m_start.rawNanos) / static_cast<double>(sample.tsc - m_start.tsc);
+
+            auto wallRate = static_cast<double>(sample.wallNanos - m_last.wallNanos) / static_cast<double>(sample.rawNanos - m_last.rawNanos);
+            if (m_last.tsc == m_start.tsc || std::abs(wallRate - 1.0) > TSC_MAX_WALL_SLEW)
+            {
+                wallRate = 1.0; // first calibration, or the wall clock was stepped rather than slewed.
+            }
+            m_last = sample;
+
+            const auto sequence = m_sequence.load(std::memory_order_relaxed);
+            m_sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_baseTsc.store(sample.tsc, std::memory_order_relaxed);
+            m_baseNanos.store(sample.wallNanos, std::memory_order_relaxed);
+            m_wallNanosPerTick.store(nanosPerTick * wallRate, std::memory_order_relaxed);
+            m_nanosPerTick.store(nanosPerTick, std::memory_order_relaxed);
+            m_sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        auto Run() noexcept -> void
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_isRunning)
+            {
+                m_wakeup.wait_for(lock, TSC_RECALIBRATION_INTERVAL, [this]() { return !m_isRunning; });
+                if (m_isRunning)
+                {
+                    Calibrate();
+                }
+            }
+        }
+
+        std::atomic<uint64_t> m_sequence = {0};
+        std::atomic<uint64_t> m_baseTsc = {0};
+        std::atomic<Nanos>    m_baseNanos = {0};
+        std::atomic<double>   m_wallNanosPerTick = {1.0};
+        std::atomic<double>   m_nanosPerTick = {1.0};
+
+        SSample m_start;
+        SSample m_last;
+        bool    m_isInvariant = false;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_wakeup;
+        std::thread            *m_pThread = nullptr;
+        bool                    m_isRunning = false;
+    };
+
+    /// Renders CTscClock timestamps as HH:MM:SS.nnnnnnnnn local time, the same text GetCurrentTimeStr() produces.
+    /// Keeps the HH:MM:SS of the last second it formatted, so a run of records in the same second only formats the nanoseconds.
+    /// Not thread safe, each logger thread owns one.
+    class CTscTimeFormatter final
+    {
+    public:
+        auto Format(uint64_t tsc) noexcept -> std::string_view
+        {
+            const auto nanos = CTscClock::Instance().ToNanos(tsc);
+            const auto seconds = static_cast<time_t>(nanos / NANOS_TO_SECS);
+            if (seconds != m_lastSeconds)
+            {
+                tm localTime;
+                localtime_r(&seconds, &localTime);
+                strftime(m_buffer, sizeof(m_buffer), "%H:%M:%S", &localTime);
+                m_buffer[8] = '.';
+                m_lastSeconds = seconds;
+            }
+
+            auto subSecondNanos = nanos % NANOS_TO_SECS;
+            for (int i = 17; i >= 9; --i)
+            {
+                m_buffer[i] = static_cast<char>('0' + subSecondNanos % 10);
+                subSecondNanos /= 10;
+            }
+
+            return {m_buffer, 18};
+        }
+
+    private:
+        time_t m_lastSeconds = -1;
+        char   m_buffer[19] = {};
+    };
 }
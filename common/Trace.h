@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "FlightRecorder.h"
+#include "Format.h"
+#include "LatencyService.h"
+#include "LogRecord.h"
+#include "Macros.h"
+#include "PerfUtils.h"
+#include "TimeUtils.h"
+#include "Types.h"
+
+namespace Common
+{
+    /// Points on the tick-to-trade round trip a trace is stamped at, in the order a message passes them.
+    /// Exchange: T1..T6 for market updates, T1..T6t for client responses. Trading: T7..T12 for a market update that leads to an order, T7t..T9t for client responses.
+    enum class ETraceHop : uint8_t
+    {
+        T1_OrderServer_TCP_read,
+        T2_OrderServer_LFQueue_write,
+        T3_MatchingEngine_LFQueue_read,
+        T4_MatchingEngine_LFQueue_write,
+        T4t_MatchingEngine_LFQueue_write,
+        T5_MarketDataPublisher_LFQueue_read,
+        T5t_OrderServer_LFQueue_read,
+        T6_MarketDataPublisher_UDP_write,
+        T6t_OrderServer_TCP_write,
+        T7_MarketDataConsumer_UDP_read,
+        T7t_OrderGateway_TCP_read,
+        T8_MarketDataConsumer_LFQueue_write,
+        T8t_OrderGateway_LFQueue_write,
+        T9_TradeEngine_LFQueue_read,
+        T9t_TradeEngine_LFQueue_read,
+        T10_TradeEngine_LFQueue_write,
+        T11_OrderGateway_LFQueue_read,
+        T12_OrderGateway_TCP_write,
+        COUNT
+    };
+
+    inline constexpr auto FormatTraceHop(ETraceHop hop) noexcept -> std::string_view
+    {
+        switch (hop)
+        {
+            case ETraceHop::T1_OrderServer_TCP_read:             return "T1_OrderServer_TCP_read";
+            case ETraceHop::T2_OrderServer_LFQueue_write:        return "T2_OrderServer_LFQueue_write";
+            case ETraceHop::T3_MatchingEngine_LFQueue_read:      return "T3_MatchingEngine_LFQueue_read";
+            case ETraceHop::T4_MatchingEngine_LFQueue_write:     return "T4_MatchingEngine_LFQueue_write";
+            case ETraceHop::T4t_MatchingEngine_LFQueue_write:    return "T4t_MatchingEngine_LFQueue_write";
+            case ETraceHop::T5_MarketDataPublisher_LFQueue_read: return "T5_MarketDataPublisher_LFQueue_read";
+            case ETraceHop::T5t_OrderServer_LFQueue_read:        return "T5t_OrderServer_LFQueue_read";
+            case ETraceHop::T6_MarketDataPublisher_UDP_write:    return "T6_MarketDataPublisher_UDP_write";
+            case ETraceHop::T6t_OrderServer_TCP_write:           return "T6t_OrderServer_TCP_write";
+            case ETraceHop::T7_MarketDataConsumer_UDP_read:      return "T7_MarketDataConsumer_UDP_read";
+            case ETraceHop::T7t_OrderGateway_TCP_read:           return "T7t_OrderGateway_TCP_read";
+            case ETraceHop::T8_MarketDataConsumer_LFQueue_write: return "T8_MarketDataConsumer_LFQueue_write";
+            case ETraceHop::T8t_OrderGateway_LFQueue_write:      return "T8t_OrderGateway_LFQueue_write";
+            case ETraceHop::T9_TradeEngine_LFQueue_read:         return "T9_TradeEngine_LFQueue_read";
+            case ETraceHop::T9t_TradeEngine_LFQueue_read:        return "T9t_TradeEngine_LFQueue_read";
+            case ETraceHop::T10_TradeEngine_LFQueue_write:       return "T10_TradeEngine_LFQueue_write";
+            case ETraceHop::T11_OrderGateway_LFQueue_read:       return "T11_OrderGateway_LFQueue_read";
+            case ETraceHop::T12_OrderGateway_TCP_write:          return "T12_OrderGateway_TCP_write";
+            case ETraceHop::COUNT:                               break;
+        }
+        return "UNKNOWN";
+    }
+
+    /// Identifies what a trace follows, built from fields already on the wire so the exchange and trading processes derive the same id independently.
+    /// An order: its client id and client order id. A market update: the top bit and its incremental stream sequence number.
+    typedef uint64_t TraceId;
+    constexpr auto TraceId_INVALID = std::numeric_limits<TraceId>::max();
+
+    constexpr uint64_t TRACE_ORDER_ID_BITS = 40;
+    constexpr uint64_t TRACE_MARKET_DATA_BIT = uint64_t{1} << 63;
+
+    inline constexpr auto MakeOrderTraceId(ClientId clientId, OrderId orderId) noexcept -> TraceId
+    {
+        return (static_cast<uint64_t>(clientId) << TRACE_ORDER_ID_BITS) | (orderId & ((uint64_t{1} << TRACE_ORDER_ID_BITS) - 1));
+    }
+
+    inline constexpr auto MakeMarketDataTraceId(size_t seqNum) noexcept -> TraceId
+    {
+        return TRACE_MARKET_DATA_BIT | seqNum;
+    }
+
+    /// Renders a TraceId as order:<client>:<order id>, md:<seq> or INVALID, the key the notebook joins the processes' records on.
+    struct SFormatTraceId
+    {
+        TraceId id = TraceId_INVALID;
+
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            if (id == TraceId_INVALID)
+            {
+                out << "INVALID";
+            }
+            else if (id & TRACE_MARKET_DATA_BIT)
+            {
+                out << "md:" << (id & ~TRACE_MARKET_DATA_BIT);
+            }
+            else
+            {
+                out << "order:" << (id >> TRACE_ORDER_ID_BITS) << ':' << (id & ((uint64_t{1} << TRACE_ORDER_ID_BITS) - 1));
+            }
+        }
+    };
+
+    /// Most hops one process stamps on a trace: T1..T6 on the exchange side, T7..T12 on the trading side.
+    constexpr size_t TRACE_MAX_HOPS = 6;
+
+    /// Trace context a message carries between the threads of one process, next to the message in the queues but never on the wire.
+    /// Hops are stored as TSC ticks since the first one, so a context stays a single cache line.
+    struct STraceContext
+    {
+        TraceId  id = TraceId_INVALID;
+        TraceId  parentId = TraceId_INVALID;
+        uint64_t startTsc = 0;
+        std::array<uint32_t, TRACE_MAX_HOPS>  ticks = {};
+        std::array<ETraceHop, TRACE_MAX_HOPS> hops = {};
+        uint8_t  count = 0;
+
+        auto IsValid() const noexcept
+        {
+            return id != TraceId_INVALID;
+        }
+
+        /// Begin a new trace at hop.
+        auto Start(TraceId traceId, ETraceHop hop, uint64_t tsc) noexcept -> void
+        {
+            *this = {};
+            id = traceId;
+            startTsc = tsc;
+            Stamp(hop, tsc);
+        }
+
+        /// Record that the message passed hop at tsc. Ignored on a trace that was never started, updates recovered from a snapshot for one.
+        auto Stamp(ETraceHop hop, uint64_t tsc) noexcept -> void
+        {
+            if (LIKELY(IsValid() && count < TRACE_MAX_HOPS))
+            {
+                hops[count] = hop;
+                ticks[count] = static_cast<uint32_t>(tsc > startTsc ? std::min<uint64_t>(tsc - startTsc, UINT32_MAX) : 0);
+                ++count;
+            }
+        }
+
+        /// Carry the hops so far on under a new id, for a message caused by the one this trace follows: the market update a request produced,
+        /// the order a market update triggered. The old id becomes the parent the two records are joined on. Starts afresh with no trace to carry on.
+        auto Fork(TraceId traceId, ETraceHop hop, uint64_t tsc) noexcept -> void
+        {
+            if (UNLIKELY(!IsValid()))
+            {
+                Start(traceId, hop, tsc);
+                return;
+            }
+
+            parentId = id;
+            id = traceId;
+            Stamp(hop, tsc);
+        }
+
+        /// Formatted on the logger thread: the ids, then every hop as wall clock nanoseconds, comparable across processes.
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "id:" << SFormatTraceId{id} << " parent:" << SFormatTraceId{parentId};
+            const auto &clock = CTscClock::Instance();
+            for (size_t i = 0; i < count; ++i)
+            {
+                out << ' ' << FormatTraceHop(hops[i]) << ':' << clock.ToNanos(startTsc + ticks[i]);
+            }
+        }
+    };
+
+    static_assert(sizeof(STraceContext) <= 64, "A trace context should fit in one cache line next to its message.");
+
+    /// A message with the trace context that travels with it through the process's queues. Code reading the queues sees the message itself,
+    /// only the message goes on the wire: send sizeof(T) bytes of static_cast<const T &>(traced).
+    template <typename T>
+    struct STraced : T
+    {
+        STraceContext trace;
+    };
+
+    /// A traced message logs as the message alone.
+    template <typename T>
+    struct SLogFormatter<STraced<T>> : SLogFormatter<T>
+    {
+    };
+
+    /// Create the calling thread's histograms for the hops first to last, in ETraceHop order, for a thread that ends traces with TRACE_END().
+    /// Call it from the thread's run loop before it starts processing, see PreregisterMeasures().
+    inline auto PreregisterTraceHops(ETraceHop first, ETraceHop last) -> void
+    {
+        for (auto hop = static_cast<size_t>(first); hop <= static_cast<size_t>(last); ++hop)
+        {
+            CLatencyService::Instance().ThreadHistogram(FormatTraceHop(static_cast<ETraceHop>(hop)).data());
+        }
+    }
+
+    /// Collect a trace that reached the last hop this process stamps: record the ticks between each pair of consecutive hops into the calling thread's
+    /// histogram for the later hop, reported by CLatencyService under the hop's name. The per-order record is logged by TRACE_END().
+    inline auto CollectTrace(const STraceContext &trace) noexcept
+    {
+        static thread_local std::array<CLatencyHistogram *, static_cast<size_t>(ETraceHop::COUNT)> histograms = {};
+
+        for (size_t i = 1; i < trace.count; ++i)
+        {
+            auto &pHistogram = histograms[static_cast<size_t>(trace.hops[i])];
+            if (UNLIKELY(!pHistogram))
+            {
+                pHistogram = CLatencyService::Instance().ThreadHistogram(FormatTraceHop(trace.hops[i]).data());
+            }
+            pHistogram->Record(trace.ticks[i] > trace.ticks[i - 1] ? trace.ticks[i] - trace.ticks[i - 1] : 0);
+        }
+
+        // A slow message leaves its story in the flight recorders, have them dumped while it is still in the rings.
+        if (UNLIKELY(trace.count && CFlightRecorderRegistry::Instance().IsOverLatencyThreshold(trace.ticks[trace.count - 1])))
+        {
+            CFlightRecorderRegistry::Instance().RequestDump();
+        }
+    }
+}
+
+/// Logged by value, formatted on the logger thread.
+LOG_BY_VALUE(Common::STraceContext);
+
+/// Start TRACE at HOP for the message identified by ID.
+#define TRACE_START(TRACE, ID, HOP) (TRACE).Start((ID), Common::ETraceHop::HOP, Common::rdtsc())
+
+/// Stamp HOP on TRACE.
+#define TRACE_HOP(TRACE, HOP) (TRACE).Stamp(Common::ETraceHop::HOP, Common::rdtsc())
+
+/// Stamp the last hop this process puts on TRACE, record its hops into the latency histograms and log it as one TTT record.
+/// At INFO so the per-order records survive the LOG_COMPILE_FLOOR of release builds, they are what the analysis notebook joins across processes.
+#define TRACE_END(TRACE, HOP, LOGGER)                                                                                   \
+    do                                                                                                                  \
+    {                                                                                                                   \
+        TRACE_HOP(TRACE, HOP);                                                                                          \
+        if (LIKELY((TRACE).IsValid()))                                                                                  \
+        {                                                                                                               \
+            Common::CollectTrace(TRACE);                                                                                \
+            LOG_INFO(LOGGER, "TTT %\n", (TRACE));                                                                       \
+        }                                                                                                               \
+    } while (false)
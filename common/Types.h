@@ -2,9 +2,10 @@
 
 #include <cstdint>
 #include <limits>
-#include <sstream>
+#include <string>
 #include <array>
 
+#include "common/Format.h"
 #include "common/Macros.h"
 
 namespace Common
@@ -29,80 +30,82 @@ namespace Common
     typedef uint64_t OrderId;
     constexpr auto OrderId_INVALID = std::numeric_limits<OrderId>::max();
 
-    inline auto OrderIdToString(OrderId orderId) -> std::string
+    /// The Format*() helpers return what to append to a CFormatBuffer for a value, INVALID for the sentinel, without allocating.
+    /// The *ToString() wrappers are for callers that need a std::string.
+    inline auto FormatOrderId(OrderId orderId) noexcept
     {
-        if (UNLIKELY(orderId == OrderId_INVALID))
-        {
-            return "INVALID";
-        }
+        return SFormatChecked<OrderId>{orderId, OrderId_INVALID};
+    }
 
-        return std::to_string(orderId);
+    inline auto OrderIdToString(OrderId orderId) -> std::string
+    {
+        return FormatToString(FormatOrderId(orderId));
     }
 
     typedef uint32_t TickerId;
     constexpr auto TickerId_INVALID = std::numeric_limits<TickerId>::max();
 
-    inline auto TickerIdToString(TickerId tickerId) -> std::string
+    inline auto FormatTickerId(TickerId tickerId) noexcept
     {
-        if (UNLIKELY(tickerId == TickerId_INVALID))
-        {
-            return "INVALID";
-        }
+        return SFormatChecked<TickerId>{tickerId, TickerId_INVALID};
+    }
 
-        return std::to_string(tickerId);
+    inline auto TickerIdToString(TickerId tickerId) -> std::string
+    {
+        return FormatToString(FormatTickerId(tickerId));
     }
 
     typedef uint32_t ClientId;
     constexpr auto ClientId_INVALID = std::numeric_limits<ClientId>::max();
 
-    inline auto ClientIdToString(ClientId clientId) -> std::string
+    inline auto FormatClientId(ClientId clientId) noexcept
     {
-        if (UNLIKELY(clientId == ClientId_INVALID))
-        {
-            return "INVALID";
-        }
+        return SFormatChecked<ClientId>{clientId, ClientId_INVALID};
+    }
 
-        return std::to_string(clientId);
+    inline auto ClientIdToString(ClientId clientId) -> std::string
+    {
+        return FormatToString(FormatClientId(clientId));
     }
 
     typedef int64_t Price;
     constexpr auto Price_INVALID = std::numeric_limits<Price>::max();
 
-    inline auto PriceToString(Price price) -> std::string
+    inline auto FormatPrice(Price price) noexcept
     {
-        if (UNLIKELY(price == Price_INVALID))
-        {
-            return "INVALID";
-        }
+        return SFormatChecked<Price>{price, Price_INVALID};
+    }
 
-        return std::to_string(price);
+    inline auto PriceToString(Price price) -> std::string
+    {
+        return FormatToString(FormatPrice(price));
     }
 
     typedef uint32_t Qty;
     constexpr auto Qty_INVALID = std::numeric_limits<Qty>::max();
 
-    inline auto QtyToString(Qty qty) -> std::string
+    inline auto FormatQty(Qty qty) noexcept
     {
-        if (UNLIKELY(qty == Qty_INVALID))
-        {
-            return "INVALID";
-        }
+        return SFormatChecked<Qty>{qty, Qty_INVALID};
+    }
 
-        return std::to_string(qty);
+    inline auto QtyToString(Qty qty) -> std::string
+    {
+        return FormatToString(FormatQty(qty));
     }
 
     /// Priority represents position in the FIFO queue for all orders with the same side and price attributes.
     typedef uint64_t Priority;
     constexpr auto Priority_INVALID = std::numeric_limits<Priority>::max();
 
-    inline auto PriorityToString(Priority priority) -> std::string
+    inline auto FormatPriority(Priority priority) noexcept
     {
-        if (UNLIKELY(priority == Priority_INVALID))
-        {
-            return "INVALID";
-        }
+        return SFormatChecked<Priority>{priority, Priority_INVALID};
+    }
 
-        return std::to_string(priority);
+    inline auto PriorityToString(Priority priority) -> std::string
+    {
+        return FormatToString(FormatPriority(priority));
     }
 
     enum class ESide : int8_t
@@ -113,7 +116,7 @@ namespace Common
         MAX = 2
     };
 
-    inline auto SideToString(ESide side) -> std::string
+    inline constexpr auto FormatSide(ESide side) noexcept -> std::string_view
     {
         switch (side)
         {
@@ -130,6 +133,11 @@ namespace Common
             return "UNKNOWN";
     }
 
+    inline auto SideToString(ESide side) -> std::string
+    {
+        return std::string(FormatSide(side));
+    }
+
     /// Convert ESide to an index which can be used to index into a std::array.
     inline constexpr auto SideToIndex(ESide side) noexcept
     {
@@ -152,7 +160,7 @@ namespace Common
         MAX = 4
     };
 
-    inline auto AlgoTypeToString(EAlgoType type) -> std::string
+    inline constexpr auto FormatAlgoType(EAlgoType type) noexcept -> std::string_view
     {
         switch (type)
         {
@@ -171,6 +179,11 @@ namespace Common
         return "UNKNOWN";
     }
 
+    inline auto AlgoTypeToString(EAlgoType type) -> std::string
+    {
+        return std::string(FormatAlgoType(type));
+    }
+
     inline auto StringToAlgoType(const std::string &str) -> EAlgoType
     {
         for (auto i = static_cast<int>(EAlgoType::INVALID); i <= static_cast<int>(EAlgoType::MAX); ++i)
@@ -190,17 +203,18 @@ namespace Common
         Qty max_position_ = 0;
         double max_loss_ = 0;
 
-        auto ToString() const
+        auto Format(CFormatBuffer &out) const -> void
         {
-            std::stringstream ss;
-
-            ss << "ERiskCfg{"
-               << "max-order-size:" << QtyToString(max_order_size_) << " "
-               << "max-position:" << QtyToString(max_position_) << " "
-               << "max-loss:" << max_loss_
-               << "}";
+            out << "ERiskCfg{"
+                << "max-order-size:" << FormatQty(max_order_size_) << " "
+                << "max-position:" << FormatQty(max_position_) << " "
+                << "max-loss:" << max_loss_
+                << "}";
+        }
 
-            return ss.str();
+        auto ToString() const
+        {
+            return FormatToString(*this);
         }
     };
 
@@ -211,16 +225,18 @@ namespace Common
         double threshold_ = 0;
         ERiskCfg riskCfg;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "ETradeEngineCfg{"
+                << "clip:" << FormatQty(clip_) << " "
+                << "thresh:" << threshold_ << " "
+                << "risk:" << riskCfg
+                << "}";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "ETradeEngineCfg{"
-               << "clip:" << QtyToString(clip_) << " "
-               << "thresh:" << threshold_ << " "
-               << "risk:" << riskCfg.ToString()
-               << "}";
-
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
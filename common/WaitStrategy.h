@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <climits>
+#include <sched.h>
+#include <immintrin.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Macros.h"
+
+namespace Common
+{
+    /// How a polling thread behaves when a pass over its inputs found nothing to do.
+    enum class EWaitStrategy : int8_t
+    {
+        BUSY_SPIN = 0,     /// Keep polling at full speed, lowest latency, burns the whole core.
+        PAUSE_BACKOFF = 1, /// Spin with an exponentially growing number of _mm_pause, leaves execution resources to the SMT sibling.
+        YIELD = 2,         /// Spin briefly, then sched_yield() so other threads can share the core.
+        PARK = 3           /// Spin, then yield, then sleep on a futex until Unpark() or a short timeout, for threads off the critical path.
+    };
+
+    inline auto WaitStrategyToString(EWaitStrategy strategy) -> std::string
+    {
+        switch (strategy)
+        {
+            case EWaitStrategy::BUSY_SPIN:
+                return "BUSY_SPIN";
+            case EWaitStrategy::PAUSE_BACKOFF:
+                return "PAUSE_BACKOFF";
+            case EWaitStrategy::YIELD:
+                return "YIELD";
+            case EWaitStrategy::PARK:
+                return "PARK";
+        }
+
+        return "UNKNOWN";
+    }
+
+    inline auto StringToWaitStrategy(const std::string &str) -> EWaitStrategy
+    {
+        for (const auto strategy : {EWaitStrategy::BUSY_SPIN, EWaitStrategy::PAUSE_BACKOFF, EWaitStrategy::YIELD, EWaitStrategy::PARK})
+        {
+            if (WaitStrategyToString(strategy) == str)
+            {
+                return strategy;
+            }
+        }
+
+        FATAL("Unknown wait strategy:" + str + ", expected BUSY_SPIN, PAUSE_BACKOFF, YIELD or PARK");
+    }
+
+    /// The strategy named by environment variable name, or fallback when it is not set. Lets the mains pick a strategy per thread without recompiling.
+    inline auto WaitStrategyFromEnv(const char *name, EWaitStrategy fallback) -> EWaitStrategy
+    {
+        const auto value = std::getenv(name);
+        return (value ? StringToWaitStrategy(value) : fallback);
+    }
+
+    /// Idle passes spent spinning before YIELD / PARK start giving up the core, and before PARK starts sleeping.
+    constexpr size_t WAIT_SPIN_ROUNDS = 64;
+    constexpr size_t WAIT_YIELD_ROUNDS = 64;
+
+    /// Upper bound on the _mm_pause count of a single PAUSE_BACKOFF idle pass, as a power of two.
+    constexpr size_t WAIT_MAX_PAUSE_SHIFT = 6;
+
+    /// Longest a parked thread sleeps without being woken, bounds the latency of a missed Unpark().
+    constexpr long WAIT_PARK_TIMEOUT_NANOS = 200 * 1000;
+
+    /// Per-thread idle policy for the busy-polling run loops.
+    /// The owning thread calls OnWork() after a pass that did something and OnIdle() after a pass that did not,
+    /// the back-off state is reset by OnWork() so a burst is always handled at full polling speed.
+    class CWaitStrategy final
+    {
+    public:
+        explicit CWaitStrategy(EWaitStrategy strategy = EWaitStrategy::BUSY_SPIN) noexcept : m_strategy(strategy)
+        {
+        }
+
+        /// Only call before the owning thread starts.
+        auto SetStrategy(EWaitStrategy strategy) noexcept
+        {
+            m_strategy = strategy;
+        }
+
+        auto GetStrategy() const noexcept
+        {
+            return m_strategy;
+        }
+
+        auto OnWork() noexcept -> void
+        {
+            m_idleRounds = 0;
+        }
+
+        /// Convenience for loops that track whether the last pass did anything.
+        auto OnPoll(bool didWork) noexcept
+        {
+            if (didWork)
+            {
+                OnWork();
+            }
+            else
+            {
+                OnIdle();
+            }
+        }
+
+        auto OnIdle() noexcept -> void
+        {
+            switch (m_strategy)
+            {
+                case EWaitStrategy::BUSY_SPIN:
+                    return;
+                case EWaitStrategy::PAUSE_BACKOFF:
+                    Pause(size_t{1} << std::min(m_idleRounds, WAIT_MAX_PAUSE_SHIFT));
+                    break;
+                case EWaitStrategy::YIELD:
+                    if (m_idleRounds < WAIT_SPIN_ROUNDS)
+                    {
+                        Pause(1);
+                    }
+                    else
+                    {
+                        sched_yield();
+                    }
+                    break;
+                case EWaitStrategy::PARK:
+                    if (m_idleRounds < WAIT_SPIN_ROUNDS)
+                    {
+                        Pause(1);
+                    }
+                    else if (m_idleRounds < WAIT_SPIN_ROUNDS + WAIT_YIELD_ROUNDS)
+                    {
+                        sched_yield();
+                    }
+                    else
+                    {
+                        Park();
+                    }
+                    break;
+            }
+
+            ++m_idleRounds;
+        }
+
+        /// Wake the owning thread if it is parked, called by a producer after publishing work for it.
+        /// Costs one load of the shared flag when the owner is not parked.
+        auto Unpark() noexcept
+        {
+            if (m_isParked.load())
+            {
+                m_isParked.store(0);
+                syscall(SYS_futex, &m_isParked, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+            }
+        }
+
+        /// Deleted copy & move constructors and assignment-operators.
+        CWaitStrategy(const CWaitStrategy &) = delete;
+
+        CWaitStrategy(const CWaitStrategy &&) = delete;
+
+        CWaitStrategy &operator=(const CWaitStrategy &) = delete;
+
+        CWaitStrategy &operator=(const CWaitStrategy &&) = delete;
+
+    private:
+        static auto Pause(size_t count) noexcept -> void
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                _mm_pause();
+            }
+        }
+
+        /// Sleep until Unpark() or WAIT_PARK_TIMEOUT_NANOS, whichever comes first.
+        /// The owner does not re-check its inputs after raising the flag, so a wake-up racing with it is only delayed by the timeout, never lost.
+        auto Park() noexcept -> void
+        {
+            const timespec timeout{0, WAIT_PARK_TIMEOUT_NANOS};
+
+            m_isParked.store(1);
+            syscall(SYS_futex, &m_isParked, FUTEX_WAIT_PRIVATE, 1, &timeout, nullptr, 0);
+            m_isParked.store(0);
+        }
+
+        EWaitStrategy m_strategy;
+        size_t        m_idleRounds = 0;
+
+        /// Futex word, on its own cache line since producers read it after every publish when they call Unpark().
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> m_isParked = {0};
+    };
+}
@@ -36,39 +36,57 @@ int main(int, char **)
 {
     pLogger = new Common::CLogger("exchange_main.log");
 
+    // Signal handlers, the contract failure hook and the dump thread in place before any component starts, not on the first recorded event.
+    Common::CFlightRecorderRegistry::Instance();
+
     std::signal(SIGINT, SignalHandler);
 
     const int sleep_time = 100 * 1000;
 
-    // The lock free queues to facilitate communication between order server <-> matching engine and matching engine -> market data publisher.
-    Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
-    Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
-    Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
-
-    std::string time_str;
-
-    pLogger->Log("%:% %() % Starting Matching Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&time_str));
+    // The lock free queues to facilitate communication between order server <-> matching engine,
+    // and the broadcast ring the market data publisher and snapshot synthesizer both read matching engine market updates from.
+    Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES, "exchange:client_requests");
+    Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES, "exchange:client_responses");
+    Exchange::MEMarketUpdateRing market_updates(ME_MAX_MARKET_UPDATES, Exchange::ME_MAX_MARKET_UPDATE_READERS, "exchange:market_updates");
+
+    // Idle behaviour of each thread, set as e.g. ME_WAIT_STRATEGY=PARK ./exchange_main. The matching engine, publisher and snapshot synthesizer
+    // are unparked by the queue / ring they read from. The order server polls its sockets, so it cannot PARK.
+    const auto me_wait = Common::WaitStrategyFromEnv("ME_WAIT_STRATEGY", Common::EWaitStrategy::BUSY_SPIN);
+    const auto md_pub_wait = Common::WaitStrategyFromEnv("MD_PUBLISHER_WAIT_STRATEGY", Common::EWaitStrategy::BUSY_SPIN);
+    const auto snapshot_wait = Common::WaitStrategyFromEnv("SNAPSHOT_WAIT_STRATEGY", Common::EWaitStrategy::YIELD);
+    const auto order_server_wait = Common::WaitStrategyFromEnv("ORDER_SERVER_WAIT_STRATEGY", Common::EWaitStrategy::BUSY_SPIN);
+    LOG_INFO(*pLogger, "%:% %() Wait strategies matching engine:% publisher:% snapshot:% order server:%\n", __FILE__, __LINE__, __FUNCTION__,
+             Common::WaitStrategyToString(me_wait), Common::WaitStrategyToString(md_pub_wait), Common::WaitStrategyToString(snapshot_wait),
+             Common::WaitStrategyToString(order_server_wait));
+
+    LOG_INFO(*pLogger, "%:% %() Starting Matching Engine...\n", __FILE__, __LINE__, __FUNCTION__);
     pMatchingEngine = new Exchange::CMatchingEngine(&client_requests, &client_responses, &market_updates);
+    pMatchingEngine->SetWaitStrategy(me_wait);
     pMatchingEngine->Start();
 
     const std::string mkt_pub_iface = "lo";
     const std::string snap_pub_ip = "233.252.14.1", inc_pub_ip = "233.252.14.3";
     const int snap_pub_port = 20000, inc_pub_port = 20001;
 
-    pLogger->Log("%:% %() % Starting Market Data Publisher...\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&time_str));
+    LOG_INFO(*pLogger, "%:% %() Starting Market Data Publisher...\n", __FILE__, __LINE__, __FUNCTION__);
     pMarketDataPublisher = new Exchange::CMarketDataPublisher(&market_updates, mkt_pub_iface, snap_pub_ip, snap_pub_port, inc_pub_ip, inc_pub_port);
+    pMarketDataPublisher->SetWaitStrategy(md_pub_wait, snapshot_wait);
     pMarketDataPublisher->Start();
 
     const std::string order_gw_iface = "lo";
     const int order_gw_port = 12345;
 
-    pLogger->Log("%:% %() % Starting Order Server...\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&time_str));
+    LOG_INFO(*pLogger, "%:% %() Starting Order Server...\n", __FILE__, __LINE__, __FUNCTION__);
     pOrderServer = new Exchange::COrderServer(&client_requests, &client_responses, order_gw_iface, order_gw_port);
+    pOrderServer->SetWaitStrategy(order_server_wait);
     pOrderServer->Start();
 
+    LOG_INFO(*pLogger, "%:% %() Memory report:\n%", __FILE__, __LINE__, __FUNCTION__, Common::CHugePageRegistry::Instance().ToString());
+
     while (true)
     {
-        pLogger->Log("%:% %() % Sleeping for a few milliseconds..\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&time_str));
+        LOG_INFO(*pLogger, "%:% %() Queue stats:\n%", __FILE__, __LINE__, __FUNCTION__, OptCommon::CQueueStatsRegistry::Instance().ToString());
+        LOG_DEBUG(*pLogger, "%:% %() Sleeping for a few milliseconds..\n", __FILE__, __LINE__, __FUNCTION__);
         usleep(sleep_time * 1000);
     }
 }
@@ -2,50 +2,59 @@
 
 namespace Exchange
 {
-    CMarketDataPublisher::CMarketDataPublisher(MEMarketUpdateLFQueue *market_updates, const std::string &iface,
+    CMarketDataPublisher::CMarketDataPublisher(MEMarketUpdateRing *market_updates, const std::string &iface,
                                              const std::string &snapshot_ip, int snapshot_port,
                                              const std::string &incremental_ip, int incremental_port)
-        : m_pOutgoingMdUpdates(market_updates), m_snapshotMdUpdates(ME_MAX_MARKET_UPDATES),
-          m_isRunning(false), m_logger("exchange_market_data_publisher.log"), m_incrementalSocket(m_logger)
+        : m_pOutgoingMdUpdates(market_updates->AddReader(&m_waitStrategy)),
+          m_isRunning(false), m_logger("exchange_market_data_publisher.log"), m_incrementalSocket(m_logger),
+          m_updatesCounter(CMetricsRegistry::Instance().Counter("exchange:market_data_publisher:updates"))
     {
+        m_nextIncSeqNum = m_pOutgoingMdUpdates->ReadSequence() + 1;
+
         ASSERT(m_incrementalSocket.Init(incremental_ip, iface, incremental_port, /*is_listening*/ false) >= 0,
                "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
-        m_pSnapshotSynthesizer = new CSnapshotSynthesizer(&m_snapshotMdUpdates, iface, snapshot_ip, snapshot_port);
+        m_pSnapshotSynthesizer = new CSnapshotSynthesizer(market_updates, iface, snapshot_ip, snapshot_port);
     }
 
-    /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream and forwards them to the snapshot synthesizer.
+    /// Main run loop for this thread - consumes market updates from the broadcast ring written by the matching engine and publishes them on the incremental multicast stream.
     auto CMarketDataPublisher::Run() noexcept -> void
     {
-        m_logger.Log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+        LOG_INFO(m_logger, "%:% %()\n", __FILE__, __LINE__, __FUNCTION__);
+
+        Common::PreregisterMeasures({"Exchange_McastSocket_send"});
+        Common::PreregisterTraceHops(Common::ETraceHop::T2_OrderServer_LFQueue_write, Common::ETraceHop::T6t_OrderServer_TCP_write);
+
         while (m_isRunning)
         {
-            for (auto market_update = m_pOutgoingMdUpdates->GetNextToRead();
-                 m_pOutgoingMdUpdates->size() && market_update; market_update = m_pOutgoingMdUpdates->GetNextToRead())
+            // Consume everything the matching engine has published so far and release it with a single cursor update.
+            const auto market_updates = m_pOutgoingMdUpdates->PeekRead(ME_MAX_MARKET_UPDATES);
+            for (size_t i = 0; i < market_updates.size(); ++i)
             {
-                TTT_MEASURE(T5_MarketDataPublisher_LFQueue_read, m_logger);
+                const auto market_update = &market_updates[i];
+                auto trace = market_update->trace;
+                trace.Fork(MakeMarketDataTraceId(m_nextIncSeqNum), ETraceHop::T5_MarketDataPublisher_LFQueue_read, Common::rdtsc());
 
-                m_logger.Log("%:% %() % Sending seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), m_nextIncSeqNum,
-                            market_update->ToString().c_str());
+                LOG_TRACE(m_logger, "%:% %() Sending seq:% %\n", __FILE__, __LINE__, __FUNCTION__, m_nextIncSeqNum,
+                            *market_update);
 
                 START_MEASURE(Exchange_McastSocket_send);
                 m_incrementalSocket.Send(&m_nextIncSeqNum, sizeof(m_nextIncSeqNum));
-                m_incrementalSocket.Send(market_update, sizeof(SMEMarketUpdate));
-                END_MEASURE(Exchange_McastSocket_send, m_logger);
-
-                m_pOutgoingMdUpdates->UpdateReadIndex();
-                TTT_MEASURE(T6_MarketDataPublisher_UDP_write, m_logger);
-
-                // Forward this incremental market data update the snapshot synthesizer.
-                auto next_write = m_snapshotMdUpdates.GetNextToWriteTo();
-                next_write->seqNum = m_nextIncSeqNum;
-                next_write->me_market_update_ = *market_update;
-                m_snapshotMdUpdates.UpdateWriteIndex();
+                m_incrementalSocket.Send(static_cast<const SMEMarketUpdate *>(market_update), sizeof(SMEMarketUpdate));
+                END_MEASURE(Exchange_McastSocket_send);
+                TRACE_END(trace, T6_MarketDataPublisher_UDP_write, m_logger);
+                FLIGHT_RECORD(MARKET_UPDATE_SENT, m_nextIncSeqNum, market_update->tickerId, market_update->side, market_update->price, market_update->qty,
+                              market_update->type);
 
                 ++m_nextIncSeqNum;
             }
+            m_pOutgoingMdUpdates->ReleaseRead(market_updates.size());
+            m_updatesCounter.Increment(static_cast<int64_t>(market_updates.size()));
 
             // Publish to the multicast stream.
             m_incrementalSocket.SendAndRecv();
+
+            ALLOCATION_FREE_AFTER_WARMUP("exchange:market_data_publisher", market_updates.size() > 0);
+            m_waitStrategy.OnPoll(market_updates.size() > 0);
         }
     }
 }
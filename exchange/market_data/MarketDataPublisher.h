@@ -2,6 +2,9 @@
 
 #include <functional>
 
+#include "common/AllocationTracker.h"
+#include "common/Metrics.h"
+
 #include "market_data/SnapshotSynthesizer.h"
 
 namespace Exchange
@@ -9,7 +12,7 @@ namespace Exchange
     class CMarketDataPublisher
     {
     public:
-        CMarketDataPublisher(MEMarketUpdateLFQueue *market_updates, const std::string &iface,
+        CMarketDataPublisher(MEMarketUpdateRing *market_updates, const std::string &iface,
                             const std::string &snapshot_ip, int snapshot_port,
                             const std::string &incremental_ip, int incremental_port);
 
@@ -43,7 +46,14 @@ namespace Exchange
             m_pSnapshotSynthesizer->Stop();
         }
 
-        /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream and forwards them to the snapshot synthesizer.
+        /// Idle behaviour of the publisher and snapshot synthesizer run loops, only call before Start().
+        auto SetWaitStrategy(Common::EWaitStrategy publisherStrategy, Common::EWaitStrategy snapshotStrategy) noexcept
+        {
+            m_waitStrategy.SetStrategy(publisherStrategy);
+            m_pSnapshotSynthesizer->SetWaitStrategy(snapshotStrategy);
+        }
+
+        /// Main run loop for this thread - consumes market updates from the broadcast ring written by the matching engine and publishes them on the incremental multicast stream.
         auto Run() noexcept -> void;
 
         // Deleted default, copy & move constructors and assignment-operators.
@@ -54,24 +64,27 @@ namespace Exchange
         CMarketDataPublisher &operator=(const CMarketDataPublisher &&) = delete;
 
     private:
-        /// Sequencer number tracker on the incremental market data stream.
+        /// Sequencer number tracker on the incremental market data stream, the ring sequence of the update plus one.
         size_t m_nextIncSeqNum = 1;
 
-        /// Lock free queue from which we consume market data updates sent by the matching engine.
-        MEMarketUpdateLFQueue* m_pOutgoingMdUpdates = nullptr;
-
-        /// Lock free queue on which we forward the incremental market data updates to send to the snapshot synthesizer.
-        MDPMarketUpdateLFQueue m_snapshotMdUpdates;
+        /// Our read cursor on the broadcast ring of market data updates sent by the matching engine.
+        /// The snapshot synthesizer has its own cursor on the same ring, so updates are not relayed to it.
+        MEMarketUpdateRing::CReader* m_pOutgoingMdUpdates = nullptr;
 
         volatile bool m_isRunning = false;
 
-        std::string m_timeStr;
-        CLogger     m_logger;
+        /// What the run loop does after a pass that found nothing to process.
+        Common::CWaitStrategy m_waitStrategy;
+
+        CLogger m_logger;
 
         /// Multicast socket to represent the incremental market data stream.
         Common::SMultiCastSocket m_incrementalSocket;
 
         /// Snapshot synthesizer which synthesizes and publishes limit order book snapshots on the snapshot multicast stream.
         CSnapshotSynthesizer* m_pSnapshotSynthesizer = nullptr;
+
+        /// Live count of updates published on the incremental stream, through CMetricsRegistry.
+        Common::CMetricCounter m_updatesCounter;
     };
 }
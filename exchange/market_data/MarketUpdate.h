@@ -1,9 +1,11 @@
 #pragma once
 
-#include <sstream>
-
 #include "common/Types.h"
-#include "common/LockFreeQueue.h"
+#include "common/LogRecord.h"
+#include "common/OptLockFreeQueue.h"
+#include "common/BroadcastRing.h"
+#include "common/ShmLockFreeQueue.h"
+#include "common/Trace.h"
 
 using namespace Common;
 
@@ -22,7 +24,7 @@ namespace Exchange
         SNAPSHOT_END = 7
     };
 
-    inline std::string MarketUpdateTypeToString(EMarketUpdateType type)
+    inline constexpr auto FormatMarketUpdateType(EMarketUpdateType type) noexcept -> std::string_view
     {
         switch (type)
         {
@@ -46,6 +48,11 @@ namespace Exchange
         return "UNKNOWN";
     }
 
+    inline auto MarketUpdateTypeToString(EMarketUpdateType type) -> std::string
+    {
+        return std::string(FormatMarketUpdateType(type));
+    }
+
     /// These structures go over the wire / network, so the binary structures are packed to remove system dependent extra padding.
 #pragma pack(push, 1)
 
@@ -61,20 +68,23 @@ namespace Exchange
         Qty      qty      = Qty_INVALID;
         Priority priority = Priority_INVALID;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "EMEMarketUpdate"
+                << " ["
+                << " type:"     << FormatMarketUpdateType(type)
+                << " ticker:"   << FormatTickerId(tickerId)
+                << " oid:"      << FormatOrderId(orderId)
+                << " side:"     << FormatSide(side)
+                << " qty:"      << FormatQty(qty)
+                << " price:"    << FormatPrice(price)
+                << " priority:" << FormatPriority(priority)
+                << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "EMEMarketUpdate"
-               << " ["
-               << " type:"     << MarketUpdateTypeToString(type)
-               << " ticker:"   << TickerIdToString(tickerId)
-               << " oid:"      << OrderIdToString(orderId)
-               << " side:"     << SideToString(side)
-               << " qty:"      << QtyToString(qty)
-               << " price:"    << PriceToString(price)
-               << " priority:" << PriorityToString(priority)
-               << "]";
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
@@ -84,21 +94,37 @@ namespace Exchange
         size_t seqNum = 0;
         SMEMarketUpdate me_market_update_;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "MDPMarketUpdate"
+                << " ["
+                << " seq:" << static_cast<size_t>(seqNum)
+                << " " << me_market_update_
+                << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "MDPMarketUpdate"
-               << " ["
-               << " seq:" << seqNum
-               << " " << me_market_update_.ToString()
-               << "]";
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
 #pragma pack(pop) // Undo the packed binary structure directive moving forward.
 
-    /// Lock free queues of matching engine market update messages and market data publisher market updates messages respectively.
-    typedef Common::CLockFreeQueue<Exchange::SMEMarketUpdate> MEMarketUpdateLFQueue;
-    typedef Common::CLockFreeQueue<Exchange::MDPMarketUpdate> MDPMarketUpdateLFQueue;
+    /// Lock free queue of matching engine market update messages, each with the trace context it carries through the process.
+    typedef OptCommon::COptLockFreeQueue<Common::STraced<Exchange::SMEMarketUpdate>> MEMarketUpdateLFQueue;
+
+    /// Maximum number of consumers reading the matching engine market updates ring: incremental publisher, snapshot synthesizer
+    /// and room for journal / drop copy / stats consumers.
+    constexpr size_t ME_MAX_MARKET_UPDATE_READERS = 8;
+
+    /// Broadcast ring of matching engine market update messages, every consumer reads each update in place through its own cursor.
+    typedef OptCommon::CBroadcastRing<Common::STraced<Exchange::SMEMarketUpdate>> MEMarketUpdateRing;
+
+    /// Matching engine market updates in a named shared memory segment, for a publisher or co-located strategy running in a separate process.
+    typedef OptCommon::CShmLockFreeQueue<Common::STraced<Exchange::SMEMarketUpdate>> MEMarketUpdateShmQueue;
 }
+
+/// Logged by value, formatted on the logger thread.
+LOG_BY_VALUE(Exchange::SMEMarketUpdate);
+LOG_BY_VALUE(Exchange::MDPMarketUpdate);
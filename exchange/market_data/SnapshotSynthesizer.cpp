@@ -2,10 +2,13 @@
 
 namespace Exchange
 {
-    CSnapshotSynthesizer::CSnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface,
+    CSnapshotSynthesizer::CSnapshotSynthesizer(MEMarketUpdateRing *market_updates, const std::string &iface,
                                              const std::string &snapshot_ip, int snapshot_port)
-        : m_snapshotMdUpdates(market_updates), m_logger("exchange_snapshot_synthesizer.log"), m_snapshotSocket(m_logger), m_orderPool(ME_MAX_ORDER_IDS)
+        : m_snapshotMdUpdates(market_updates->AddReader(&m_waitStrategy)), m_logger("exchange_snapshot_synthesizer.log"), m_snapshotSocket(m_logger), m_orderPool(ME_MAX_ORDER_IDS, "exchange:snapshot_orders")
     {
+        // Incremental sequence numbers are the ring sequence plus one, same as the market data publisher assigns them.
+        m_lastIncSeqNum = m_snapshotMdUpdates->ReadSequence();
+
         ASSERT(m_snapshotSocket.Init(snapshot_ip, iface, snapshot_port, /*is_listening*/ false) >= 0,
                "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
     }
@@ -30,9 +33,9 @@ namespace Exchange
     }
 
     /// Process an incremental market update and update the limit order book snapshot.
-    auto CSnapshotSynthesizer::AddToSnapshot(const MDPMarketUpdate *market_update)
+    auto CSnapshotSynthesizer::AddToSnapshot(size_t seq_num, const SMEMarketUpdate *market_update)
     {
-        const auto &me_market_update = market_update->me_market_update_;
+        const auto &me_market_update = *market_update;
         auto *orders = &m_tickerOrders.at(me_market_update.tickerId);
         switch (me_market_update.type)
         {
@@ -47,8 +50,8 @@ namespace Exchange
             {
                 auto order = orders->at(me_market_update.orderId);
                 ASSERT(order != nullptr, "Received:" + me_market_update.ToString() + " but order does not exist.");
-                ASSERT(order->orderId == me_market_update.orderId, "Expecting existing order to match new one.");
-                ASSERT(order->side == me_market_update.side, "Expecting existing order to match new one.");
+                DEBUG_ASSERT(order->orderId == me_market_update.orderId, "Expecting existing order to match new one.");
+                DEBUG_ASSERT(order->side == me_market_update.side, "Expecting existing order to match new one.");
 
                 order->qty = me_market_update.qty;
                 order->price = me_market_update.price;
@@ -58,8 +61,8 @@ namespace Exchange
             {
                 auto order = orders->at(me_market_update.orderId);
                 ASSERT(order != nullptr, "Received:" + me_market_update.ToString() + " but order does not exist.");
-                ASSERT(order->orderId == me_market_update.orderId, "Expecting existing order to match new one.");
-                ASSERT(order->side == me_market_update.side, "Expecting existing order to match new one.");
+                DEBUG_ASSERT(order->orderId == me_market_update.orderId, "Expecting existing order to match new one.");
+                DEBUG_ASSERT(order->side == me_market_update.side, "Expecting existing order to match new one.");
 
                 m_orderPool.Deallocate(order);
                 orders->at(me_market_update.orderId) = nullptr;
@@ -73,8 +76,8 @@ namespace Exchange
                 break;
         }
 
-        ASSERT(market_update->seqNum == m_lastIncSeqNum + 1, "Expected incremental seq_nums to increase.");
-        m_lastIncSeqNum = market_update->seqNum;
+        ASSERT(seq_num == m_lastIncSeqNum + 1, "Expected incremental seq_nums to increase.");
+        m_lastIncSeqNum = seq_num;
     }
 
     /// Publish a full snapshot cycle on the snapshot multicast stream.
@@ -84,7 +87,7 @@ namespace Exchange
 
         // The snapshot cycle starts with a SNAPSHOT_START message and orderId contains the last sequence number from the incremental market data stream used to build this snapshot.
         const MDPMarketUpdate start_market_update{snapshot_size++, {EMarketUpdateType::SNAPSHOT_START, m_lastIncSeqNum}};
-        m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, GetCurrentTimeStr(&m_timeStr), start_market_update.ToString());
+        LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, start_market_update);
         m_snapshotSocket.Send(&start_market_update, sizeof(MDPMarketUpdate));
 
         // Publish order information for each order in the limit order book for each instrument.
@@ -98,7 +101,7 @@ namespace Exchange
 
             // We start order information for each instrument by first publishing a CLEAR message so the downstream consumer can clear the order book.
             const MDPMarketUpdate clear_market_update{snapshot_size++, me_market_update};
-            m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, GetCurrentTimeStr(&m_timeStr), clear_market_update.ToString());
+            LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, clear_market_update);
             m_snapshotSocket.Send(&clear_market_update, sizeof(MDPMarketUpdate));
 
             // Publish each order.
@@ -107,7 +110,7 @@ namespace Exchange
                 if (order)
                 {
                     const MDPMarketUpdate market_update{snapshot_size++, *order};
-                    m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, GetCurrentTimeStr(&m_timeStr), market_update.ToString());
+                    LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, market_update);
                     m_snapshotSocket.Send(&market_update, sizeof(MDPMarketUpdate));
                     m_snapshotSocket.SendAndRecv();
                 }
@@ -116,27 +119,30 @@ namespace Exchange
 
         // The snapshot cycle ends with a SNAPSHOT_END message and orderId contains the last sequence number from the incremental market data stream used to build this snapshot.
         const MDPMarketUpdate end_market_update{snapshot_size++, {EMarketUpdateType::SNAPSHOT_END, m_lastIncSeqNum}};
-        m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, GetCurrentTimeStr(&m_timeStr), end_market_update.ToString());
+        LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, end_market_update);
         m_snapshotSocket.Send(&end_market_update, sizeof(MDPMarketUpdate));
         m_snapshotSocket.SendAndRecv();
 
-        m_logger.Log("%:% %() % Published snapshot of % orders.\n", __FILE__, __LINE__, __FUNCTION__, GetCurrentTimeStr(&m_timeStr), snapshot_size - 1);
+        LOG_DEBUG(m_logger, "%:% %() Published snapshot of % orders.\n", __FILE__, __LINE__, __FUNCTION__, snapshot_size - 1);
     }
 
-    /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot and publishes the snapshot periodically.
+    /// Main method for this thread - processes incremental updates from the matching engine, updates the snapshot and publishes the snapshot periodically.
     void CSnapshotSynthesizer::Run()
     {
-        m_logger.Log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, GetCurrentTimeStr(&m_timeStr));
+        LOG_INFO(m_logger, "%:% %()\n", __FILE__, __LINE__, __FUNCTION__);
         while (m_isRunning)
         {
-            for (auto market_update = m_snapshotMdUpdates->GetNextToRead(); m_snapshotMdUpdates->size() && market_update; market_update = m_snapshotMdUpdates->GetNextToRead())
+            bool did_work = false;
+            for (auto market_update = m_snapshotMdUpdates->GetNextToRead(); market_update; market_update = m_snapshotMdUpdates->GetNextToRead())
             {
-                m_logger.Log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, GetCurrentTimeStr(&m_timeStr),
-                            market_update->ToString().c_str());
+                const auto seq_num = m_snapshotMdUpdates->ReadSequence() + 1;
+                LOG_TRACE(m_logger, "%:% %() Processing seq:% %\n", __FILE__, __LINE__, __FUNCTION__, seq_num,
+                            *market_update);
 
-                AddToSnapshot(market_update);
+                AddToSnapshot(seq_num, market_update);
 
                 m_snapshotMdUpdates->UpdateReadIndex();
+                did_work = true;
             }
 
             if (GetCurrentNanos() - m_lastSnapshotTime > 60 * NANOS_TO_SECS)
@@ -144,6 +150,8 @@ namespace Exchange
                 m_lastSnapshotTime = GetCurrentNanos();
                 PublishSnapshot();
             }
+
+            m_waitStrategy.OnPoll(did_work);
         }
     }
 }
@@ -2,10 +2,11 @@
 
 #include "common/Types.h"
 #include "common/ThreadUtils.h"
-#include "common/LockFreeQueue.h"
+#include "common/OptLockFreeQueue.h"
 #include "common/Macros.h"
 #include "common/MultiCastSocket.h"
 #include "common/MemoryPool.h"
+#include "common/SegmentedMemoryPool.h"
 #include "common/Logging.h"
 
 #include "market_data/MarketUpdate.h"
@@ -18,7 +19,7 @@ namespace Exchange
     class CSnapshotSynthesizer
     {
     public:
-        CSnapshotSynthesizer(MDPMarketUpdateLFQueue* market_updates, const std::string &iface,
+        CSnapshotSynthesizer(MEMarketUpdateRing* market_updates, const std::string &iface,
                             const std::string& snapshot_ip, int snapshot_port);
 
         ~CSnapshotSynthesizer();
@@ -28,13 +29,19 @@ namespace Exchange
 
         auto Stop() -> void;
 
+        /// Idle behaviour of the run loop, only call before Start(). The market update ring unparks it on every publish.
+        auto SetWaitStrategy(Common::EWaitStrategy strategy) noexcept
+        {
+            m_waitStrategy.SetStrategy(strategy);
+        }
+
         /// Process an incremental market update and update the limit order book snapshot.
-        auto AddToSnapshot(const MDPMarketUpdate* pMarketUpdate);
+        auto AddToSnapshot(size_t seqNum, const SMEMarketUpdate* pMarketUpdate);
 
         /// Publish a full snapshot cycle on the snapshot multicast stream.
         auto PublishSnapshot();
 
-        /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot and publishes the snapshot periodically.
+        /// Main method for this thread - processes incremental updates from the matching engine, updates the snapshot and publishes the snapshot periodically.
         auto Run() -> void;
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -45,14 +52,17 @@ namespace Exchange
         CSnapshotSynthesizer &operator=(const CSnapshotSynthesizer &&) = delete;
 
     private:
-        /// Lock free queue containing incremental market data updates coming in from the market data publisher.
-        MDPMarketUpdateLFQueue *m_snapshotMdUpdates = nullptr;
+        /// Our read cursor on the broadcast ring of incremental market data updates written by the matching engine.
+        MEMarketUpdateRing::CReader *m_snapshotMdUpdates = nullptr;
 
         CLogger m_logger;
 
         volatile bool m_isRunning = false;
 
-        std::string m_timeStr;
+        /// What the run loop does after a pass that found nothing to process.
+        /// Yields by default: the synthesizer is off the critical path and should not compete with the matching engine and publisher for cores,
+        /// but it shares the ring's back-pressure with them so it must never sleep while the matching engine waits for it to catch up.
+        Common::CWaitStrategy m_waitStrategy{Common::EWaitStrategy::YIELD};
 
         /// Multicast socket for the snapshot multicast stream.
         SMultiCastSocket m_snapshotSocket;
@@ -63,7 +73,7 @@ namespace Exchange
         size_t m_lastIncSeqNum = 0;
         Nanos  m_lastSnapshotTime = 0;
 
-        /// Memory pool to manage SMEMarketUpdate messages for the orders in the snapshot limit order books.
-        CMemoryPool<SMEMarketUpdate> m_orderPool;
+        /// Memory pool to manage SMEMarketUpdate messages for the orders in the snapshot limit order books, committed as the books grow.
+        CSegmentedMemoryPool<SMEMarketUpdate> m_orderPool;
     };
 }
@@ -3,10 +3,15 @@
 namespace Exchange
 {
     CMatchingEngine::CMatchingEngine(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses,
-                                   MEMarketUpdateLFQueue *market_updates)
+                                   MEMarketUpdateRing *market_updates)
         : m_pIncomingRequests(client_requests), m_pOutgoingOgwResponses(client_responses), m_pOutgoingMdUpdates(market_updates),
-          m_logger("exchange_matching_engine.log")
+          m_logger("exchange_matching_engine.log"),
+          m_requestsCounter(CMetricsRegistry::Instance().Counter("exchange:matching_engine:requests")),
+          m_responsesCounter(CMetricsRegistry::Instance().Counter("exchange:matching_engine:responses")),
+          m_marketUpdatesCounter(CMetricsRegistry::Instance().Counter("exchange:matching_engine:market_updates"))
     {
+        m_pIncomingRequests->SetConsumerWaitStrategy(&m_waitStrategy);
+
         for (size_t i = 0; i < m_tickerOrderBook.size(); ++i)
         {
             m_tickerOrderBook[i] = new CMEOrderBook(i, &m_logger, this);
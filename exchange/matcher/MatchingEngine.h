@@ -1,8 +1,10 @@
 #pragma once
 
+#include "common/AllocationTracker.h"
 #include "common/ThreadUtils.h"
-#include "common/LockFreeQueue.h"
+#include "common/OptLockFreeQueue.h"
 #include "common/Macros.h"
+#include "common/Metrics.h"
 
 #include "order_server/ClientRequest.h"
 #include "order_server/ClientResponse.h"
@@ -17,7 +19,7 @@ namespace Exchange
     public:
         CMatchingEngine(ClientRequestLFQueue *client_requests,
                        ClientResponseLFQueue *client_responses,
-                       MEMarketUpdateLFQueue *market_updates);
+                       MEMarketUpdateRing *market_updates);
 
         ~CMatchingEngine();
 
@@ -26,6 +28,12 @@ namespace Exchange
 
         auto Stop() -> void;
 
+        /// Idle behaviour of the run loop, only call before Start().
+        auto SetWaitStrategy(Common::EWaitStrategy strategy) noexcept
+        {
+            m_waitStrategy.SetStrategy(strategy);
+        }
+
         /// Called to process a client request read from the lock free queue sent by the order server.
         auto ProcessClientRequest(const SMEClientRequest *client_request) noexcept
         {
@@ -37,7 +45,7 @@ namespace Exchange
                 START_MEASURE(Exchange_MEOrderBook_add);
                 order_book->AddOrder(client_request->clientId, client_request->orderId, client_request->tickerId,
                                 client_request->side, client_request->price, client_request->qty);
-                END_MEASURE(Exchange_MEOrderBook_add, m_logger);
+                END_MEASURE(Exchange_MEOrderBook_add);
             }
             break;
 
@@ -45,7 +53,7 @@ namespace Exchange
             {
                 START_MEASURE(Exchange_MEOrderBook_cancel);
                 order_book->CancelOrder(client_request->clientId, client_request->orderId, client_request->tickerId);
-                END_MEASURE(Exchange_MEOrderBook_cancel, m_logger);
+                END_MEASURE(Exchange_MEOrderBook_cancel);
             }
             break;
 
@@ -60,41 +68,57 @@ namespace Exchange
         /// Write client responses to the lock free queue for the order server to consume.
         auto SendClientResponse(const SMEClientResponse *client_response) noexcept
         {
-            m_logger.Log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), client_response->ToString());
+            LOG_TRACE(m_logger, "%:% %() Sending %\n", __FILE__, __LINE__, __FUNCTION__, *client_response);
             auto next_write = m_pOutgoingOgwResponses->GetNextToWriteTo();
-            *next_write = std::move(*client_response);
+            *next_write = {*client_response, m_trace};
+            TRACE_HOP(next_write->trace, T4t_MatchingEngine_LFQueue_write);
             m_pOutgoingOgwResponses->UpdateWriteIndex();
-            TTT_MEASURE(T4t_MatchingEngine_LFQueue_write, m_logger);
+            m_responsesCounter.Increment();
+            FLIGHT_RECORD(RESPONSE_QUEUED, Common::MakeOrderTraceId(client_response->clientId, client_response->clientOrderId), client_response->tickerId,
+                          client_response->side, client_response->price, client_response->execQty, client_response->type);
         }
 
-        /// Write market data update to the lock free queue for the market data publisher to consume.
+        /// Write market data update to the broadcast ring for the market data publisher and snapshot synthesizer to consume.
         auto SendMarketUpdate(const SMEMarketUpdate *market_update) noexcept
         {
-            m_logger.Log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), market_update->ToString());
+            LOG_TRACE(m_logger, "%:% %() Sending %\n", __FILE__, __LINE__, __FUNCTION__, *market_update);
             auto next_write = m_pOutgoingMdUpdates->GetNextToWriteTo();
-            *next_write = *market_update;
+            *next_write = {*market_update, m_trace};
+            TRACE_HOP(next_write->trace, T4_MatchingEngine_LFQueue_write);
             m_pOutgoingMdUpdates->UpdateWriteIndex();
-            TTT_MEASURE(T4_MatchingEngine_LFQueue_write, m_logger);
+            m_marketUpdatesCounter.Increment();
+            FLIGHT_RECORD(MARKET_UPDATE_QUEUED, market_update->orderId, market_update->tickerId, market_update->side, market_update->price,
+                          market_update->qty, market_update->type);
         }
 
         /// Main loop for this thread - processes incoming client requests which in turn generates client responses and market updates.
         auto Run() noexcept
         {
-            m_logger.Log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_INFO(m_logger, "%:% %()\n", __FILE__, __LINE__, __FUNCTION__);
+
+            Common::PreregisterMeasures({"Exchange_MatchingEngine_processClientRequest", "Exchange_MEOrderBook_add", "Exchange_MEOrderBook_cancel",
+                                         "Exchange_MEOrderBook_addOrder", "Exchange_MEOrderBook_removeOrder", "Exchange_MEOrderBook_match",
+                                         "Exchange_MEOrderBook_checkForMatch"});
+
             while (m_isRunning)
             {
                 const auto me_client_request = m_pIncomingRequests->GetNextToRead();
                 if (LIKELY(me_client_request))
                 {
-                    TTT_MEASURE(T3_MatchingEngine_LFQueue_read, m_logger);
+                    m_trace = me_client_request->trace;
+                    TRACE_HOP(m_trace, T3_MatchingEngine_LFQueue_read);
 
-                    m_logger.Log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                                me_client_request->ToString());
+                    LOG_TRACE(m_logger, "%:% %() Processing %\n", __FILE__, __LINE__, __FUNCTION__, *me_client_request);
                     START_MEASURE(Exchange_MatchingEngine_processClientRequest);
                     ProcessClientRequest(me_client_request);
-                    END_MEASURE(Exchange_MatchingEngine_processClientRequest, m_logger);
+                    END_MEASURE(Exchange_MatchingEngine_processClientRequest);
+                    FLIGHT_RECORD(REQUEST_PROCESSED, Common::MakeOrderTraceId(me_client_request->clientId, me_client_request->orderId),
+                                  me_client_request->tickerId, me_client_request->side, me_client_request->price, me_client_request->qty, me_client_request->type);
                     m_pIncomingRequests->UpdateReadIndex();
+                    m_requestsCounter.Increment();
                 }
+                ALLOCATION_FREE_AFTER_WARMUP("exchange:matching_engine", me_client_request != nullptr);
+                m_waitStrategy.OnPoll(me_client_request != nullptr);
             }
         }
 
@@ -112,14 +136,24 @@ namespace Exchange
         /// Lock free queues.
         /// One to consume incoming client requests sent by the order server.
         /// Second to publish outgoing client responses to be consumed by the order server.
-        /// Third to publish outgoing market updates to be consumed by the market data publisher.
+        /// Broadcast ring to publish outgoing market updates to be consumed by the market data publisher and the snapshot synthesizer.
         ClientRequestLFQueue*  m_pIncomingRequests     = nullptr;
         ClientResponseLFQueue* m_pOutgoingOgwResponses = nullptr;
-        MEMarketUpdateLFQueue* m_pOutgoingMdUpdates    = nullptr;
+        MEMarketUpdateRing*    m_pOutgoingMdUpdates    = nullptr;
+
+        /// Trace of the client request being processed, carried on by the client responses and market updates it generates.
+        Common::STraceContext m_trace;
 
         volatile bool m_isRunning = false;
 
-        std::string m_timeStr;
+        /// What the run loop does after a pass that found nothing to process.
+        Common::CWaitStrategy m_waitStrategy;
+
         CLogger m_logger;
+
+        /// Live message counts, published through CMetricsRegistry.
+        Common::CMetricCounter m_requestsCounter;
+        Common::CMetricCounter m_responsesCounter;
+        Common::CMetricCounter m_marketUpdatesCounter;
     };
 }
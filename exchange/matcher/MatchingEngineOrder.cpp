@@ -2,22 +2,24 @@
 
 namespace Exchange
 {
-    auto SMEOrder::ToString() const -> std::string
+    auto SMEOrder::Format(CFormatBuffer &out) const -> void
     {
-        std::stringstream ss;
-        ss << "SMEOrder"
-           << "["
-           << "ticker:" << TickerIdToString(tickerId) << " "
-           << "cid:" << ClientIdToString(clientId) << " "
-           << "oid:" << OrderIdToString(clientOrderId) << " "
-           << "moid:" << OrderIdToString(marketOrderId) << " "
-           << "side:" << SideToString(side) << " "
-           << "price:" << PriceToString(price) << " "
-           << "qty:" << QtyToString(qty) << " "
-           << "prio:" << PriorityToString(priority) << " "
-           << "prev:" << OrderIdToString(pPrevOrder ? pPrevOrder->marketOrderId : OrderId_INVALID) << " "
-           << "next:" << OrderIdToString(pNextOrder ? pNextOrder->marketOrderId : OrderId_INVALID) << "]";
+        out << "SMEOrder"
+            << "["
+            << "ticker:" << FormatTickerId(tickerId) << " "
+            << "cid:" << FormatClientId(clientId) << " "
+            << "oid:" << FormatOrderId(clientOrderId) << " "
+            << "moid:" << FormatOrderId(marketOrderId) << " "
+            << "side:" << FormatSide(side) << " "
+            << "price:" << FormatPrice(price) << " "
+            << "qty:" << FormatQty(qty) << " "
+            << "prio:" << FormatPriority(priority) << " "
+            << "prev:" << FormatOrderId(pPrevOrder ? pPrevOrder->marketOrderId : OrderId_INVALID) << " "
+            << "next:" << FormatOrderId(pNextOrder ? pNextOrder->marketOrderId : OrderId_INVALID) << "]";
+    }
 
-        return ss.str();
+    auto SMEOrder::ToString() const -> std::string
+    {
+        return FormatToString(*this);
     }
 }
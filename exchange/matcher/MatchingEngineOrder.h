@@ -1,7 +1,6 @@
 #pragma once
 
 #include <array>
-#include <sstream>
 #include "common/Types.h"
 
 using namespace Common;
@@ -40,6 +39,8 @@ namespace Exchange
             , pPrevOrder(prev_order)
             , pNextOrder(next_order) {}
 
+        auto Format(CFormatBuffer &out) const -> void;
+
         auto ToString() const -> std::string;
     };
 
@@ -74,17 +75,28 @@ namespace Exchange
         {            
         }
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "SMEOrdersAtPrice["
+                << "side:" << FormatSide(side) << " "
+                << "price:" << FormatPrice(price) << " "
+                << "first_me_order:";
+            if (pFirstMeOrder)
+            {
+                out << *pFirstMeOrder;
+            }
+            else
+            {
+                out << "null";
+            }
+            out << " "
+                << "prev:" << FormatPrice(pPrevEntry ? pPrevEntry->price : Price_INVALID) << " "
+                << "next:" << FormatPrice(pNextEntry ? pNextEntry->price : Price_INVALID) << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "SMEOrdersAtPrice["
-               << "side:" << SideToString(side) << " "
-               << "price:" << PriceToString(price) << " "
-               << "first_me_order:" << (pFirstMeOrder ? pFirstMeOrder->ToString() : "null") << " "
-               << "prev:" << PriceToString(pPrevEntry ? pPrevEntry->price : Price_INVALID) << " "
-               << "next:" << PriceToString(pNextEntry ? pNextEntry->price : Price_INVALID) << "]";
-
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
@@ -5,15 +5,15 @@
 namespace Exchange
 {
     CMEOrderBook::CMEOrderBook(TickerId ticker_id, CLogger *logger, CMatchingEngine *matching_engine)
-        : m_tickerId(ticker_id), m_pMatchingEngine(matching_engine), m_ordersAtPricePool(ME_MAX_PRICE_LEVELS), m_orderPool(ME_MAX_ORDER_IDS),
+        : m_tickerId(ticker_id), m_pMatchingEngine(matching_engine), m_ordersAtPricePool(ME_MAX_PRICE_LEVELS, "exchange:orders_at_price:" + std::to_string(ticker_id)),
+          m_orderPool(ME_MAX_ORDER_IDS, "exchange:orders:" + std::to_string(ticker_id)),
           m_pLogger(logger)
     {
     }
 
     CMEOrderBook::~CMEOrderBook()
     {
-        m_pLogger->Log("%:% %() % OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                     ToString(false, true));
+        LOG_TRACE(*m_pLogger, "%:% %() OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__, ToString(false, true));
 
         m_pMatchingEngine = nullptr;
         m_pBidsByPrice = m_pAsksByPrice = nullptr;
@@ -34,6 +34,7 @@ namespace Exchange
 
         *leaves_qty -= fill_qty;
         order->qty -= fill_qty;
+        FLIGHT_RECORD(MATCH, Common::MakeOrderTraceId(client_id, client_order_id), ticker_id, side, itr->price, fill_qty, 0);
 
         m_clientResponse = {EClientResponseType::FILLED, client_id, ticker_id, client_order_id,
                             new_market_order_id, side, itr->price, fill_qty, *leaves_qty};
@@ -54,7 +55,7 @@ namespace Exchange
 
             START_MEASURE(Exchange_MEOrderBook_removeOrder);
             RemoveOrder(order);
-            END_MEASURE(Exchange_MEOrderBook_removeOrder, (*m_pLogger));
+            END_MEASURE(Exchange_MEOrderBook_removeOrder);
         }
         else
         {
@@ -82,7 +83,7 @@ namespace Exchange
 
                 START_MEASURE(Exchange_MEOrderBook_match);
                 Match(ticker_id, client_id, side, client_order_id, new_market_order_id, ask_itr, &leaves_qty);
-                END_MEASURE(Exchange_MEOrderBook_match, (*m_pLogger));
+                END_MEASURE(Exchange_MEOrderBook_match);
             }
         }
         if (side == ESide::SELL)
@@ -97,7 +98,7 @@ namespace Exchange
 
                 START_MEASURE(Exchange_MEOrderBook_match);
                 Match(ticker_id, client_id, side, client_order_id, new_market_order_id, bid_itr, &leaves_qty);
-                END_MEASURE(Exchange_MEOrderBook_match, (*m_pLogger));
+                END_MEASURE(Exchange_MEOrderBook_match);
             }
         }
 
@@ -114,7 +115,7 @@ namespace Exchange
 
         START_MEASURE(Exchange_MEOrderBook_checkForMatch);
         const auto leaves_qty = CheckForMatch(client_id, client_order_id, ticker_id, side, price, qty, new_market_order_id);
-        END_MEASURE(Exchange_MEOrderBook_checkForMatch, (*m_pLogger));
+        END_MEASURE(Exchange_MEOrderBook_checkForMatch);
 
         if (LIKELY(leaves_qty))
         {
@@ -124,7 +125,7 @@ namespace Exchange
                                               nullptr);
             START_MEASURE(Exchange_MEOrderBook_addOrder);
             AddOrder(order);
-            END_MEASURE(Exchange_MEOrderBook_addOrder, (*m_pLogger));
+            END_MEASURE(Exchange_MEOrderBook_addOrder);
 
             m_marketUpdate = {EMarketUpdateType::ADD, new_market_order_id, ticker_id, side, price, leaves_qty, priority};
             m_pMatchingEngine->SendMarketUpdate(&m_marketUpdate);
@@ -157,7 +158,7 @@ namespace Exchange
 
             START_MEASURE(Exchange_MEOrderBook_removeOrder);
             RemoveOrder(exchange_order);
-            END_MEASURE(Exchange_MEOrderBook_removeOrder, (*m_pLogger));
+            END_MEASURE(Exchange_MEOrderBook_removeOrder);
 
             m_pMatchingEngine->SendMarketUpdate(&m_marketUpdate);
         }
@@ -165,14 +166,10 @@ namespace Exchange
         m_pMatchingEngine->SendClientResponse(&m_clientResponse);
     }
 
-    auto CMEOrderBook::ToString(bool detailed, bool validity_check) const -> std::string
+    auto CMEOrderBook::Format(CFormatBuffer &out, bool detailed, bool validity_check) const -> void
     {
-        std::stringstream ss;
-        std::string time_str;
-
-        auto printer = [&](std::stringstream &ss, SMEOrdersAtPrice *itr, ESide side, Price &last_price, bool sanity_check)
+        auto printer = [&](CFormatBuffer &out, SMEOrdersAtPrice *itr, ESide side, Price &last_price, bool sanity_check)
         {
-            char buf[4096];
             Qty qty = 0;
             size_t num_orders = 0;
 
@@ -183,25 +180,21 @@ namespace Exchange
                 if (o_itr->pNextOrder == itr->pFirstMeOrder)
                     break;
             }
-            sprintf(buf, " <px:%3s p:%3s n:%3s> %-3s @ %-5s(%-4s)",
-                    PriceToString(itr->price).c_str(), PriceToString(itr->pPrevEntry->price).c_str(), PriceToString(itr->pNextEntry->price).c_str(),
-                    PriceToString(itr->price).c_str(), QtyToString(qty).c_str(), std::to_string(num_orders).c_str());
-            ss << buf;
+            out << " <px:" << Padded(FormatPrice(itr->price), 3) << " p:" << Padded(FormatPrice(itr->pPrevEntry->price), 3) << " n:" << Padded(FormatPrice(itr->pNextEntry->price), 3)
+                << "> " << Padded(FormatPrice(itr->price), -3) << " @ " << Padded(FormatQty(qty), -5) << "(" << Padded(num_orders, -4) << ")";
             for (auto o_itr = itr->pFirstMeOrder;; o_itr = o_itr->pNextOrder)
             {
                 if (detailed)
                 {
-                    sprintf(buf, "[oid:%s q:%s p:%s n:%s] ",
-                            OrderIdToString(o_itr->marketOrderId).c_str(), QtyToString(o_itr->qty).c_str(),
-                            OrderIdToString(o_itr->pPrevOrder ? o_itr->pPrevOrder->marketOrderId : OrderId_INVALID).c_str(),
-                            OrderIdToString(o_itr->pNextOrder ? o_itr->pNextOrder->marketOrderId : OrderId_INVALID).c_str());
-                    ss << buf;
+                    out << "[oid:" << FormatOrderId(o_itr->marketOrderId) << " q:" << FormatQty(o_itr->qty)
+                        << " p:" << FormatOrderId(o_itr->pPrevOrder ? o_itr->pPrevOrder->marketOrderId : OrderId_INVALID)
+                        << " n:" << FormatOrderId(o_itr->pNextOrder ? o_itr->pNextOrder->marketOrderId : OrderId_INVALID) << "] ";
                 }
                 if (o_itr->pNextOrder == itr->pFirstMeOrder)
                     break;
             }
 
-            ss << std::endl;
+            out << '\n';
 
             if (sanity_check)
             {
@@ -213,35 +206,38 @@ namespace Exchange
             }
         };
 
-        ss << "Ticker:" << TickerIdToString(m_tickerId) << std::endl;
+        out << "Ticker:" << FormatTickerId(m_tickerId) << '\n';
         {
             auto ask_itr = m_pAsksByPrice;
             auto last_ask_price = std::numeric_limits<Price>::min();
             for (size_t count = 0; ask_itr; ++count)
             {
-                ss << "ASKS L:" << count << " => ";
+                out << "ASKS L:" << count << " => ";
                 auto next_ask_itr = (ask_itr->pNextEntry == m_pAsksByPrice ? nullptr : ask_itr->pNextEntry);
-                printer(ss, ask_itr, ESide::SELL, last_ask_price, validity_check);
+                printer(out, ask_itr, ESide::SELL, last_ask_price, validity_check);
                 ask_itr = next_ask_itr;
             }
         }
 
-        ss << std::endl
-           << "                          X" << std::endl
-           << std::endl;
+        out << '\n'
+            << "                          X" << '\n'
+            << '\n';
 
         {
             auto bid_itr = m_pBidsByPrice;
             auto last_bid_price = std::numeric_limits<Price>::max();
             for (size_t count = 0; bid_itr; ++count)
             {
-                ss << "BIDS L:" << count << " => ";
+                out << "BIDS L:" << count << " => ";
                 auto next_bid_itr = (bid_itr->pNextEntry == m_pBidsByPrice ? nullptr : bid_itr->pNextEntry);
-                printer(ss, bid_itr, ESide::BUY, last_bid_price, validity_check);
+                printer(out, bid_itr, ESide::BUY, last_bid_price, validity_check);
                 bid_itr = next_bid_itr;
             }
         }
+    }
 
-        return ss.str();
+    auto CMEOrderBook::ToString(bool detailed, bool validity_check) const -> std::string
+    {
+        return FormatToString([&](CFormatBuffer &out) { Format(out, detailed, validity_check); });
     }
 }
@@ -4,6 +4,7 @@
 
 #include "common/Types.h"
 #include "common/MemoryPool.h"
+#include "common/SegmentedMemoryPool.h"
 #include "common/Logging.h"
 #include "order_server/ClientResponse.h"
 #include "market_data/MarketUpdate.h"
@@ -30,6 +31,9 @@ namespace Exchange
         /// Attempt to cancel an order in the order book, issue a cancel-rejection if order does not exist.
         auto CancelOrder(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void;
 
+        /// Dump the book into a caller provided buffer, without allocating. Output that does not fit is dropped, see CFormatBuffer::IsTruncated().
+        auto Format(CFormatBuffer &out, bool detailed, bool validityCheck) const -> void;
+
         auto ToString(bool detailed, bool validityCheck) const -> std::string;
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -58,8 +62,8 @@ namespace Exchange
         /// Hash map from Price -> SMEOrdersAtPrice.
         std::unordered_map<Price, SMEOrdersAtPrice*> m_priceOrdersAtPrice;
 
-        /// Memory pool to manage SMEOrder objects.
-        CMemoryPool<SMEOrder> m_orderPool;
+        /// Memory pool to manage SMEOrder objects, address space for ME_MAX_ORDER_IDS is reserved but memory is only committed as the book grows.
+        CSegmentedMemoryPool<SMEOrder> m_orderPool;
 
         /// These are used to publish client responses and market updates.
         SMEClientResponse m_clientResponse;
@@ -67,8 +71,7 @@ namespace Exchange
 
         OrderId m_nextMarketOrderId = 1;
 
-        std::string m_timeStr;
-        CLogger*    m_pLogger = nullptr;
+        CLogger* m_pLogger = nullptr;
 
     private:
         auto GenerateNewMarketOrderId() noexcept -> OrderId
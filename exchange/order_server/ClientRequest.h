@@ -1,9 +1,10 @@
 #pragma once
 
-#include <sstream>
-
 #include "common/Types.h"
-#include "common/LockFreeQueue.h"
+#include "common/LogRecord.h"
+#include "common/OptLockFreeQueue.h"
+#include "common/ShmLockFreeQueue.h"
+#include "common/Trace.h"
 
 using namespace Common;
 
@@ -17,7 +18,7 @@ namespace Exchange
         CANCEL = 2
     };
 
-    inline std::string ClientRequestTypeToString(EClientRequestType type)
+    inline constexpr auto FormatClientRequestType(EClientRequestType type) noexcept -> std::string_view
     {
         switch (type)
         {
@@ -31,6 +32,11 @@ namespace Exchange
         return "UNKNOWN";
     }
 
+    inline auto ClientRequestTypeToString(EClientRequestType type) -> std::string
+    {
+        return std::string(FormatClientRequestType(type));
+    }
+
     /// These structures go over the wire / network, so the binary structures are packed to remove system dependent extra padding.
 #pragma pack(push, 1)
 
@@ -46,20 +52,23 @@ namespace Exchange
         Price    price    = Price_INVALID;
         Qty      qty      = Qty_INVALID;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "SMEClientRequest"
+                << " ["
+                << "type:"    << FormatClientRequestType(type)
+                << " client:" << FormatClientId(clientId)
+                << " ticker:" << FormatTickerId(tickerId)
+                << " oid:"    << FormatOrderId(orderId)
+                << " side:"   << FormatSide(side)
+                << " qty:"    << FormatQty(qty)
+                << " price:"  << FormatPrice(price)
+                << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "SMEClientRequest"
-               << " ["
-               << "type:"    << ClientRequestTypeToString(type)
-               << " client:" << ClientIdToString(clientId)
-               << " ticker:" << TickerIdToString(tickerId)
-               << " oid:"    << OrderIdToString(orderId)
-               << " side:"   << SideToString(side)
-               << " qty:"    << QtyToString(qty)
-               << " price:"  << PriceToString(price)
-               << "]";
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
@@ -69,20 +78,30 @@ namespace Exchange
         size_t           seqNum = 0;
         SMEClientRequest meClientRequest;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "SOMClientRequest"
+                << " ["
+                << "seq:" << static_cast<size_t>(seqNum)
+                << " " << meClientRequest
+                << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "SOMClientRequest"
-               << " ["
-               << "seq:" << seqNum
-               << " " << meClientRequest.ToString()
-               << "]";
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
 #pragma pack(pop) // Undo the packed binary structure directive moving forward.
 
-    /// Lock free queues of matching engine client order request messages.
-    typedef CLockFreeQueue<SMEClientRequest> ClientRequestLFQueue;
+    /// Lock free queues of matching engine client order request messages, each with the trace context it carries through the process.
+    typedef OptCommon::COptLockFreeQueue<Common::STraced<SMEClientRequest>> ClientRequestLFQueue;
+
+    /// Same queue in a named shared memory segment, for components running in separate processes.
+    typedef OptCommon::CShmLockFreeQueue<Common::STraced<SMEClientRequest>> ClientRequestShmQueue;
 }
+
+/// Logged by value, formatted on the logger thread.
+LOG_BY_VALUE(Exchange::SMEClientRequest);
+LOG_BY_VALUE(Exchange::SOMClientRequest);
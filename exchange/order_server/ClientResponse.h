@@ -1,9 +1,10 @@
 #pragma once
 
-#include <sstream>
-
 #include "common/Types.h"
-#include "common/LockFreeQueue.h"
+#include "common/LogRecord.h"
+#include "common/OptLockFreeQueue.h"
+#include "common/ShmLockFreeQueue.h"
+#include "common/Trace.h"
 
 using namespace Common;
 
@@ -19,7 +20,7 @@ namespace Exchange
         CANCEL_REJECTED = 4
     };
 
-    inline std::string ClientResponseTypeToString(EClientResponseType type)
+    inline constexpr auto FormatClientResponseType(EClientResponseType type) noexcept -> std::string_view
     {
         switch (type)
         {
@@ -37,6 +38,11 @@ namespace Exchange
         return "UNKNOWN";
     }
 
+    inline auto ClientResponseTypeToString(EClientResponseType type) -> std::string
+    {
+        return std::string(FormatClientResponseType(type));
+    }
+
     /// These structures go over the wire / network, so the binary structures are packed to remove system dependent extra padding.
 #pragma pack(push, 1)
 
@@ -53,22 +59,25 @@ namespace Exchange
         Qty                 execQty       = Qty_INVALID;
         Qty                 leavesQty     = Qty_INVALID;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "SMEClientResponse"
+                << " ["
+                << "type:" << FormatClientResponseType(type)
+                << " client:" << FormatClientId(clientId)
+                << " ticker:" << FormatTickerId(tickerId)
+                << " coid:" << FormatOrderId(clientOrderId)
+                << " moid:" << FormatOrderId(marketOrderId)
+                << " side:" << FormatSide(side)
+                << " exec_qty:" << FormatQty(execQty)
+                << " leaves_qty:" << FormatQty(leavesQty)
+                << " price:" << FormatPrice(price)
+                << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "SMEClientResponse"
-               << " ["
-               << "type:" << ClientResponseTypeToString(type)
-               << " client:" << ClientIdToString(clientId)
-               << " ticker:" << TickerIdToString(tickerId)
-               << " coid:" << OrderIdToString(clientOrderId)
-               << " moid:" << OrderIdToString(marketOrderId)
-               << " side:" << SideToString(side)
-               << " exec_qty:" << QtyToString(execQty)
-               << " leaves_qty:" << QtyToString(leavesQty)
-               << " price:" << PriceToString(price)
-               << "]";
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
@@ -78,20 +87,30 @@ namespace Exchange
         size_t            seqNum = 0;
         SMEClientResponse meClientResponse;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "SOMClientResponse"
+                << " ["
+                << "seq:" << static_cast<size_t>(seqNum)
+                << " " << meClientResponse
+                << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "SOMClientResponse"
-               << " ["
-               << "seq:" << seqNum
-               << " " << meClientResponse.ToString()
-               << "]";
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
 #pragma pack(pop) // Undo the packed binary structure directive moving forward.
 
-    /// Lock free queues of matching engine client order response messages.
-    typedef CLockFreeQueue<SMEClientResponse> ClientResponseLFQueue;
+    /// Lock free queues of matching engine client order response messages, each with the trace context it carries through the process.
+    typedef OptCommon::COptLockFreeQueue<Common::STraced<SMEClientResponse>> ClientResponseLFQueue;
+
+    /// Same queue in a named shared memory segment, for components running in separate processes.
+    typedef OptCommon::CShmLockFreeQueue<Common::STraced<SMEClientResponse>> ClientResponseShmQueue;
 }
+
+/// Logged by value, formatted on the logger thread.
+LOG_BY_VALUE(Exchange::SMEClientResponse);
+LOG_BY_VALUE(Exchange::SOMClientResponse);
@@ -24,13 +24,16 @@ namespace Exchange
         }
 
         /// Queue up a client request, not processed immediately, processed when SequenceAndPublish() is called.
-        auto AddClientRequest(Nanos rx_time, const SMEClientRequest& request)
+        /// Its trace starts at T1, when the order server read it off the socket at t1Tsc.
+        auto AddClientRequest(Nanos rx_time, const SMEClientRequest& request, TraceId traceId, uint64_t t1Tsc)
         {
             if (m_pendingSize >= m_pendingClientRequests.size())
             {
                 FATAL("Too many pending requests");
             }
-            m_pendingClientRequests.at(m_pendingSize++) = std::move(SRecvTimeClientRequest{rx_time, request});
+            auto &pending = m_pendingClientRequests.at(m_pendingSize++);
+            pending = SRecvTimeClientRequest{rx_time, {request, {}}};
+            pending.request_.trace.Start(traceId, ETraceHop::T1_OrderServer_TCP_read, t1Tsc);
         }
 
         /// Sort pending client requests in ascending receive time order and then write them to the lock free queue for the matching engine to consume from.
@@ -39,22 +42,28 @@ namespace Exchange
             if (UNLIKELY(!m_pendingSize))
                 return;
 
-            m_pLogger->Log("%:% %() % Processing % requests.\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), m_pendingSize);
+            LOG_TRACE(*m_pLogger, "%:% %() Processing % requests.\n", __FILE__, __LINE__, __FUNCTION__, m_pendingSize);
 
             std::sort(m_pendingClientRequests.begin(), m_pendingClientRequests.begin() + m_pendingSize);
 
-            for (size_t i = 0; i < m_pendingSize; ++i)
+            // Publish the whole sorted batch to the matching engine with a single index update.
+            // Only a queue with EQueueFullPolicy::DROP can hand out fewer slots, the queue counts the rest as dropped.
+            auto next_writes = m_pIncomingRequests->ReserveWrite(m_pendingSize);
+            if (UNLIKELY(next_writes.size() < m_pendingSize))
             {
-                const auto &client_request = m_pendingClientRequests.at(i);
+                LOG_WARN(*m_pLogger, "%:% %() Dropping % requests, matching engine queue full.\n", __FILE__, __LINE__, __FUNCTION__, m_pendingSize - next_writes.size());
+            }
+            const auto t2Tsc = Common::rdtsc();
+            for (size_t i = 0; i < next_writes.size(); ++i)
+            {
+                auto &client_request = m_pendingClientRequests.at(i);
 
-                m_pLogger->Log("%:% %() % Writing RX:% Req:% to FIFO.\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                             client_request.recvTime, client_request.request_.ToString());
+                LOG_TRACE(*m_pLogger, "%:% %() Writing RX:% Req:% to FIFO.\n", __FILE__, __LINE__, __FUNCTION__, client_request.recvTime, client_request.request_);
 
-                auto next_write = m_pIncomingRequests->GetNextToWriteTo();
-                *next_write = std::move(client_request.request_);
-                m_pIncomingRequests->UpdateWriteIndex();
-                TTT_MEASURE(T2_OrderServer_LFQueue_write, (*m_pLogger));
+                client_request.request_.trace.Stamp(ETraceHop::T2_OrderServer_LFQueue_write, t2Tsc);
+                next_writes[i] = client_request.request_;
             }
+            m_pIncomingRequests->CommitWrite(next_writes.size());
 
             m_pendingSize = 0;
         }
@@ -70,14 +79,13 @@ namespace Exchange
         /// Lock free queue used to publish client requests to, so that the matching engine can consume them.
         ClientRequestLFQueue *m_pIncomingRequests = nullptr;
 
-        std::string m_timeStr;
-        CLogger*    m_pLogger = nullptr;
+        CLogger* m_pLogger = nullptr;
 
-        /// A structure that encapsulates the software receive time as well as the client request.
+        /// A structure that encapsulates the software receive time as well as the client request and its trace.
         struct SRecvTimeClientRequest
         {
             Nanos recvTime = 0;
-            SMEClientRequest request_;
+            STraced<SMEClientRequest> request_;
 
             auto operator<(const SRecvTimeClientRequest &rhs) const
             {
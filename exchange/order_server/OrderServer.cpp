@@ -4,7 +4,10 @@ namespace Exchange
 {
     COrderServer::COrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, const std::string &iface, int port)
         : m_iface(iface), m_port(port), m_pOutgoingResponses(client_responses), m_logger("exchange_order_server.log"),
-          m_tcpServer(m_logger), m_fifoSequencer(client_requests, &m_logger)
+          m_tcpServer(m_logger), m_fifoSequencer(client_requests, &m_logger),
+          m_requestsCounter(CMetricsRegistry::Instance().Counter("exchange:order_server:requests")),
+          m_rejectedCounter(CMetricsRegistry::Instance().Counter("exchange:order_server:rejected")),
+          m_responsesCounter(CMetricsRegistry::Instance().Counter("exchange:order_server:responses"))
     {
         m_cidNextOutgoingSeqNum.fill(1);
         m_cidNextExpSeqNum.fill(1);
@@ -2,8 +2,10 @@
 
 #include <functional>
 
+#include "common/AllocationTracker.h"
 #include "common/ThreadUtils.h"
 #include "common/Macros.h"
+#include "common/Metrics.h"
 #include "common/TcpServer.h"
 
 #include "order_server/ClientRequest.h"
@@ -22,45 +24,63 @@ namespace Exchange
         auto Start() -> void;
         auto Stop() -> void;
 
+        /// Idle behaviour of the run loop, only call before Start().
+        /// Never EWaitStrategy::PARK, the loop polls its TCP sockets and nothing would unpark it when data arrives.
+        auto SetWaitStrategy(Common::EWaitStrategy strategy) noexcept
+        {
+            ASSERT(strategy != Common::EWaitStrategy::PARK, "COrderServer polls its TCP sockets, nothing unparks it.");
+            m_waitStrategy.SetStrategy(strategy);
+        }
+
         /// Main run loop for this thread - accepts new client connections, receives client requests from them and sends client responses to them.
         auto Run() noexcept
         {
-            m_logger.Log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_INFO(m_logger, "%:% %()\n", __FILE__, __LINE__, __FUNCTION__);
+
+            Common::PreregisterMeasures({"Exchange_TCPSocket_send", "Exchange_FIFOSequencer_addClientRequest", "Exchange_FIFOSequencer_sequenceAndPublish"});
+            Common::PreregisterTraceHops(Common::ETraceHop::T2_OrderServer_LFQueue_write, Common::ETraceHop::T6t_OrderServer_TCP_write);
+
             while (m_isRunning)
             {
                 m_tcpServer.Poll();
 
-                m_tcpServer.SendAndRecv();
+                bool did_work = m_tcpServer.SendAndRecv();
 
-                for (auto client_response = m_pOutgoingResponses->GetNextToRead(); m_pOutgoingResponses->size() && client_response; client_response = m_pOutgoingResponses->GetNextToRead())
+                for (auto client_response = m_pOutgoingResponses->GetNextToRead(); client_response; client_response = m_pOutgoingResponses->GetNextToRead())
                 {
-                    TTT_MEASURE(T5t_OrderServer_LFQueue_read, m_logger);
+                    auto trace = client_response->trace;
+                    TRACE_HOP(trace, T5t_OrderServer_LFQueue_read);
 
                     auto &next_outgoing_seq_num = m_cidNextOutgoingSeqNum[client_response->clientId];
-                    m_logger.Log("%:% %() % Processing cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                                client_response->clientId, next_outgoing_seq_num, client_response->ToString());
+                    LOG_TRACE(m_logger, "%:% %() Processing cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, client_response->clientId, next_outgoing_seq_num, *client_response);
 
                     ASSERT(m_cidTcpSocket[client_response->clientId] != nullptr,
                            "Dont have a CTCPSocket for ClientId:" + std::to_string(client_response->clientId));
                     START_MEASURE(Exchange_TCPSocket_send);
                     m_cidTcpSocket[client_response->clientId]->Send(&next_outgoing_seq_num, sizeof(next_outgoing_seq_num));
-                    m_cidTcpSocket[client_response->clientId]->Send(client_response, sizeof(SMEClientResponse));
-                    END_MEASURE(Exchange_TCPSocket_send, m_logger);
+                    m_cidTcpSocket[client_response->clientId]->Send(static_cast<const SMEClientResponse *>(client_response), sizeof(SMEClientResponse));
+                    END_MEASURE(Exchange_TCPSocket_send);
 
                     m_pOutgoingResponses->UpdateReadIndex();
-                    TTT_MEASURE(T6t_OrderServer_TCP_write, m_logger);
+                    TRACE_END(trace, T6t_OrderServer_TCP_write, m_logger);
+                    m_responsesCounter.Increment();
+                    FLIGHT_RECORD(RESPONSE_SENT, MakeOrderTraceId(client_response->clientId, client_response->clientOrderId), client_response->tickerId,
+                                  client_response->side, client_response->price, client_response->execQty, client_response->type);
 
                     ++next_outgoing_seq_num;
+                    did_work = true;
                 }
+
+                ALLOCATION_FREE_AFTER_WARMUP("exchange:order_server", did_work);
+                m_waitStrategy.OnPoll(did_work);
             }
         }
 
         /// Read client request from the TCP receive buffer, check for sequence gaps and forward it to the FIFO sequencer.
         auto RecvCallback(CTCPSocket *socket, Nanos rx_time) noexcept
         {
-            TTT_MEASURE(T1_OrderServer_TCP_read, m_logger);
-            m_logger.Log("%:% %() % Received socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                        socket->m_fd, socket->m_nextRecvValidIndex, rx_time);
+            const auto t1Tsc = Common::rdtsc();
+            LOG_TRACE(m_logger, "%:% %() Received socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, socket->m_fd, socket->m_nextRecvValidIndex, rx_time);
 
             if (socket->m_nextRecvValidIndex >= sizeof(SOMClientRequest))
             {
@@ -68,7 +88,7 @@ namespace Exchange
                 for (; i + sizeof(SOMClientRequest) <= socket->m_nextRecvValidIndex; i += sizeof(SOMClientRequest))
                 {
                     auto request = reinterpret_cast<const SOMClientRequest *>(socket->m_pRecvBuffer + i);
-                    m_logger.Log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), request->ToString());
+                    LOG_TRACE(m_logger, "%:% %() Received %\n", __FILE__, __LINE__, __FUNCTION__, *request);
 
                     if (UNLIKELY(m_cidTcpSocket[request->meClientRequest.clientId] == nullptr))
                     { // first message from this ClientId.
@@ -77,25 +97,32 @@ namespace Exchange
 
                     if (m_cidTcpSocket[request->meClientRequest.clientId] != socket)
                     { // TODO - change this to send a reject back to the client.
-                        m_logger.Log("%:% %() % Received ClientRequest from ClientId:% on different socket:% expected:%\n", __FILE__, __LINE__, __FUNCTION__,
-                                    Common::GetCurrentTimeStr(&m_timeStr), request->meClientRequest.clientId, socket->m_fd,
+                        LOG_WARN(m_logger, "%:% %() Received ClientRequest from ClientId:% on different socket:% expected:%\n", __FILE__, __LINE__, __FUNCTION__,
+                                    request->meClientRequest.clientId, socket->m_fd,
                                     m_cidTcpSocket[request->meClientRequest.clientId]->m_fd);
+                        m_rejectedCounter.Increment();
                         continue;
                     }
 
                     auto &next_exp_seq_num = m_cidNextExpSeqNum[request->meClientRequest.clientId];
                     if (request->seqNum != next_exp_seq_num)
                     { // TODO - change this to send a reject back to the client.
-                        m_logger.Log("%:% %() % Incorrect sequence number. ClientId:% SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
-                                    Common::GetCurrentTimeStr(&m_timeStr), request->meClientRequest.clientId, next_exp_seq_num, request->seqNum);
+                        LOG_WARN(m_logger, "%:% %() Incorrect sequence number. ClientId:% SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
+                                    request->meClientRequest.clientId, next_exp_seq_num, request->seqNum);
+                        m_rejectedCounter.Increment();
                         continue;
                     }
 
                     ++next_exp_seq_num;
 
                     START_MEASURE(Exchange_FIFOSequencer_addClientRequest);
-                    m_fifoSequencer.AddClientRequest(rx_time, request->meClientRequest);
-                    END_MEASURE(Exchange_FIFOSequencer_addClientRequest, m_logger);
+                    m_fifoSequencer.AddClientRequest(rx_time, request->meClientRequest,
+                                                     MakeOrderTraceId(request->meClientRequest.clientId, request->meClientRequest.orderId), t1Tsc);
+                    END_MEASURE(Exchange_FIFOSequencer_addClientRequest);
+                    m_requestsCounter.Increment();
+                    FLIGHT_RECORD(REQUEST_RECEIVED, MakeOrderTraceId(request->meClientRequest.clientId, request->meClientRequest.orderId),
+                                  request->meClientRequest.tickerId, request->meClientRequest.side, request->meClientRequest.price, request->meClientRequest.qty,
+                                  request->meClientRequest.type);
                 }
                 memcpy(socket->m_pRecvBuffer, socket->m_pRecvBuffer + i, socket->m_nextRecvValidIndex - i);
                 socket->m_nextRecvValidIndex -= i;
@@ -107,7 +134,7 @@ namespace Exchange
         {
             START_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish);
             m_fifoSequencer.SequenceAndPublish();
-            END_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish, m_logger);
+            END_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish);
         }
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -126,8 +153,10 @@ namespace Exchange
 
         volatile bool m_isRunning = false;
 
-        std::string m_timeStr;
-        CLogger     m_logger;
+        /// What the run loop does after a pass that found nothing to process.
+        Common::CWaitStrategy m_waitStrategy;
+
+        CLogger m_logger;
 
         /// Hash map from ClientId -> the next sequence number to be sent on outgoing client responses.
         std::array<size_t, ME_MAX_NUM_CLIENTS> m_cidNextOutgoingSeqNum;
@@ -143,5 +172,10 @@ namespace Exchange
 
         /// FIFO sequencer responsible for making sure incoming client requests are processed in the order in which they were received.
         CFIFOSequencer m_fifoSequencer;
+
+        /// Live message counts, published through CMetricsRegistry. Rejected counts requests dropped for a wrong socket or sequence number.
+        Common::CMetricCounter m_requestsCounter;
+        Common::CMetricCounter m_rejectedCounter;
+        Common::CMetricCounter m_responsesCounter;
     };
 }
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+# Runs the exchange, a market maker and a random order client built with ENABLE_ALLOCATION_TRACKER, then fails if any critical thread
+# allocated after warming up. The backtraces of the allocations are in allocation_check_*.out.
+
+CMAKE=$(which cmake)
+BUILD_DIR=cmake-build-allocation
+
+$CMAKE -DCMAKE_BUILD_TYPE=Release -DENABLE_ALLOCATION_TRACKER=ON -DALLOCATION_TRACKER_POLICY=LOG -S . -B $BUILD_DIR
+$CMAKE --build $BUILD_DIR --target exchange_main trading_main stats_reader -j 4 || exit 1
+
+date
+
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo "Starting Exchange, a market maker and a random order client..."
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./$BUILD_DIR/exchange_main > allocation_check_exchange.out 2>&1 &
+EXCHANGE_PID=$!
+sleep 10
+
+./$BUILD_DIR/trading_main 1 MAKER \
+                          100 0.6 150 300 -100 \
+                          60 0.6 150 300 -100 \
+                          150 0.5 250 600 -100 \
+                          200 0.4 500 3000 -100 \
+                          1000 0.9 5000 4000 -100 \
+                          300 0.8 1500 3000 -100 \
+                          50 0.7 150 300 -100 \
+                          100 0.3 250 300 -100 > allocation_check_maker.out 2>&1 &
+MAKER_PID=$!
+sleep 5
+
+./$BUILD_DIR/trading_main 5 RANDOM > allocation_check_random.out 2>&1 &
+RANDOM_PID=$!
+sleep 90
+
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo "Allocations on the critical threads after warmup..."
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+RESULT=0
+ALLOCATIONS=""
+for PID in $EXCHANGE_PID $MAKER_PID $RANDOM_PID; do
+    if ! kill -0 $PID 2> /dev/null; then
+        echo "FAILED: process $PID exited before the check, see allocation_check_*.out"
+        RESULT=1
+        continue
+    fi
+    ALLOCATIONS+=$(./$BUILD_DIR/stats_reader $PID | grep ":hot_allocations" | sed "s/^/$PID /")$'\n'
+done
+echo "$ALLOCATIONS"
+
+# Background jobs of a script ignore SIGINT, trading_main has no handler of its own to undo that. Killed, it leaves its metrics segment behind.
+kill -TERM $MAKER_PID $RANDOM_PID 2> /dev/null
+kill -INT $EXCHANGE_PID 2> /dev/null
+wait
+rm -f /dev/shm/ull_metrics.trading_main.$MAKER_PID /dev/shm/ull_metrics.trading_main.$RANDOM_PID
+date
+
+# Columns are pid, name, value, rate: any non-zero value is an allocation on a thread that should allocate nothing.
+if echo "$ALLOCATIONS" | awk '$3 > 0 { found = 1 } END { exit !found }'; then
+    echo "FAILED: critical threads allocated after warming up, see the backtraces in allocation_check_*.out"
+    RESULT=1
+fi
+
+[ $RESULT -eq 0 ] && echo "PASSED"
+exit $RESULT
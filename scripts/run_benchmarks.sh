@@ -17,4 +17,9 @@ echo "--------------------------------------------------------------------------
 echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
 echo " Benchmark using std::arrays and std::unordered_maps as hash maps. "
 echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
-./cmake-build-release/hash_benchmark
\ No newline at end of file
+./cmake-build-release/hash_benchmark
+
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+echo " Benchmark cross-core ping-pong latency of the original and cache-line isolated lock free queues. "
+echo "---------------------------------------------------------------------------------------------------------------------------------------------------------"
+./cmake-build-release/queue_benchmark 1 2
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common/FlightRecorder.h"
+#include "common/Trace.h"
+
+#include "order_server/ClientRequest.h"
+#include "order_server/ClientResponse.h"
+#include "market_data/MarketUpdate.h"
+
+/// One record and the thread that recorded it, for the merged timeline.
+struct SThreadRecord
+{
+    const Common::SFlightDumpThread *pThread = nullptr;
+    Common::SFlightRecord            record;
+};
+
+/// The record's type field, named by the message type its event carries.
+static auto FormatType(const Common::SFlightRecord &record) -> std::string
+{
+    using Common::EFlightEvent;
+    switch (record.event)
+    {
+        case EFlightEvent::REQUEST_RECEIVED:
+        case EFlightEvent::REQUEST_PROCESSED:
+        case EFlightEvent::REQUEST_SENT:
+            return Exchange::ClientRequestTypeToString(static_cast<Exchange::EClientRequestType>(record.type));
+        case EFlightEvent::RESPONSE_QUEUED:
+        case EFlightEvent::RESPONSE_SENT:
+        case EFlightEvent::RESPONSE_READ:
+            return Exchange::ClientResponseTypeToString(static_cast<Exchange::EClientResponseType>(record.type));
+        case EFlightEvent::MARKET_UPDATE_QUEUED:
+        case EFlightEvent::MARKET_UPDATE_SENT:
+        case EFlightEvent::MARKET_UPDATE_READ:
+            return Exchange::MarketUpdateTypeToString(static_cast<Exchange::EMarketUpdateType>(record.type));
+        default:
+            return "-";
+    }
+}
+
+/// Order events carry a TraceId, market data events the market order id or the sequence number.
+static auto FormatId(const Common::SFlightRecord &record) -> std::string
+{
+    using Common::EFlightEvent;
+    switch (record.event)
+    {
+        case EFlightEvent::MARKET_UPDATE_QUEUED:
+        case EFlightEvent::MARKET_UPDATE_READ:
+            return "market_order:" + Common::OrderIdToString(record.id);
+        case EFlightEvent::MARKET_UPDATE_SENT:
+            return "md:" + std::to_string(record.id);
+        default:
+            return "order:" + std::to_string(record.id >> Common::TRACE_ORDER_ID_BITS) + ':' +
+                   std::to_string(record.id & ((uint64_t{1} << Common::TRACE_ORDER_ID_BITS) - 1));
+    }
+}
+
+/// ./flight_dump FILE  print the events of a flight recorder dump, every thread merged in the order they happened.
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        FATAL("USAGE flight_dump FILE, FILE is a <process>_<pid>_flight_<reason>_<n>.bin written by CFlightRecorderRegistry.");
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT(data.size() >= sizeof(Common::SFlightDumpHeader), "Cannot read a dump from:" + std::string(argv[1]));
+
+    const auto &header = *reinterpret_cast<const Common::SFlightDumpHeader *>(data.data());
+    ASSERT(header.magic == Common::FLIGHT_RECORDER_MAGIC, std::string(argv[1]) + " is not a flight recorder dump.");
+    ASSERT(header.layoutVersion == Common::FLIGHT_RECORDER_LAYOUT_VERSION,
+           std::string(argv[1]) + " has layout version:" + std::to_string(header.layoutVersion) +
+           " this flight_dump reads:" + std::to_string(Common::FLIGHT_RECORDER_LAYOUT_VERSION));
+
+    const auto threadSize = sizeof(Common::SFlightDumpThread) + header.recordsPerThread * sizeof(Common::SFlightRecord);
+    ASSERT(data.size() >= sizeof(header) + header.numThreads * threadSize, std::string(argv[1]) + " is truncated.");
+
+    printf("pid:%d reason:%s threads:%u dumped at:%ld\n\n", header.pid, header.reason, header.numThreads, header.nanos);
+
+    // A ring that wrapped starts at its oldest record, next modulo its size.
+    std::vector<SThreadRecord> records;
+    for (size_t i = 0; i < header.numThreads; ++i)
+    {
+        const auto pBase = data.data() + sizeof(header) + i * threadSize;
+        const auto pThread = reinterpret_cast<const Common::SFlightDumpThread *>(pBase);
+        const auto pRecords = reinterpret_cast<const Common::SFlightRecord *>(pBase + sizeof(Common::SFlightDumpThread));
+
+        const auto count = std::min<uint64_t>(pThread->next, header.recordsPerThread);
+        for (uint64_t j = pThread->next - count; j < pThread->next; ++j)
+        {
+            records.push_back({pThread, pRecords[j % header.recordsPerThread]});
+        }
+    }
+
+    // Rings of threads that ran on other cores interleave by TSC, which is synchronised across cores.
+    std::stable_sort(records.begin(), records.end(), [](const auto &lhs, const auto &rhs) { return lhs.record.tsc < rhs.record.tsc; });
+
+    printf("%-20s %-16s %8s %-20s %-26s %6s %-7s %12s %10s %s\n", "NANOS", "THREAD", "TID", "EVENT", "ID", "TICKER", "SIDE", "PRICE", "QTY", "TYPE");
+    for (const auto &[pThread, record] : records)
+    {
+        const auto nanos = header.nanos + static_cast<Common::Nanos>(static_cast<double>(static_cast<int64_t>(record.tsc - header.tsc)) * header.nanosPerTick);
+        printf("%-20ld %-16s %8d %-20s %-26s %6s %-7s %12s %10s %s\n", nanos, pThread->threadName, pThread->tid,
+               std::string(Common::FormatFlightEvent(record.event)).c_str(), FormatId(record).c_str(),
+               Common::TickerIdToString(record.tickerId).c_str(), Common::SideToString(static_cast<Common::ESide>(record.side)).c_str(),
+               Common::PriceToString(record.price).c_str(), Common::QtyToString(record.qty).c_str(), FormatType(record).c_str());
+    }
+
+    exit(EXIT_SUCCESS);
+}
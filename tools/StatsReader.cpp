@@ -0,0 +1,212 @@
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/LatencyService.h"
+#include "common/Metrics.h"
+#include "common/TimeUtils.h"
+
+/// A process publishing metrics, from the name of its segment.
+struct SPublisher
+{
+    std::string shmName;
+    std::string process;
+    pid_t       pid = 0;
+};
+
+/// Every /dev/shm/ull_metrics.<process name>.<pid> segment, including those left behind by a process that crashed.
+static auto FindPublishers() -> std::vector<SPublisher>
+{
+    std::vector<SPublisher> publishers;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator("/dev/shm", error))
+    {
+        const auto fileName = entry.path().filename().string();
+        const auto dot = fileName.rfind('.');
+        if (!fileName.starts_with(Common::METRICS_SHM_PREFIX) || dot == std::string::npos || dot < Common::METRICS_SHM_PREFIX.size())
+        {
+            continue;
+        }
+
+        publishers.push_back({"/" + fileName, fileName.substr(Common::METRICS_SHM_PREFIX.size(), dot - Common::METRICS_SHM_PREFIX.size()),
+                              static_cast<pid_t>(atoi(fileName.c_str() + dot + 1))});
+    }
+
+    return publishers;
+}
+
+static auto IsAlive(pid_t pid)
+{
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+/// Map the segment read-only, the publisher never knows it is being watched.
+static auto Attach(const SPublisher &publisher) -> const Common::SMetricsSegment *
+{
+    const auto fd = shm_open(publisher.shmName.c_str(), O_RDONLY, 0);
+    ASSERT(fd >= 0, "shm_open() failed for:" + publisher.shmName + " error:" + std::string(std::strerror(errno)));
+
+    struct stat st = {};
+    ASSERT(fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Common::SMetricsSegment),
+           "Segment:" + publisher.shmName + " is smaller than this stats_reader's layout.");
+
+    auto p = mmap(nullptr, sizeof(Common::SMetricsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT(p != MAP_FAILED, "mmap() failed for:" + publisher.shmName + " error:" + std::string(std::strerror(errno)));
+
+    const auto pSegment = reinterpret_cast<const Common::SMetricsSegment *>(p);
+    ASSERT(pSegment->header.magic.load(std::memory_order_acquire) == Common::METRICS_MAGIC,
+           "Segment:" + publisher.shmName + " was not created by CMetricsRegistry or is still being created.");
+    ASSERT(pSegment->header.layoutVersion == Common::METRICS_LAYOUT_VERSION,
+           "Segment:" + publisher.shmName + " has layout version:" + std::to_string(pSegment->header.layoutVersion) +
+           " this stats_reader reads:" + std::to_string(Common::METRICS_LAYOUT_VERSION));
+
+    return pSegment;
+}
+
+/// Print every metric once. Counter rates are taken against the values of the previous print, elapsedNanos after it.
+static auto Print(const Common::SMetricsSegment &segment, std::map<std::string, int64_t> &lastCounts, Common::Nanos elapsedNanos)
+{
+    const auto &header = segment.header;
+    const auto numValues = std::min<size_t>(header.numValues.load(std::memory_order_acquire), Common::METRICS_MAX_VALUES);
+    const auto numHistograms = std::min<size_t>(header.numHistograms.load(std::memory_order_acquire), Common::METRICS_MAX_HISTOGRAMS);
+    const auto sampleAge = Common::GetCurrentNanos() - header.sampleNanos.load(std::memory_order_acquire);
+
+    printf("%s pid:%d sampled %.2fs ago\n\n", header.process, header.pid, static_cast<double>(sampleAge) / Common::NANOS_TO_SECS);
+
+    printf("%-48s %16s %12s\n", "COUNTER", "VALUE", "RATE/S");
+    std::map<std::string, int64_t> counts;
+    for (size_t i = 0; i < numValues; ++i)
+    {
+        const auto &slot = segment.values[i];
+        if (slot.type != Common::EMetricType::COUNTER)
+        {
+            continue;
+        }
+
+        const auto value = slot.value.load(std::memory_order_relaxed);
+        const auto last = lastCounts.find(slot.name);
+        if (last != lastCounts.end() && elapsedNanos > 0)
+        {
+            printf("%-48s %16ld %12.1f\n", slot.name, value, static_cast<double>(value - last->second) * Common::NANOS_TO_SECS / static_cast<double>(elapsedNanos));
+        }
+        else
+        {
+            printf("%-48s %16ld %12s\n", slot.name, value, "-");
+        }
+        counts[slot.name] = value;
+    }
+    lastCounts = std::move(counts);
+
+    printf("\n%-48s %16s\n", "GAUGE", "VALUE");
+    for (size_t i = 0; i < numValues; ++i)
+    {
+        const auto &slot = segment.values[i];
+        if (slot.type == Common::EMetricType::GAUGE)
+        {
+            printf("%-48s %16ld\n", slot.name, slot.value.load(std::memory_order_relaxed));
+        }
+    }
+
+    // Every thread that measures a tag has its own histogram, merge them like CLatencyService does.
+    std::map<std::string, std::unique_ptr<Common::SLatencySnapshot>> snapshots[2];
+    for (size_t i = 0; i < numHistograms; ++i)
+    {
+        const auto &slot = segment.histograms[i];
+        auto &snapshot = snapshots[slot.unit == Common::EHistogramUnit::TICKS ? 0 : 1][slot.name];
+        if (!snapshot)
+        {
+            snapshot = std::make_unique<Common::SLatencySnapshot>();
+        }
+        snapshot->Merge(slot.histogram);
+    }
+
+    // Latencies are in TSC ticks, hardware counter deltas are printed as they are.
+    const auto nanosPerTick = header.nanosPerTick.load(std::memory_order_relaxed);
+    const auto printSnapshots = [](const char *title, const auto &unitSnapshots, double scale)
+    {
+        const auto scaled = [scale](double value) { return static_cast<uint64_t>(value * scale); };
+
+        printf("\n%-48s %12s %10s", title, "COUNT", "MEAN");
+        for (const auto &[fraction, name] : Common::LATENCY_REPORT_PERCENTILES)
+        {
+            printf(" %10s", name);
+        }
+        printf(" %10s\n", "MAX");
+        for (const auto &[tag, snapshot] : unitSnapshots)
+        {
+            printf("%-48s %12lu %10lu", tag.c_str(), snapshot->count, scaled(snapshot->Mean()));
+            for (const auto &[fraction, name] : Common::LATENCY_REPORT_PERCENTILES)
+            {
+                printf(" %10lu", scaled(static_cast<double>(snapshot->Percentile(fraction))));
+            }
+            printf(" %10lu\n", scaled(static_cast<double>(snapshot->max)));
+        }
+    };
+    printSnapshots("LATENCY (NANOS)", snapshots[0], nanosPerTick);
+    if (!snapshots[1].empty())
+    {
+        printSnapshots("PERF (EVENTS PER MEASUREMENT)", snapshots[1], 1.0);
+    }
+    fflush(stdout);
+}
+
+/// ./stats_reader                                  list the processes publishing metrics.
+/// ./stats_reader PID|PROCESS_NAME [REFRESH_SECS]  print a process's metrics once, or every REFRESH_SECS with counter rates until it exits.
+int main(int argc, char **argv)
+{
+    const auto publishers = FindPublishers();
+    if (argc < 2)
+    {
+        printf("%-8s %-32s %s\n", "PID", "PROCESS", "STATE");
+        for (const auto &publisher : publishers)
+        {
+            printf("%-8d %-32s %s\n", publisher.pid, publisher.process.c_str(), IsAlive(publisher.pid) ? "running" : "exited, stale segment");
+        }
+        exit(EXIT_SUCCESS);
+    }
+
+    const std::string target = argv[1];
+    const auto refreshSecs = (argc > 2 ? atof(argv[2]) : 0.0);
+
+    std::vector<SPublisher> matches;
+    for (const auto &publisher : publishers)
+    {
+        if (std::to_string(publisher.pid) == target || (publisher.process == target && IsAlive(publisher.pid)))
+        {
+            matches.push_back(publisher);
+        }
+    }
+    if (matches.size() != 1)
+    {
+        FATAL("USAGE stats_reader [PID|PROCESS_NAME [REFRESH_SECS]], " + std::to_string(matches.size()) + " running processes match:" + target +
+              ", run stats_reader without arguments to list them.");
+    }
+
+    const auto pSegment = Attach(matches[0]);
+
+    std::map<std::string, int64_t> lastCounts;
+    auto lastNanos = Common::GetCurrentNanos();
+    Print(*pSegment, lastCounts, 0);
+
+    while (refreshSecs > 0 && IsAlive(matches[0].pid))
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(refreshSecs));
+
+        const auto nowNanos = Common::GetCurrentNanos();
+        printf("\033[H\033[2J");
+        Print(*pSegment, lastCounts, nowNanos - lastNanos);
+        lastNanos = nowNanos;
+    }
+
+    exit(EXIT_SUCCESS);
+}
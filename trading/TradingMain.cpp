@@ -13,6 +13,8 @@ Trading::CMarketDataConsumer* pMarketDataConsumer = nullptr;
 Trading::COrderGateway*       pOrderGateway = nullptr;
 
 /// ./trading_main CLIENT_ID ALGO_TYPE [CLIP_1 THRESH_1 MAX_ORDER_SIZE_1 MAX_POS_1 MAX_LOSS_1] [CLIP_2 THRESH_2 MAX_ORDER_SIZE_2 MAX_POS_2 MAX_LOSS_2] ...
+/// Idle behaviour of each thread is read from TRADE_ENGINE_WAIT_STRATEGY, ORDER_GW_WAIT_STRATEGY and MD_CONSUMER_WAIT_STRATEGY, BUSY_SPIN when not set.
+/// Only the trade engine, unparked by its input queues, can PARK. The order gateway and market data consumer poll sockets.
 int main(int argc, char **argv)
 {
     if (argc < 3)
@@ -27,14 +29,15 @@ int main(int argc, char **argv)
 
     pLogger = new Common::CLogger("trading_main_" + std::to_string(clientId) + ".log");
 
+    // Signal handlers, the contract failure hook and the dump thread in place before any component starts, not on the first recorded event.
+    Common::CFlightRecorderRegistry::Instance();
+
     const int sleepTime = 20 * 1000;
 
     // The lock free queues to facilitate communication between order gateway <-> trade engine and market data consumer -> trade engine.
-    Exchange::ClientRequestLFQueue  clientRequests(ME_MAX_CLIENT_UPDATES);
-    Exchange::ClientResponseLFQueue clientResponses(ME_MAX_CLIENT_UPDATES);
-    Exchange::MEMarketUpdateLFQueue marketUpdates(ME_MAX_MARKET_UPDATES);
-
-    std::string timeStr;
+    Exchange::ClientRequestLFQueue  clientRequests(ME_MAX_CLIENT_UPDATES, "trading:client_requests");
+    Exchange::ClientResponseLFQueue clientResponses(ME_MAX_CLIENT_UPDATES, "trading:client_responses");
+    Exchange::MEMarketUpdateLFQueue marketUpdates(ME_MAX_MARKET_UPDATES, "trading:market_updates");
 
     TradeEngineCfgHashMap tickerCfg;
 
@@ -46,20 +49,28 @@ int main(int argc, char **argv)
         tickerCfg.at(nextTickerId) = {static_cast<Qty>(std::atoi(argv[i])), std::atof(argv[i + 1]), {static_cast<Qty>(std::atoi(argv[i + 2])), static_cast<Qty>(std::atoi(argv[i + 3])), std::atof(argv[i + 4])}};
     }
 
-    pLogger->Log("%:% %() % Starting Trade Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&timeStr));
+    const auto tradeEngineWait = Common::WaitStrategyFromEnv("TRADE_ENGINE_WAIT_STRATEGY", Common::EWaitStrategy::BUSY_SPIN);
+    const auto orderGwWait = Common::WaitStrategyFromEnv("ORDER_GW_WAIT_STRATEGY", Common::EWaitStrategy::BUSY_SPIN);
+    const auto mktDataWait = Common::WaitStrategyFromEnv("MD_CONSUMER_WAIT_STRATEGY", Common::EWaitStrategy::BUSY_SPIN);
+    LOG_INFO(*pLogger, "%:% %() Wait strategies trade engine:% order gateway:% market data consumer:%\n", __FILE__, __LINE__, __FUNCTION__,
+             Common::WaitStrategyToString(tradeEngineWait), Common::WaitStrategyToString(orderGwWait), Common::WaitStrategyToString(mktDataWait));
+
+    LOG_INFO(*pLogger, "%:% %() Starting Trade Engine...\n", __FILE__, __LINE__, __FUNCTION__);
     pTradeEngine = new Trading::CTradeEngine(clientId, algoType,
                                             tickerCfg,
                                             &clientRequests,
                                             &clientResponses,
                                             &marketUpdates);
+    pTradeEngine->SetWaitStrategy(tradeEngineWait);
     pTradeEngine->Start();
 
     const std::string orderGwIp = "127.0.0.1";
     const std::string orderGwIface = "lo";
     const int orderGwPort = 12345;
 
-    pLogger->Log("%:% %() % Starting Order Gateway...\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&timeStr));
+    LOG_INFO(*pLogger, "%:% %() Starting Order Gateway...\n", __FILE__, __LINE__, __FUNCTION__);
     pOrderGateway = new Trading::COrderGateway(clientId, &clientRequests, &clientResponses, orderGwIp, orderGwIface, orderGwPort);
+    pOrderGateway->SetWaitStrategy(orderGwWait);
     pOrderGateway->Start();
 
     const std::string mktDataIface = "lo";
@@ -68,14 +79,30 @@ int main(int argc, char **argv)
     const std::string incrementalIp = "233.252.14.3";
     const int incrementalPort = 20001;
 
-    pLogger->Log("%:% %() % Starting Market Data Consumer...\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&timeStr));
+    LOG_INFO(*pLogger, "%:% %() Starting Market Data Consumer...\n", __FILE__, __LINE__, __FUNCTION__);
     pMarketDataConsumer = new Trading::CMarketDataConsumer(clientId, &marketUpdates, mktDataIface, snapshotIp, snapshotPort, incrementalIp, incrementalPort);
+    pMarketDataConsumer->SetWaitStrategy(mktDataWait);
     pMarketDataConsumer->Start();
 
+    LOG_INFO(*pLogger, "%:% %() Memory report:\n%", __FILE__, __LINE__, __FUNCTION__, Common::CHugePageRegistry::Instance().ToString());
+
     usleep(10 * 1000 * 1000);
 
     pTradeEngine->initLastEventTime();
 
+    // Queue occupancy is logged every queueStatsInterval for as long as trading runs, whichever loop below is driving it.
+    const Common::Nanos queueStatsInterval = 30 * Common::NANOS_TO_SECS;
+    Common::Nanos lastQueueStatsNanos = 0;
+    const auto logQueueStatsIfDue = [&]()
+    {
+        const auto nowNanos = Common::GetCurrentNanos();
+        if (nowNanos - lastQueueStatsNanos >= queueStatsInterval)
+        {
+            lastQueueStatsNanos = nowNanos;
+            LOG_INFO(*pLogger, "%:% %() Queue stats:\n%", __FILE__, __LINE__, __FUNCTION__, OptCommon::CQueueStatsRegistry::Instance().ToString());
+        }
+    };
+
     // For the random trading algorithm, we simply implement it here instead of creating a new trading algorithm which is another possibility.
     // Generate random orders with random attributes and randomly cancel some of them.
     if (algoType == EAlgoType::RANDOM)
@@ -97,20 +124,23 @@ int main(int argc, char **argv)
             const ESide side = (rand() % 2 ? Common::ESide::BUY : Common::ESide::SELL);
 
             Exchange::SMEClientRequest newRequest{Exchange::EClientRequestType::NEW, clientId, tickerId, orderId++, side, price, qty};
-            pTradeEngine->sendClientRequest(&newRequest);
+            // Sent from this thread rather than in reaction to a message, each request starts a trace of its own.
+            pTradeEngine->sendClientRequest(&newRequest, Common::STraceContext{});
             usleep(sleepTime);
 
             clientRequestsVec.push_back(newRequest);
             const auto cxlIndex = rand() % clientRequestsVec.size();
             auto cxlRequest = clientRequestsVec[cxlIndex];
             cxlRequest.type = Exchange::EClientRequestType::CANCEL;
-            pTradeEngine->sendClientRequest(&cxlRequest);
+            pTradeEngine->sendClientRequest(&cxlRequest, Common::STraceContext{});
             usleep(sleepTime);
 
+            logQueueStatsIfDue();
+
             if (pTradeEngine->silentSeconds() >= 60)
             {
-                pLogger->Log("%:% %() % Stopping early because been silent for % seconds...\n", __FILE__, __LINE__, __FUNCTION__,
-                            Common::GetCurrentTimeStr(&timeStr), pTradeEngine->silentSeconds());
+                LOG_INFO(*pLogger, "%:% %() Stopping early because been silent for % seconds...\n", __FILE__, __LINE__, __FUNCTION__,
+                            pTradeEngine->silentSeconds());
 
                 break;
             }
@@ -119,8 +149,9 @@ int main(int argc, char **argv)
 
     while (pTradeEngine->silentSeconds() < 60)
     {
-        pLogger->Log("%:% %() % Waiting till no activity, been silent for % seconds...\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::GetCurrentTimeStr(&timeStr), pTradeEngine->silentSeconds());
+        LOG_INFO(*pLogger, "%:% %() Waiting till no activity, been silent for % seconds...\n", __FILE__, __LINE__, __FUNCTION__,
+                    pTradeEngine->silentSeconds());
+        logQueueStatsIfDue();
 
         using namespace std::literals::chrono_literals;
         std::this_thread::sleep_for(30s);
@@ -9,7 +9,9 @@ namespace Trading
         : m_pIncomingMdUpdates(market_updates), m_isRunning(false),
           m_logger("trading_market_data_consumer_" + std::to_string(client_id) + ".log"),
           m_incrementalMcastSocket(m_logger), m_snapshotMcastSocket(m_logger),
-          m_iface(iface), m_snapshotIp(snapshot_ip), m_snapshotPort(snapshot_port)
+          m_iface(iface), m_snapshotIp(snapshot_ip), m_snapshotPort(snapshot_port),
+          m_updatesCounter(CMetricsRegistry::Instance().Counter("trading:market_data_consumer:updates")),
+          m_recoveriesCounter(CMetricsRegistry::Instance().Counter("trading:market_data_consumer:recoveries"))
     {
         auto recv_callback = [this](auto socket)
         {
@@ -29,17 +31,24 @@ namespace Trading
     /// Main loop for this thread - reads and processes messages from the multicast sockets - the heavy lifting is in the RecvCallback() and checkSnapshotSync() methods.
     auto CMarketDataConsumer::Run() noexcept -> void
     {
-        m_logger.Log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+        LOG_INFO(m_logger, "%:% %()\n", __FILE__, __LINE__, __FUNCTION__);
+
+        Common::PreregisterMeasures({"Trading_MarketDataConsumer_recvCallback"});
+
         while (m_isRunning)
         {
-            m_incrementalMcastSocket.SendAndRecv();
-            m_snapshotMcastSocket.SendAndRecv();
+            const bool did_work = m_incrementalMcastSocket.SendAndRecv();
+            const bool did_snapshot_work = m_snapshotMcastSocket.SendAndRecv();
+            ALLOCATION_FREE_AFTER_WARMUP("trading:market_data_consumer", did_work || did_snapshot_work);
+            m_waitStrategy.OnPoll(did_work || did_snapshot_work);
         }
     }
 
     /// Start the process of snapshot synchronization by subscribing to the snapshot multicast stream.
     auto CMarketDataConsumer::startSnapshotSync() -> void
     {
+        m_recoveriesCounter.Increment();
+
         m_snapshotQueuedMsgs.clear();
         m_incrementalQueuedMsgs.clear();
 
@@ -60,8 +69,8 @@ namespace Trading
         const auto &first_snapshot_msg = m_snapshotQueuedMsgs.begin()->second;
         if (first_snapshot_msg.type != Exchange::EMarketUpdateType::SNAPSHOT_START)
         {
-            m_logger.Log("%:% %() % Returning because have not seen a SNAPSHOT_START yet.\n",
-                        __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_DEBUG(m_logger, "%:% %() Returning because have not seen a SNAPSHOT_START yet.\n",
+                        __FILE__, __LINE__, __FUNCTION__);
             m_snapshotQueuedMsgs.clear();
             return;
         }
@@ -72,13 +81,13 @@ namespace Trading
         size_t next_snapshot_seq = 0;
         for (auto &snapshot_itr : m_snapshotQueuedMsgs)
         {
-            m_logger.Log("%:% %() % % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::GetCurrentTimeStr(&m_timeStr), snapshot_itr.first, snapshot_itr.second.ToString());
+            LOG_TRACE(m_logger, "%:% %() % => %\n", __FILE__, __LINE__, __FUNCTION__,
+                        snapshot_itr.first, snapshot_itr.second);
             if (snapshot_itr.first != next_snapshot_seq)
             {
                 have_complete_snapshot = false;
-                m_logger.Log("%:% %() % Detected gap in snapshot stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                            Common::GetCurrentTimeStr(&m_timeStr), next_snapshot_seq, snapshot_itr.first, snapshot_itr.second.ToString());
+                LOG_WARN(m_logger, "%:% %() Detected gap in snapshot stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
+                            next_snapshot_seq, snapshot_itr.first, snapshot_itr.second);
                 break;
             }
 
@@ -91,8 +100,8 @@ namespace Trading
 
         if (!have_complete_snapshot)
         {
-            m_logger.Log("%:% %() % Returning because found gaps in snapshot stream.\n",
-                        __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_DEBUG(m_logger, "%:% %() Returning because found gaps in snapshot stream.\n",
+                        __FILE__, __LINE__, __FUNCTION__);
             m_snapshotQueuedMsgs.clear();
             return;
         }
@@ -100,8 +109,8 @@ namespace Trading
         const auto &last_snapshot_msg = m_snapshotQueuedMsgs.rbegin()->second;
         if (last_snapshot_msg.type != Exchange::EMarketUpdateType::SNAPSHOT_END)
         {
-            m_logger.Log("%:% %() % Returning because have not seen a SNAPSHOT_END yet.\n",
-                        __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_DEBUG(m_logger, "%:% %() Returning because have not seen a SNAPSHOT_END yet.\n",
+                        __FILE__, __LINE__, __FUNCTION__);
             return;
         }
 
@@ -110,22 +119,22 @@ namespace Trading
         m_nextExpIncSeqNum = last_snapshot_msg.orderId + 1;
         for (auto inc_itr = m_incrementalQueuedMsgs.begin(); inc_itr != m_incrementalQueuedMsgs.end(); ++inc_itr)
         {
-            m_logger.Log("%:% %() % Checking next_exp:% vs. seq:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::GetCurrentTimeStr(&m_timeStr), m_nextExpIncSeqNum, inc_itr->first, inc_itr->second.ToString());
+            LOG_TRACE(m_logger, "%:% %() Checking next_exp:% vs. seq:% %.\n", __FILE__, __LINE__, __FUNCTION__,
+                        m_nextExpIncSeqNum, inc_itr->first, inc_itr->second);
 
             if (inc_itr->first < m_nextExpIncSeqNum)
                 continue;
 
             if (inc_itr->first != m_nextExpIncSeqNum)
             {
-                m_logger.Log("%:% %() % Detected gap in incremental stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                            Common::GetCurrentTimeStr(&m_timeStr), m_nextExpIncSeqNum, inc_itr->first, inc_itr->second.ToString());
+                LOG_WARN(m_logger, "%:% %() Detected gap in incremental stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
+                            m_nextExpIncSeqNum, inc_itr->first, inc_itr->second);
                 have_complete_incremental = false;
                 break;
             }
 
-            m_logger.Log("%:% %() % % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::GetCurrentTimeStr(&m_timeStr), inc_itr->first, inc_itr->second.ToString());
+            LOG_TRACE(m_logger, "%:% %() % => %\n", __FILE__, __LINE__, __FUNCTION__,
+                        inc_itr->first, inc_itr->second);
 
             if (inc_itr->second.type != Exchange::EMarketUpdateType::SNAPSHOT_START &&
                 inc_itr->second.type != Exchange::EMarketUpdateType::SNAPSHOT_END)
@@ -137,21 +146,36 @@ namespace Trading
 
         if (!have_complete_incremental)
         {
-            m_logger.Log("%:% %() % Returning because have gaps in queued incrementals.\n",
-                        __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_DEBUG(m_logger, "%:% %() Returning because have gaps in queued incrementals.\n",
+                        __FILE__, __LINE__, __FUNCTION__);
             m_snapshotQueuedMsgs.clear();
             return;
         }
 
-        for (const auto &itr : final_events)
+        // Publish the recovered book to the trade engine in as few batches as the queue capacity allows, untraced.
+        for (size_t i = 0; i < final_events.size();)
         {
-            auto next_write = m_pIncomingMdUpdates->GetNextToWriteTo();
-            *next_write = itr;
-            m_pIncomingMdUpdates->UpdateWriteIndex();
+            const auto requested = std::min(final_events.size() - i, m_pIncomingMdUpdates->capacity());
+            auto next_writes = m_pIncomingMdUpdates->ReserveWrite(requested);
+            for (size_t j = 0; j < next_writes.size(); ++j)
+            {
+                next_writes[j] = {final_events[i + j], {}};
+            }
+            m_pIncomingMdUpdates->CommitWrite(next_writes.size());
+            i += next_writes.size();
+
+            // Only a full queue with EQueueFullPolicy::DROP hands out fewer slots, possibly none. Asking again would spin here and count the same
+            // updates as dropped over and over, so give up on the rest of the book instead.
+            if (UNLIKELY(next_writes.size() < requested))
+            {
+                LOG_ERROR(m_logger, "%:% %() Market update queue full, dropped % of % recovered updates.\n", __FILE__, __LINE__, __FUNCTION__,
+                          final_events.size() - i, final_events.size());
+                break;
+            }
         }
 
-        m_logger.Log("%:% %() % Recovered % snapshot and % incremental orders.\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::GetCurrentTimeStr(&m_timeStr), m_snapshotQueuedMsgs.size() - 2, num_incrementals);
+        LOG_INFO(m_logger, "%:% %() Recovered % snapshot and % incremental orders.\n", __FILE__, __LINE__, __FUNCTION__,
+                    m_snapshotQueuedMsgs.size() - 2, num_incrementals);
 
         m_snapshotQueuedMsgs.clear();
         m_incrementalQueuedMsgs.clear();
@@ -168,8 +192,8 @@ namespace Trading
         {
             if (m_snapshotQueuedMsgs.find(request->seqNum) != m_snapshotQueuedMsgs.end())
             {
-                m_logger.Log("%:% %() % Packet drops on snapshot socket. Received for a 2nd time:%\n", __FILE__, __LINE__, __FUNCTION__,
-                            Common::GetCurrentTimeStr(&m_timeStr), request->ToString());
+                LOG_WARN(m_logger, "%:% %() Packet drops on snapshot socket. Received for a 2nd time:%\n", __FILE__, __LINE__, __FUNCTION__,
+                            *request);
                 m_snapshotQueuedMsgs.clear();
             }
             m_snapshotQueuedMsgs[request->seqNum] = request->me_market_update_;
@@ -179,8 +203,8 @@ namespace Trading
             m_incrementalQueuedMsgs[request->seqNum] = request->me_market_update_;
         }
 
-        m_logger.Log("%:% %() % size snapshot:% incremental:% % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::GetCurrentTimeStr(&m_timeStr), m_snapshotQueuedMsgs.size(), m_incrementalQueuedMsgs.size(), request->seqNum, request->ToString());
+        LOG_TRACE(m_logger, "%:% %() size snapshot:% incremental:% % => %\n", __FILE__, __LINE__, __FUNCTION__,
+                    m_snapshotQueuedMsgs.size(), m_incrementalQueuedMsgs.size(), request->seqNum, *request);
 
         checkSnapshotSync();
     }
@@ -188,7 +212,7 @@ namespace Trading
     /// Process a market data update, the consumer needs to use the socket parameter to figure out whether this came from the snapshot or the incremental stream.
     auto CMarketDataConsumer::RecvCallback(SMultiCastSocket *socket) noexcept -> void
     {
-        TTT_MEASURE(T7_MarketDataConsumer_UDP_read, m_logger);
+        const auto t7Tsc = Common::rdtsc();
 
         START_MEASURE(Trading_MarketDataConsumer_recvCallback);
         const auto is_snapshot = (socket->m_fd == m_snapshotMcastSocket.m_fd);
@@ -196,8 +220,8 @@ namespace Trading
         { // market update was read from the snapshot market data stream and we are not in recovery, so we dont need it and discard it.
             socket->m_nextRecvValidIndex = 0;
 
-            m_logger.Log("%:% %() % WARN Not expecting snapshot messages.\n",
-                        __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+            LOG_WARN(m_logger, "%:% %() Not expecting snapshot messages.\n",
+                        __FILE__, __LINE__, __FUNCTION__);
 
             return;
         }
@@ -208,9 +232,8 @@ namespace Trading
             for (; i + sizeof(Exchange::MDPMarketUpdate) <= socket->m_nextRecvValidIndex; i += sizeof(Exchange::MDPMarketUpdate))
             {
                 auto request = reinterpret_cast<const Exchange::MDPMarketUpdate *>(socket->m_pRecvBuffer + i);
-                m_logger.Log("%:% %() % Received % socket len:% %\n", __FILE__, __LINE__, __FUNCTION__,
-                            Common::GetCurrentTimeStr(&m_timeStr),
-                            (is_snapshot ? "snapshot" : "incremental"), sizeof(Exchange::MDPMarketUpdate), request->ToString());
+                LOG_TRACE(m_logger, "%:% %() Received % socket len:% %\n", __FILE__, __LINE__, __FUNCTION__,
+                            (is_snapshot ? "snapshot" : "incremental"), sizeof(Exchange::MDPMarketUpdate), *request);
 
                 const bool already_in_recovery = m_isInRecovery;
                 m_isInRecovery = (already_in_recovery || request->seqNum != m_nextExpIncSeqNum);
@@ -219,8 +242,8 @@ namespace Trading
                 {
                     if (UNLIKELY(!already_in_recovery))
                     { // if we just entered recovery, start the snapshot synchonization process by subscribing to the snapshot multicast stream.
-                        m_logger.Log("%:% %() % Packet drops on % socket. SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
-                                    Common::GetCurrentTimeStr(&m_timeStr), (is_snapshot ? "snapshot" : "incremental"), m_nextExpIncSeqNum, request->seqNum);
+                        LOG_WARN(m_logger, "%:% %() Packet drops on % socket. SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
+                                    (is_snapshot ? "snapshot" : "incremental"), m_nextExpIncSeqNum, request->seqNum);
                         startSnapshotSync();
                     }
 
@@ -228,20 +251,22 @@ namespace Trading
                 }
                 else if (!is_snapshot)
                 { // not in recovery and received a packet in the correct order and without gaps, process it.
-                    m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__,
-                                Common::GetCurrentTimeStr(&m_timeStr), request->ToString());
+                    LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__,
+                                *request);
 
                     ++m_nextExpIncSeqNum;
 
                     auto next_write = m_pIncomingMdUpdates->GetNextToWriteTo();
-                    *next_write = std::move(request->me_market_update_);
+                    *next_write = {request->me_market_update_, {}};
+                    next_write->trace.Start(MakeMarketDataTraceId(request->seqNum), ETraceHop::T7_MarketDataConsumer_UDP_read, t7Tsc);
+                    TRACE_HOP(next_write->trace, T8_MarketDataConsumer_LFQueue_write);
                     m_pIncomingMdUpdates->UpdateWriteIndex();
-                    TTT_MEASURE(T8_MarketDataConsumer_LFQueue_write, m_logger);
+                    m_updatesCounter.Increment();
                 }
             }
             memcpy(socket->m_pRecvBuffer, socket->m_pRecvBuffer + i, socket->m_nextRecvValidIndex - i);
             socket->m_nextRecvValidIndex -= i;
         }
-        END_MEASURE(Trading_MarketDataConsumer_recvCallback, m_logger);
+        END_MEASURE(Trading_MarketDataConsumer_recvCallback);
     }
 }
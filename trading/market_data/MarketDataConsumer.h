@@ -3,9 +3,11 @@
 #include <functional>
 #include <map>
 
+#include "common/AllocationTracker.h"
 #include "common/ThreadUtils.h"
-#include "common/LockFreeQueue.h"
+#include "common/OptLockFreeQueue.h"
 #include "common/Macros.h"
+#include "common/Metrics.h"
 #include "common/MultiCastSocket.h"
 
 #include "exchange/market_data/MarketUpdate.h"
@@ -41,6 +43,14 @@ namespace Trading
             m_isRunning = false;
         }
 
+        /// Idle behaviour of the run loop, only call before Start().
+        /// Never EWaitStrategy::PARK, the loop polls its multicast sockets and nothing would unpark it when data arrives.
+        auto SetWaitStrategy(Common::EWaitStrategy strategy) noexcept
+        {
+            ASSERT(strategy != Common::EWaitStrategy::PARK, "CMarketDataConsumer polls its multicast sockets, nothing unparks it.");
+            m_waitStrategy.SetStrategy(strategy);
+        }
+
         /// Deleted default, copy & move constructors and assignment-operators.
         CMarketDataConsumer() = delete;
         CMarketDataConsumer(const CMarketDataConsumer &) = delete;
@@ -57,8 +67,10 @@ namespace Trading
 
         volatile bool m_isRunning = false;
 
-        CLogger     m_logger;
-        std::string m_timeStr;        
+        /// What the run loop does after a pass that found nothing to process.
+        Common::CWaitStrategy m_waitStrategy;
+
+        CLogger m_logger;
 
         /// Multicast subscriber sockets for the incremental and market data streams.
         Common::SMultiCastSocket m_incrementalMcastSocket;
@@ -77,6 +89,10 @@ namespace Trading
         QueuedMarketUpdates m_snapshotQueuedMsgs;
         QueuedMarketUpdates m_incrementalQueuedMsgs;
 
+        /// Live counts of updates forwarded to the trade engine and of recoveries started on a sequence gap, through CMetricsRegistry.
+        Common::CMetricCounter m_updatesCounter;
+        Common::CMetricCounter m_recoveriesCounter;
+
     private:
         /// Main loop for this thread - reads and processes messages from the multicast sockets - the heavy lifting is in the RecvCallback() and checkSnapshotSync() methods.
         auto Run() noexcept -> void;
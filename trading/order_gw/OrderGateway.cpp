@@ -14,6 +14,8 @@ namespace Trading
         , m_pIncomingResponses(pClientResponses)
         , m_logger("trading_order_gateway_" + std::to_string(clientId) + ".log")
         , m_tcpSocket(m_logger)
+        , m_requestsCounter(CMetricsRegistry::Instance().Counter("trading:order_gateway:requests"))
+        , m_responsesCounter(CMetricsRegistry::Instance().Counter("trading:order_gateway:responses"))
     {
         m_tcpSocket.m_recvCallback = [this](auto socket, auto rx_time)
         { 
@@ -24,35 +26,47 @@ namespace Trading
     /// Main thread loop - sends out client requests to the exchange and reads and dispatches incoming client responses.
     auto COrderGateway::Run() noexcept -> void
     {
-        m_logger.Log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+        LOG_INFO(m_logger, "%:% %()\n", __FILE__, __LINE__, __FUNCTION__);
+
+        Common::PreregisterMeasures({"Trading_TCPSocket_send", "Trading_OrderGateway_recvCallback"});
+        Common::PreregisterTraceHops(Common::ETraceHop::T8_MarketDataConsumer_LFQueue_write, Common::ETraceHop::T12_OrderGateway_TCP_write);
+
         while (m_isRunning)
         {
-            m_tcpSocket.SendAndRecv();
+            bool did_work = m_tcpSocket.SendAndRecv();
 
             for (auto clientRequest = m_pOutgoingRequests->GetNextToRead(); clientRequest; clientRequest = m_pOutgoingRequests->GetNextToRead())
             {
-                TTT_MEASURE(T11_OrderGateway_LFQueue_read, m_logger);
+                auto trace = clientRequest->trace;
+                TRACE_HOP(trace, T11_OrderGateway_LFQueue_read);
 
-                m_logger.Log("%:% %() % Sending cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), clientId, m_nextOutgoingSeqNum, clientRequest->ToString());
+                LOG_TRACE(m_logger, "%:% %() Sending cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, clientId, m_nextOutgoingSeqNum, *clientRequest);
                 START_MEASURE(Trading_TCPSocket_send);
                 m_tcpSocket.Send(&m_nextOutgoingSeqNum, sizeof(m_nextOutgoingSeqNum));
-                m_tcpSocket.Send(clientRequest, sizeof(Exchange::SMEClientRequest));
-                END_MEASURE(Trading_TCPSocket_send, m_logger);
+                m_tcpSocket.Send(static_cast<const Exchange::SMEClientRequest *>(clientRequest), sizeof(Exchange::SMEClientRequest));
+                END_MEASURE(Trading_TCPSocket_send);
                 m_pOutgoingRequests->UpdateReadIndex();
-                TTT_MEASURE(T12_OrderGateway_TCP_write, m_logger);
+                TRACE_END(trace, T12_OrderGateway_TCP_write, m_logger);
+                FLIGHT_RECORD(REQUEST_SENT, MakeOrderTraceId(clientRequest->clientId, clientRequest->orderId), clientRequest->tickerId, clientRequest->side,
+                              clientRequest->price, clientRequest->qty, clientRequest->type);
+                m_requestsCounter.Increment();
 
                 m_nextOutgoingSeqNum++;
+                did_work = true;
             }
+
+            ALLOCATION_FREE_AFTER_WARMUP("trading:order_gateway", did_work);
+            m_waitStrategy.OnPoll(did_work);
         }
     }
 
     /// Callback when an incoming client response is read, we perform some checks and forward it to the lock free queue connected to the trade engine.
     auto COrderGateway::RecvCallback(CTCPSocket *socket, Nanos rx_time) noexcept -> void
     {
-        TTT_MEASURE(T7t_OrderGateway_TCP_read, m_logger);
+        const auto t7tTsc = Common::rdtsc();
 
         START_MEASURE(Trading_OrderGateway_recvCallback);
-        m_logger.Log("%:% %() % Received socket:% len:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), socket->m_fd, socket->m_nextRecvValidIndex, rx_time);
+        LOG_TRACE(m_logger, "%:% %() Received socket:% len:% %\n", __FILE__, __LINE__, __FUNCTION__, socket->m_fd, socket->m_nextRecvValidIndex, rx_time);
 
         if (socket->m_nextRecvValidIndex >= sizeof(Exchange::SOMClientResponse))
         {
@@ -60,31 +74,33 @@ namespace Trading
             for (; i + sizeof(Exchange::SOMClientResponse) <= socket->m_nextRecvValidIndex; i += sizeof(Exchange::SOMClientResponse))
             {
                 auto response = reinterpret_cast<const Exchange::SOMClientResponse *>(socket->m_pRecvBuffer + i);
-                m_logger.Log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr), response->ToString());
+                LOG_TRACE(m_logger, "%:% %() Received %\n", __FILE__, __LINE__, __FUNCTION__, *response);
 
                 if (response->meClientResponse.clientId != clientId)
                 { // this should never happen unless there is a bug at the exchange.
-                    m_logger.Log("%:% %() % ERROR Incorrect client id. ClientId expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
-                                Common::GetCurrentTimeStr(&m_timeStr), clientId, response->meClientResponse.clientId);
+                    LOG_ERROR(m_logger, "%:% %() Incorrect client id. ClientId expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                                clientId, response->meClientResponse.clientId);
                     continue;
                 }
                 if (response->seqNum != m_nextExpSeqNum)
                 { // this should never happen since we use a reliable TCP protocol, unless there is a bug at the exchange.
-                    m_logger.Log("%:% %() % ERROR Incorrect sequence number. ClientId:%. SeqNum expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
-                                Common::GetCurrentTimeStr(&m_timeStr), clientId, m_nextExpSeqNum, response->seqNum);
+                    LOG_ERROR(m_logger, "%:% %() Incorrect sequence number. ClientId:%. SeqNum expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                                clientId, m_nextExpSeqNum, response->seqNum);
                     continue;
                 }
 
                 ++m_nextExpSeqNum;
 
                 auto next_write = m_pIncomingResponses->GetNextToWriteTo();
-                *next_write = std::move(response->meClientResponse);
+                *next_write = {response->meClientResponse, {}};
+                next_write->trace.Start(MakeOrderTraceId(clientId, response->meClientResponse.clientOrderId), ETraceHop::T7t_OrderGateway_TCP_read, t7tTsc);
+                TRACE_HOP(next_write->trace, T8t_OrderGateway_LFQueue_write);
                 m_pIncomingResponses->UpdateWriteIndex();
-                TTT_MEASURE(T8t_OrderGateway_LFQueue_write, m_logger);
+                m_responsesCounter.Increment();
             }
             memcpy(socket->m_pRecvBuffer, socket->m_pRecvBuffer + i, socket->m_nextRecvValidIndex - i);
             socket->m_nextRecvValidIndex -= i;
         }
-        END_MEASURE(Trading_OrderGateway_recvCallback, m_logger);
+        END_MEASURE(Trading_OrderGateway_recvCallback);
     }
 }
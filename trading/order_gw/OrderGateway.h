@@ -2,8 +2,10 @@
 
 #include <functional>
 
+#include "common/AllocationTracker.h"
 #include "common/ThreadUtils.h"
 #include "common/Macros.h"
+#include "common/Metrics.h"
 #include "common/TcpServer.h"
 
 #include "exchange/order_server/ClientRequest.h"
@@ -43,6 +45,14 @@ namespace Trading
             m_isRunning = false;
         }
 
+        /// Idle behaviour of the run loop, only call before Start().
+        /// Never EWaitStrategy::PARK, the loop polls its TCP socket and nothing would unpark it when data arrives.
+        auto SetWaitStrategy(Common::EWaitStrategy strategy) noexcept
+        {
+            ASSERT(strategy != Common::EWaitStrategy::PARK, "COrderGateway polls its TCP socket, nothing unparks it.");
+            m_waitStrategy.SetStrategy(strategy);
+        }
+
         /// Deleted default, copy & move constructors and assignment-operators.
         COrderGateway() = delete;
         COrderGateway(const COrderGateway &) = delete;
@@ -66,8 +76,10 @@ namespace Trading
 
         volatile bool m_isRunning = false;
 
-        CLogger     m_logger;
-        std::string m_timeStr;        
+        /// What the run loop does after a pass that found nothing to process.
+        Common::CWaitStrategy m_waitStrategy;
+
+        CLogger m_logger;
 
         /// Sequence numbers to track the sequence number to set on outgoing client requests and expected on incoming client responses.
         size_t m_nextOutgoingSeqNum = 1;
@@ -76,6 +88,10 @@ namespace Trading
         /// TCP connection to the exchange's order server.
         Common::CTCPSocket m_tcpSocket;
 
+        /// Live message counts, published through CMetricsRegistry.
+        Common::CMetricCounter m_requestsCounter;
+        Common::CMetricCounter m_responsesCounter;
+
     private:
         /// Main thread loop - sends out client requests to the exchange and reads and dispatches incoming client responses.
         auto Run() noexcept -> void;
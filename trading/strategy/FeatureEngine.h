@@ -27,8 +27,8 @@ namespace Trading
                 mkt_price_ = (bbo->bidPrice * bbo->askQty + bbo->askPrice * bbo->bidQty) / static_cast<double>(bbo->bidQty + bbo->askQty);
             }
 
-            m_pLogger->Log("%:% %() % ticker:% price:% side:% mkt-price:% agg-trade-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
-                         Common::GetCurrentTimeStr(&m_timeStr), ticker_id, Common::PriceToString(price).c_str(),
+            LOG_TRACE(*m_pLogger, "%:% %() ticker:% price:% side:% mkt-price:% agg-trade-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
+                         ticker_id, Common::PriceToString(price).c_str(),
                          Common::SideToString(side).c_str(), mkt_price_, agg_trade_qty_ratio_);
         }
 
@@ -41,9 +41,8 @@ namespace Trading
                 agg_trade_qty_ratio_ = static_cast<double>(market_update->qty) / (market_update->side == ESide::BUY ? bbo->askQty : bbo->bidQty);
             }
 
-            m_pLogger->Log("%:% %() % % mkt-price:% agg-trade-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
-                         Common::GetCurrentTimeStr(&m_timeStr),
-                         market_update->ToString().c_str(), mkt_price_, agg_trade_qty_ratio_);
+            LOG_TRACE(*m_pLogger, "%:% %() % mkt-price:% agg-trade-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
+                         *market_update, mkt_price_, agg_trade_qty_ratio_);
         }
 
         auto getMktPrice() const noexcept
@@ -64,7 +63,6 @@ namespace Trading
         CFeatureEngine &operator=(const CFeatureEngine &&) = delete;
 
     private:
-        std::string m_timeStr;
         Common::CLogger* m_pLogger = nullptr;
 
         /// The two features we compute in our feature engine.
@@ -20,25 +20,23 @@ namespace Trading
         /// Process order book updates, which for the liquidity taking algorithm is none.
         auto onOrderBookUpdate(TickerId ticker_id, Price price, ESide side, CMarketOrderBook *) noexcept -> void
         {
-            m_pLogger->Log("%:% %() % ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
-                         Common::GetCurrentTimeStr(&m_timeStr), ticker_id, Common::PriceToString(price).c_str(),
+            LOG_TRACE(*m_pLogger, "%:% %() ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
+                         ticker_id, Common::PriceToString(price).c_str(),
                          Common::SideToString(side).c_str());
         }
 
         /// Process trade events, fetch the aggressive trade ratio from the feature engine, check against the trading threshold and send aggressive orders.
         auto onTradeUpdate(const Exchange::SMEMarketUpdate *market_update, CMarketOrderBook *book) noexcept -> void
         {
-            m_pLogger->Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                         market_update->ToString().c_str());
+            LOG_TRACE(*m_pLogger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *market_update);
 
             const auto bbo = book->GetBBO();
             const auto agg_qty_ratio = m_pFeatureEngine->getAggTradeQtyRatio();
 
             if (LIKELY(bbo->bidPrice != Price_INVALID && bbo->askPrice != Price_INVALID && agg_qty_ratio != Feature_INVALID))
             {
-                m_pLogger->Log("%:% %() % % agg-qty-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
-                             Common::GetCurrentTimeStr(&m_timeStr),
-                             bbo->ToString().c_str(), agg_qty_ratio);
+                LOG_TRACE(*m_pLogger, "%:% %() % agg-qty-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
+                             *bbo, agg_qty_ratio);
 
                 const auto clip = m_tickerCfg.at(market_update->tickerId).clip_;
                 const auto threshold = m_tickerCfg.at(market_update->tickerId).threshold_;
@@ -50,7 +48,7 @@ namespace Trading
                         m_pOrderManager->moveOrders(market_update->tickerId, bbo->askPrice, Price_INVALID, clip);
                     else
                         m_pOrderManager->moveOrders(market_update->tickerId, Price_INVALID, bbo->bidPrice, clip);
-                    END_MEASURE(Trading_OrderManager_moveOrders, (*m_pLogger));
+                    END_MEASURE(Trading_OrderManager_moveOrders);
                 }
             }
         }
@@ -58,11 +56,10 @@ namespace Trading
         /// Process client responses for the strategy's orders.
         auto onOrderUpdate(const Exchange::SMEClientResponse *client_response) noexcept -> void
         {
-            m_pLogger->Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                         client_response->ToString().c_str());
+            LOG_TRACE(*m_pLogger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *client_response);
             START_MEASURE(Trading_OrderManager_onOrderUpdate);
             m_pOrderManager->onOrderUpdate(client_response);
-            END_MEASURE(Trading_OrderManager_onOrderUpdate, (*m_pLogger));
+            END_MEASURE(Trading_OrderManager_onOrderUpdate);
         }
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -79,7 +76,6 @@ namespace Trading
         /// Used by the liquidity taking algorithm to send aggressive orders.
         COrderManager* m_pOrderManager = nullptr;
 
-        std::string      m_timeStr;
         Common::CLogger* m_pLogger = nullptr;
 
         /// Holds the trading configuration for the liquidity taking algorithm.
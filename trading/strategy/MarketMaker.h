@@ -20,8 +20,8 @@ namespace Trading
         /// Process order book updates, fetch the fair market price from the feature engine, check against the trading threshold and modify the passive orders.
         auto onOrderBookUpdate(TickerId tickerId, Price price, ESide side, const CMarketOrderBook* pBook) noexcept -> void
         {
-            m_pLogger->Log("%:% %() % ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
-                         Common::GetCurrentTimeStr(&m_timeStr), tickerId, Common::PriceToString(price).c_str(),
+            LOG_TRACE(*m_pLogger, "%:% %() ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
+                         tickerId, Common::PriceToString(price).c_str(),
                          Common::SideToString(side).c_str());
 
             const auto bbo = pBook->GetBBO();
@@ -29,9 +29,8 @@ namespace Trading
 
             if (LIKELY(bbo->bidPrice != Price_INVALID && bbo->askPrice != Price_INVALID && fairPrice != Feature_INVALID))
             {
-                m_pLogger->Log("%:% %() % % fair-price:%\n", __FILE__, __LINE__, __FUNCTION__,
-                             Common::GetCurrentTimeStr(&m_timeStr),
-                             bbo->ToString().c_str(), fairPrice);
+                LOG_TRACE(*m_pLogger, "%:% %() % fair-price:%\n", __FILE__, __LINE__, __FUNCTION__,
+                             *bbo, fairPrice);
 
                 const auto clip = m_tickerCfg.at(tickerId).clip_;
                 const auto threshold = m_tickerCfg.at(tickerId).threshold_;
@@ -41,26 +40,24 @@ namespace Trading
 
                 START_MEASURE(Trading_OrderManager_moveOrders);
                 m_pOrderManager->moveOrders(tickerId, bid_price, ask_price, clip);
-                END_MEASURE(Trading_OrderManager_moveOrders, (*m_pLogger));
+                END_MEASURE(Trading_OrderManager_moveOrders);
             }
         }
 
         /// Process trade events, which for the market making algorithm is none.
         auto onTradeUpdate(const Exchange::SMEMarketUpdate* pMarketUpdate, CMarketOrderBook* /* book */) noexcept -> void
         {
-            m_pLogger->Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                         pMarketUpdate->ToString().c_str());
+            LOG_TRACE(*m_pLogger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *pMarketUpdate);
         }
 
         /// Process client responses for the strategy's orders.
         auto onOrderUpdate(const Exchange::SMEClientResponse* pClientResponse) noexcept -> void
         {
-            m_pLogger->Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                         pClientResponse->ToString().c_str());
+            LOG_TRACE(*m_pLogger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *pClientResponse);
 
             START_MEASURE(Trading_OrderManager_onOrderUpdate);
             m_pOrderManager->onOrderUpdate(pClientResponse);
-            END_MEASURE(Trading_OrderManager_onOrderUpdate, (*m_pLogger));
+            END_MEASURE(Trading_OrderManager_onOrderUpdate);
         }
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -77,7 +74,6 @@ namespace Trading
         /// Used by the market making algorithm to manage its passive orders.
         COrderManager* m_pOrderManager = nullptr;
 
-        std::string      m_timeStr;
         Common::CLogger* m_pLogger = nullptr;
 
         /// Holds the trading configuration for the market making algorithm.
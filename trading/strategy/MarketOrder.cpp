@@ -2,19 +2,21 @@
 
 namespace Trading
 {
-    auto SMarketOrder::ToString() const -> std::string
+    auto SMarketOrder::Format(CFormatBuffer &out) const -> void
     {
-        std::stringstream ss;
-        ss << "MarketOrder"
-           << "["
-           << "oid:" << OrderIdToString(orderId) << " "
-           << "side:" << SideToString(side) << " "
-           << "price:" << PriceToString(price) << " "
-           << "qty:" << QtyToString(qty) << " "
-           << "prio:" << PriorityToString(priority) << " "
-           << "prev:" << OrderIdToString(pPrevOrder ? pPrevOrder->orderId : OrderId_INVALID) << " "
-           << "next:" << OrderIdToString(pNextOrder ? pNextOrder->orderId : OrderId_INVALID) << "]";
+        out << "MarketOrder"
+            << "["
+            << "oid:" << FormatOrderId(orderId) << " "
+            << "side:" << FormatSide(side) << " "
+            << "price:" << FormatPrice(price) << " "
+            << "qty:" << FormatQty(qty) << " "
+            << "prio:" << FormatPriority(priority) << " "
+            << "prev:" << FormatOrderId(pPrevOrder ? pPrevOrder->orderId : OrderId_INVALID) << " "
+            << "next:" << FormatOrderId(pNextOrder ? pNextOrder->orderId : OrderId_INVALID) << "]";
+    }
 
-        return ss.str();
+    auto SMarketOrder::ToString() const -> std::string
+    {
+        return FormatToString(*this);
     }
 }
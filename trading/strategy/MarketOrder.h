@@ -1,8 +1,8 @@
 #pragma once
 
 #include <array>
-#include <sstream>
 #include "common/Types.h"
+#include "common/LogRecord.h"
 
 using namespace Common;
 
@@ -27,6 +27,8 @@ namespace Trading
         SMarketOrder(OrderId order_id, ESide side, Price price, Qty qty, Priority priority, SMarketOrder *prev_order, SMarketOrder *next_order) noexcept
             : orderId(order_id), side(side), price(price), qty(qty), priority(priority), pPrevOrder(prev_order), pNextOrder(next_order) {}
 
+        auto Format(CFormatBuffer &out) const -> void;
+
         auto ToString() const -> std::string;
     };
 
@@ -55,17 +57,28 @@ namespace Trading
             , pPrevEntry(pPrevEntry_)
             , pNextEntry(pNextEntry_) {}
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "MarketOrdersAtPrice["
+                << "side:" << FormatSide(side) << " "
+                << "price:" << FormatPrice(price) << " "
+                << "first_mkt_order:";
+            if (pFirstMktOrder)
+            {
+                out << *pFirstMktOrder;
+            }
+            else
+            {
+                out << "null";
+            }
+            out << " "
+                << "prev:" << FormatPrice(pPrevEntry ? pPrevEntry->price : Price_INVALID) << " "
+                << "next:" << FormatPrice(pNextEntry ? pNextEntry->price : Price_INVALID) << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "MarketOrdersAtPrice["
-               << "side:" << SideToString(side) << " "
-               << "price:" << PriceToString(price) << " "
-               << "first_mkt_order:" << (pFirstMktOrder ? pFirstMktOrder->ToString() : "null") << " "
-               << "prev:" << PriceToString(pPrevEntry ? pPrevEntry->price : Price_INVALID) << " "
-               << "next:" << PriceToString(pNextEntry ? pNextEntry->price : Price_INVALID) << "]";
-
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
@@ -80,16 +93,21 @@ namespace Trading
         Qty   bidQty   = Qty_INVALID;
         Qty   askQty   = Qty_INVALID;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "BBO{"
+                << FormatQty(bidQty) << "@" << FormatPrice(bidPrice)
+                << "X"
+                << FormatPrice(askPrice) << "@" << FormatQty(askQty)
+                << "}";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "BBO{"
-               << QtyToString(bidQty) << "@" << PriceToString(bidPrice)
-               << "X"
-               << PriceToString(askPrice) << "@" << QtyToString(askQty)
-               << "}";
-
-            return ss.str();
-        };
+            return FormatToString(*this);
+        }
     };
 }
+
+/// Logged by value, formatted on the logger thread.
+LOG_BY_VALUE(Trading::SBBO);
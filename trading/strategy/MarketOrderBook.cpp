@@ -5,14 +5,15 @@
 namespace Trading
 {
     CMarketOrderBook::CMarketOrderBook(TickerId ticker_id, CLogger *logger)
-        : m_tickerId(ticker_id), m_ordersAtPricePool(ME_MAX_PRICE_LEVELS), m_orderPool(ME_MAX_ORDER_IDS), m_logger(logger)
+        : m_tickerId(ticker_id), m_ordersAtPricePool(ME_MAX_PRICE_LEVELS, "trading:orders_at_price:" + std::to_string(ticker_id)),
+          m_orderPool(ME_MAX_ORDER_IDS, "trading:orders:" + std::to_string(ticker_id)), m_logger(logger)
     {
     }
 
     CMarketOrderBook::~CMarketOrderBook()
     {
-        m_logger->Log("%:% %() % OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__,
-                     Common::GetCurrentTimeStr(&m_timeStr), ToString(false, true));
+        LOG_TRACE(*m_logger, "%:% %() OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__,
+                     ToString(false, true));
 
         m_pTradeEngine = nullptr;
         m_pBidsByPrice = m_pAsksByPrice = nullptr;
@@ -33,7 +34,7 @@ namespace Trading
                                               market_update->qty, market_update->priority, nullptr, nullptr);
             START_MEASURE(Trading_MarketOrderBook_addOrder);
             AddOrder(order);
-            END_MEASURE(Trading_MarketOrderBook_addOrder, (*m_logger));
+            END_MEASURE(Trading_MarketOrderBook_addOrder);
         }
         break;
         case Exchange::EMarketUpdateType::MODIFY:
@@ -47,7 +48,7 @@ namespace Trading
             auto order = m_oidToOrder.at(market_update->orderId);
             START_MEASURE(Trading_MarketOrderBook_removeOrder);
             RemoveOrder(order);
-            END_MEASURE(Trading_MarketOrderBook_removeOrder, (*m_logger));
+            END_MEASURE(Trading_MarketOrderBook_removeOrder);
         }
         break;
         case Exchange::EMarketUpdateType::TRADE:
@@ -90,23 +91,18 @@ namespace Trading
 
         START_MEASURE(Trading_MarketOrderBook_updateBBO);
         UpdateBBO(bid_updated, ask_updated);
-        END_MEASURE(Trading_MarketOrderBook_updateBBO, (*m_logger));
+        END_MEASURE(Trading_MarketOrderBook_updateBBO);
 
-        m_logger->Log("%:% %() % % %", __FILE__, __LINE__, __FUNCTION__,
-                     Common::GetCurrentTimeStr(&m_timeStr), market_update->ToString(), m_pBbo.ToString());
+        LOG_TRACE(*m_logger, "%:% %() % %", __FILE__, __LINE__, __FUNCTION__,
+                     *market_update, m_pBbo);
 
         m_pTradeEngine->onOrderBookUpdate(market_update->tickerId, market_update->price, market_update->side, this);
     }
 
-    auto CMarketOrderBook::ToString(bool detailed, bool validity_check) const -> std::string
+    auto CMarketOrderBook::Format(CFormatBuffer &out, bool detailed, bool validity_check) const -> void
     {
-        std::stringstream ss;
-        std::string time_str;
-
-        auto printer = [&](std::stringstream &ss, SMarketOrdersAtPrice *itr, ESide side, Price &last_price,
-                           bool sanity_check)
+        auto printer = [&](CFormatBuffer &out, SMarketOrdersAtPrice *itr, ESide side, Price &last_price, bool sanity_check)
         {
-            char buf[4096];
             Qty qty = 0;
             size_t num_orders = 0;
 
@@ -117,67 +113,64 @@ namespace Trading
                 if (o_itr->pNextOrder == itr->pFirstMktOrder)
                     break;
             }
-            sprintf(buf, " <px:%3s p:%3s n:%3s> %-3s @ %-5s(%-4s)",
-                    PriceToString(itr->price).c_str(), PriceToString(itr->pPrevEntry->price).c_str(),
-                    PriceToString(itr->pNextEntry->price).c_str(),
-                    PriceToString(itr->price).c_str(), QtyToString(qty).c_str(), std::to_string(num_orders).c_str());
-            ss << buf;
+            out << " <px:" << Padded(FormatPrice(itr->price), 3) << " p:" << Padded(FormatPrice(itr->pPrevEntry->price), 3) << " n:" << Padded(FormatPrice(itr->pNextEntry->price), 3)
+                << "> " << Padded(FormatPrice(itr->price), -3) << " @ " << Padded(FormatQty(qty), -5) << "(" << Padded(num_orders, -4) << ")";
             for (auto o_itr = itr->pFirstMktOrder;; o_itr = o_itr->pNextOrder)
             {
                 if (detailed)
                 {
-                    sprintf(buf, "[oid:%s q:%s p:%s n:%s] ",
-                            OrderIdToString(o_itr->orderId).c_str(), QtyToString(o_itr->qty).c_str(),
-                            OrderIdToString(o_itr->pPrevOrder ? o_itr->pPrevOrder->orderId : OrderId_INVALID).c_str(),
-                            OrderIdToString(o_itr->pNextOrder ? o_itr->pNextOrder->orderId : OrderId_INVALID).c_str());
-                    ss << buf;
+                    out << "[oid:" << FormatOrderId(o_itr->orderId) << " q:" << FormatQty(o_itr->qty)
+                        << " p:" << FormatOrderId(o_itr->pPrevOrder ? o_itr->pPrevOrder->orderId : OrderId_INVALID)
+                        << " n:" << FormatOrderId(o_itr->pNextOrder ? o_itr->pNextOrder->orderId : OrderId_INVALID) << "] ";
                 }
                 if (o_itr->pNextOrder == itr->pFirstMktOrder)
                     break;
             }
 
-            ss << std::endl;
+            out << '\n';
 
             if (sanity_check)
             {
                 if ((side == ESide::SELL && last_price >= itr->price) || (side == ESide::BUY && last_price <= itr->price))
                 {
-                    FATAL("Bids/Asks not sorted by ascending/descending prices last:" + PriceToString(last_price) + " itr:" +
-                          itr->ToString());
+                    FATAL("Bids/Asks not sorted by ascending/descending prices last:" + PriceToString(last_price) + " itr:" + itr->ToString());
                 }
                 last_price = itr->price;
             }
         };
 
-        ss << "Ticker:" << TickerIdToString(m_tickerId) << std::endl;
+        out << "Ticker:" << FormatTickerId(m_tickerId) << '\n';
         {
             auto ask_itr = m_pAsksByPrice;
             auto last_ask_price = std::numeric_limits<Price>::min();
             for (size_t count = 0; ask_itr; ++count)
             {
-                ss << "ASKS L:" << count << " => ";
+                out << "ASKS L:" << count << " => ";
                 auto next_ask_itr = (ask_itr->pNextEntry == m_pAsksByPrice ? nullptr : ask_itr->pNextEntry);
-                printer(ss, ask_itr, ESide::SELL, last_ask_price, validity_check);
+                printer(out, ask_itr, ESide::SELL, last_ask_price, validity_check);
                 ask_itr = next_ask_itr;
             }
         }
 
-        ss << std::endl
-           << "                          X" << std::endl
-           << std::endl;
+        out << '\n'
+            << "                          X" << '\n'
+            << '\n';
 
         {
             auto bid_itr = m_pBidsByPrice;
             auto last_bid_price = std::numeric_limits<Price>::max();
             for (size_t count = 0; bid_itr; ++count)
             {
-                ss << "BIDS L:" << count << " => ";
+                out << "BIDS L:" << count << " => ";
                 auto next_bid_itr = (bid_itr->pNextEntry == m_pBidsByPrice ? nullptr : bid_itr->pNextEntry);
-                printer(ss, bid_itr, ESide::BUY, last_bid_price, validity_check);
+                printer(out, bid_itr, ESide::BUY, last_bid_price, validity_check);
                 bid_itr = next_bid_itr;
             }
         }
+    }
 
-        return ss.str();
+    auto CMarketOrderBook::ToString(bool detailed, bool validity_check) const -> std::string
+    {
+        return FormatToString([&](CFormatBuffer &out) { Format(out, detailed, validity_check); });
     }
 }
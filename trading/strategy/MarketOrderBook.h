@@ -2,6 +2,7 @@
 
 #include "common/Types.h"
 #include "common/MemoryPool.h"
+#include "common/SegmentedMemoryPool.h"
 #include "common/Logging.h"
 
 #include "MarketOrder.h"
@@ -66,6 +67,9 @@ namespace Trading
             return &m_pBbo;
         }
 
+        /// Dump the book into a caller provided buffer, without allocating. Output that does not fit is dropped, see CFormatBuffer::IsTruncated().
+        auto Format(CFormatBuffer &out, bool detailed, bool validity_check) const -> void;
+
         auto ToString(bool detailed, bool validity_check) const -> std::string;
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -94,13 +98,12 @@ namespace Trading
         /// Hash map from Price -> MarketOrdersAtPrice.
         OrdersAtPriceHashMap m_priceOrdersAtPrice;
 
-        /// Memory pool to manage MarketOrder objects.
-        CMemoryPool<SMarketOrder> m_orderPool;
+        /// Memory pool to manage MarketOrder objects, address space for ME_MAX_ORDER_IDS is reserved but memory is only committed as the book grows.
+        CSegmentedMemoryPool<SMarketOrder> m_orderPool;
 
         SBBO m_pBbo;
 
-        std::string m_timeStr;
-        CLogger*    m_logger = nullptr;
+        CLogger* m_logger = nullptr;
 
     private:
         auto PriceToIndex(Price price) const noexcept
@@ -26,11 +26,9 @@ namespace Trading
         /// Process an order update from a client response and update the state of the orders being managed.
         auto onOrderUpdate(const Exchange::SMEClientResponse* pClientResponse) noexcept -> void
         {
-            m_logger->Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                         pClientResponse->ToString().c_str());
+            LOG_TRACE(*m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *pClientResponse);
             auto pOrder = &(m_tickerSideOrder.at(pClientResponse->tickerId).at(SideToIndex(pClientResponse->side)));
-            m_logger->Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                         pOrder->ToString().c_str());
+            LOG_TRACE(*m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *pOrder);
 
             switch (pClientResponse->type)
             {
@@ -77,7 +75,7 @@ namespace Trading
                 {
                     START_MEASURE(Trading_OrderManager_cancelOrder);
                     cancelOrder(pOrder);
-                    END_MEASURE(Trading_OrderManager_cancelOrder, (*m_logger));
+                    END_MEASURE(Trading_OrderManager_cancelOrder);
                 }
             }
             break;
@@ -88,16 +86,15 @@ namespace Trading
                 {
                     START_MEASURE(Trading_RiskManager_checkPreTradeRisk);
                     const auto risk_result = m_pRiskManager.checkPreTradeRisk(ticker_id, side, qty);
-                    END_MEASURE(Trading_RiskManager_checkPreTradeRisk, (*m_logger));
+                    END_MEASURE(Trading_RiskManager_checkPreTradeRisk);
                     if (LIKELY(risk_result == ERiskCheckResult::ALLOWED))
                     {
                         START_MEASURE(Trading_OrderManager_newOrder);
                         newOrder(pOrder, ticker_id, price, side, qty);
-                        END_MEASURE(Trading_OrderManager_newOrder, (*m_logger));
+                        END_MEASURE(Trading_OrderManager_newOrder);
                     }
                     else
-                        m_logger->Log("%:% %() % Ticker:% Side:% Qty:% ERiskCheckResult:%\n", __FILE__, __LINE__, __FUNCTION__,
-                                     Common::GetCurrentTimeStr(&m_timeStr),
+                        LOG_DEBUG(*m_logger, "%:% %() Ticker:% Side:% Qty:% ERiskCheckResult:%\n", __FILE__, __LINE__, __FUNCTION__,
                                      TickerIdToString(ticker_id), SideToString(side), QtyToString(qty),
                                      riskCheckResultToString(risk_result));
                 }
@@ -119,14 +116,14 @@ namespace Trading
                 auto bid_order = &(m_tickerSideOrder.at(ticker_id).at(SideToIndex(ESide::BUY)));
                 START_MEASURE(Trading_OrderManager_moveOrder);
                 moveOrder(bid_order, ticker_id, bid_price, ESide::BUY, clip);
-                END_MEASURE(Trading_OrderManager_moveOrder, (*m_logger));
+                END_MEASURE(Trading_OrderManager_moveOrder);
             }
 
             {
                 auto ask_order = &(m_tickerSideOrder.at(ticker_id).at(SideToIndex(ESide::SELL)));
                 START_MEASURE(Trading_OrderManager_moveOrder);
                 moveOrder(ask_order, ticker_id, ask_price, ESide::SELL, clip);
-                END_MEASURE(Trading_OrderManager_moveOrder, (*m_logger));
+                END_MEASURE(Trading_OrderManager_moveOrder);
             }
         }
 
@@ -150,7 +147,6 @@ namespace Trading
         /// Risk manager to perform pre-trade risk checks.
         const CRiskManager& m_pRiskManager;
 
-        std::string      m_timeStr;
         Common::CLogger* m_logger = nullptr;
 
         /// Hash map container from TickerId -> Side -> SOMOrder.
@@ -1,8 +1,8 @@
 #pragma once
 
 #include <array>
-#include <sstream>
 #include "common/Types.h"
+#include "common/LogRecord.h"
 
 using namespace Common;
 
@@ -18,7 +18,7 @@ namespace Trading
         DEAD = 4
     };
 
-    inline auto OMOrderStateToString(EOMOrderState side) -> std::string
+    inline constexpr auto FormatOMOrderState(EOMOrderState side) noexcept -> std::string_view
     {
         switch (side)
         {
@@ -37,6 +37,11 @@ namespace Trading
         return "UNKNOWN";
     }
 
+    inline auto OMOrderStateToString(EOMOrderState side) -> std::string
+    {
+        return std::string(FormatOMOrderState(side));
+    }
+
     /// Internal structure used by the order manager to represent a single strategy order.
     struct SOMOrder
     {
@@ -47,19 +52,21 @@ namespace Trading
         Qty qty = Qty_INVALID;
         EOMOrderState orderState = EOMOrderState::INVALID;
 
-        auto ToString() const
+        auto Format(CFormatBuffer &out) const -> void
         {
-            std::stringstream ss;
-            ss << "SOMOrder"
-               << "["
-               << "tid:" << TickerIdToString(tickerId) << " "
-               << "oid:" << OrderIdToString(orderId) << " "
-               << "side:" << SideToString(side) << " "
-               << "price:" << PriceToString(price) << " "
-               << "qty:" << QtyToString(qty) << " "
-               << "state:" << OMOrderStateToString(orderState) << "]";
+            out << "SOMOrder"
+                << "["
+                << "tid:" << FormatTickerId(tickerId) << " "
+                << "oid:" << FormatOrderId(orderId) << " "
+                << "side:" << FormatSide(side) << " "
+                << "price:" << FormatPrice(price) << " "
+                << "qty:" << FormatQty(qty) << " "
+                << "state:" << FormatOMOrderState(orderState) << "]";
+        }
 
-            return ss.str();
+        auto ToString() const
+        {
+            return FormatToString(*this);
         }
     };
 
@@ -69,3 +76,6 @@ namespace Trading
     /// Hash map from TickerId -> Side -> SOMOrder.
     typedef std::array<OMOrderSideHashMap, ME_MAX_TICKERS> OMOrderTickerSideHashMap;
 }
+
+/// Logged by value, formatted on the logger thread.
+LOG_BY_VALUE(Trading::SOMOrder);
@@ -10,6 +10,18 @@
 
 using namespace Common;
 
+namespace Trading
+{
+    struct SPositionInfo;
+}
+
+/// Logged by value, formatted on the logger thread. Declared ahead of SPositionInfo, whose own members log it.
+template <>
+struct Common::SLogFormatter<Trading::SPositionInfo>
+{
+    static auto Format(std::ostream &out, const Trading::SPositionInfo &value) -> void;
+};
+
 namespace Trading
 {
     /// SPositionInfo tracks the position, pnl (realized and unrealized) and volume for a single trading instrument.
@@ -25,21 +37,27 @@ namespace Trading
         Qty         volume = 0;
         const SBBO* pBbo = nullptr;
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "Position{"
+                << "pos:" << position
+                << " u-pnl:" << unrealPnL
+                << " r-pnl:" << realPnL
+                << " t-pnl:" << totalPnL
+                << " vol:" << FormatQty(volume)
+                << " vwaps:[" << (position ? openVWAP.at(SideToIndex(ESide::BUY)) / std::abs(position) : 0)
+                << "X" << (position ? openVWAP.at(SideToIndex(ESide::SELL)) / std::abs(position) : 0)
+                << "] ";
+            if (pBbo)
+            {
+                out << *pBbo;
+            }
+            out << "}";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "Position{"
-               << "pos:" << position
-               << " u-pnl:" << unrealPnL
-               << " r-pnl:" << realPnL
-               << " t-pnl:" << totalPnL
-               << " vol:" << QtyToString(volume)
-               << " vwaps:[" << (position ? openVWAP.at(SideToIndex(ESide::BUY)) / std::abs(position) : 0)
-               << "X" << (position ? openVWAP.at(SideToIndex(ESide::SELL)) / std::abs(position) : 0)
-               << "] "
-               << (pBbo ? pBbo->ToString() : "") << "}";
-
-            return ss.str();
+            return FormatToString(*this);
         }
 
         /// Process an execution and update the position, pnl and volume.
@@ -88,15 +106,12 @@ namespace Trading
 
             totalPnL = unrealPnL + realPnL;
 
-            std::string time_str;
-            pLogger->Log("%:% %() % % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&time_str),
-                         ToString(), pClientResponse->ToString().c_str());
+            LOG_TRACE(*pLogger, "%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, *this, *pClientResponse);
         }
 
         /// Process a change in top-of-book prices (BBO), and update unrealized pnl if there is an open position.
         auto UpdateBBO(const SBBO *pBbo, CLogger *pLogger) noexcept
         {
-            std::string time_str;
             pBbo = pBbo;
 
             if (position && pBbo->bidPrice != Price_INVALID && pBbo->askPrice != Price_INVALID)
@@ -115,8 +130,7 @@ namespace Trading
                 totalPnL = unrealPnL + realPnL;
 
                 if (totalPnL != old_total_pnl)
-                    pLogger->Log("%:% %() % % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&time_str),
-                                 ToString(), pBbo->ToString());
+                    LOG_TRACE(*pLogger, "%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, *this, *pBbo);
             }
         }
     };
@@ -138,7 +152,6 @@ namespace Trading
         EPositionKeeper& operator=(const EPositionKeeper&&) = delete;
 
     private:
-        std::string      m_timeStr;
         Common::CLogger* m_pLogger = nullptr;
 
         /// Hash map container from TickerId -> SPositionInfo.
@@ -160,22 +173,36 @@ namespace Trading
             return &(m_tickerPosition.at(tickerId));
         }
 
-        auto ToString() const
+        auto Format(CFormatBuffer &out) const -> void
         {
             double totalPnl = 0;
             Qty totalVol = 0;
 
-            std::stringstream ss;
             for (TickerId i = 0; i < m_tickerPosition.size(); ++i)
             {
-                ss << "TickerId:" << TickerIdToString(i) << " " << m_tickerPosition.at(i).ToString() << "\n";
+                out << "TickerId:" << FormatTickerId(i) << " " << m_tickerPosition.at(i) << "\n";
 
                 totalPnl += m_tickerPosition.at(i).totalPnL;
                 totalVol += m_tickerPosition.at(i).volume;
             }
-            ss << "Total PnL:" << totalPnl << " Vol:" << totalVol << "\n";
+            out << "Total PnL:" << totalPnl << " Vol:" << totalVol << "\n";
+        }
 
-            return ss.str();
+        auto ToString() const
+        {
+            return FormatToString(*this);
         }
     };
 }
+
+/// The copy's BBO pointer is not followed on the logger thread, the book may be updating it meanwhile, so the BBO is left out:
+/// the call sites log it by value next to the position when it matters.
+inline auto Common::SLogFormatter<Trading::SPositionInfo>::Format(std::ostream &out, const Trading::SPositionInfo &value) -> void
+{
+    auto position = value;
+    position.pBbo = nullptr;
+
+    Common::CInlineFormatBuffer<Common::FORMAT_INLINE_SIZE> text;
+    position.Format(text);
+    out.write(text.View().data(), text.size());
+}
@@ -12,5 +12,10 @@ namespace Trading
             m_tickerRisk.at(i).pPositionInfo = pPositionKeeper->getPositionInfo(i);
             m_tickerRisk.at(i).riskCfg = tickerCfg[i].riskCfg;
         }
+
+        for (auto result = ERiskCheckResult::INVALID; result <= ERiskCheckResult::ALLOWED; result = static_cast<ERiskCheckResult>(static_cast<int8_t>(result) + 1))
+        {
+            m_resultCounters.push_back(CMetricsRegistry::Instance().Counter("trading:risk_manager:" + std::string(riskCheckResultToString(result))));
+        }
     }
 }
@@ -2,6 +2,7 @@
 
 #include "common/Macros.h"
 #include "common/Logging.h"
+#include "common/Metrics.h"
 
 #include "PositionKeeper.h"
 #include "OrderManagerOrder.h"
@@ -63,16 +64,18 @@ namespace Trading
             return ERiskCheckResult::ALLOWED;
         }
 
+        auto Format(CFormatBuffer &out) const -> void
+        {
+            out << "SRiskInfo"
+                << "["
+                << "pos:" << *pPositionInfo << " "
+                << riskCfg
+                << "]";
+        }
+
         auto ToString() const
         {
-            std::stringstream ss;
-            ss << "SRiskInfo"
-               << "["
-               << "pos:" << pPositionInfo->ToString() << " "
-               << riskCfg.ToString()
-               << "]";
-
-            return ss.str();
+            return FormatToString(*this);
         }
     };
 
@@ -85,9 +88,13 @@ namespace Trading
     public:
         CRiskManager(Common::CLogger* pLogger, const EPositionKeeper* pPositionKeeper, const TradeEngineCfgHashMap& tickerCfg);
 
+        /// Every result is counted by reason, so rejects show up live in stats_reader.
         auto checkPreTradeRisk(TickerId tickerId, ESide side, Qty qty) const noexcept
         {
-            return m_tickerRisk.at(tickerId).checkPreTradeRisk(side, qty);
+            const auto result = m_tickerRisk.at(tickerId).checkPreTradeRisk(side, qty);
+            m_resultCounters[static_cast<size_t>(result)].Increment();
+
+            return result;
         }
 
         /// Deleted default, copy & move constructors and assignment-operators.
@@ -98,10 +105,12 @@ namespace Trading
         CRiskManager &operator=(const CRiskManager &&) = delete;
 
     private:
-        std::string      m_timeStr;
         Common::CLogger* m_pLogger = nullptr;
 
         /// Hash map container from TickerId -> SRiskInfo.
         TickerRiskInfoHashMap m_tickerRisk;
+
+        /// ERiskCheckResult -> number of checks with that result, published through CMetricsRegistry.
+        std::vector<Common::CMetricCounter> m_resultCounters;
     };
 }
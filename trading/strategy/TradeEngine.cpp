@@ -17,7 +17,13 @@ namespace Trading
         , m_positionKeeper(&m_logger)
         , m_orderManager(&m_logger, this, m_pRiskManager)
         , m_pRiskManager(&m_logger, &m_positionKeeper, tickerCfg)
+        , m_responsesCounter(CMetricsRegistry::Instance().Counter("trading:trade_engine:responses"))
+        , m_marketUpdatesCounter(CMetricsRegistry::Instance().Counter("trading:trade_engine:market_updates"))
+        , m_requestsCounter(CMetricsRegistry::Instance().Counter("trading:trade_engine:requests"))
     {
+        pIncomingOgwResponses->SetConsumerWaitStrategy(&m_waitStrategy);
+        pIncomingMdUpdates->SetConsumerWaitStrategy(&m_waitStrategy);
+
         for (size_t i = 0; i < m_tickerOrderBook.size(); ++i)
         {
             m_tickerOrderBook[i] = new CMarketOrderBook(i, &m_logger);
@@ -53,8 +59,7 @@ namespace Trading
 
         for (TickerId i = 0; i < tickerCfg.size(); ++i)
         {
-            m_logger.Log("%:% %() % Initialized % Ticker:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::GetCurrentTimeStr(&m_timeStr),
+            LOG_INFO(m_logger, "%:% %() Initialized % Ticker:% %.\n", __FILE__, __LINE__, __FUNCTION__,
                         AlgoTypeToString(algoType), i,
                         tickerCfg.at(i).ToString());
         }
@@ -84,102 +89,121 @@ namespace Trading
     }
 
     /// Write a client request to the lock free queue for the order server to consume and send to the exchange.
-    auto CTradeEngine::sendClientRequest(const Exchange::SMEClientRequest *client_request) noexcept -> void
+    auto CTradeEngine::sendClientRequest(const Exchange::SMEClientRequest *client_request, const Common::STraceContext &cause) noexcept -> void
     {
-        m_logger.Log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                    client_request->ToString().c_str());
+        LOG_TRACE(m_logger, "%:% %() Sending %\n", __FILE__, __LINE__, __FUNCTION__, *client_request);
         auto next_write = pOutgoingOgwRequests->GetNextToWriteTo();
-        *next_write = std::move(*client_request);
+        *next_write = {*client_request, cause};
+        next_write->trace.Fork(MakeOrderTraceId(client_request->clientId, client_request->orderId), ETraceHop::T10_TradeEngine_LFQueue_write, Common::rdtsc());
         pOutgoingOgwRequests->UpdateWriteIndex();
-        TTT_MEASURE(T10_TradeEngine_LFQueue_write, m_logger);
+        m_requestsCounter.Increment();
     }
 
     /// Main loop for this thread - processes incoming client responses and market data updates which in turn may generate client requests.
     auto CTradeEngine::Run() noexcept -> void
     {
-        m_logger.Log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr));
+        LOG_INFO(m_logger, "%:% %()\n", __FILE__, __LINE__, __FUNCTION__);
+
+        Common::PreregisterMeasures({"Trading_MarketOrderBook_addOrder", "Trading_MarketOrderBook_removeOrder", "Trading_MarketOrderBook_updateBBO",
+                                     "Trading_PositionKeeper_updateBBO", "Trading_PositionKeeper_addFill",
+                                     "Trading_FeatureEngine_onOrderBookUpdate", "Trading_FeatureEngine_onTradeUpdate",
+                                     "Trading_TradeEngine_algoOnOrderBookUpdate_", "Trading_TradeEngine_algoOnTradeUpdate_", "Trading_TradeEngine_algoOnOrderUpdate_",
+                                     "Trading_OrderManager_moveOrders", "Trading_OrderManager_onOrderUpdate", "Trading_OrderManager_moveOrder",
+                                     "Trading_OrderManager_newOrder", "Trading_OrderManager_cancelOrder", "Trading_RiskManager_checkPreTradeRisk"});
+        Common::PreregisterTraceHops(Common::ETraceHop::T8t_OrderGateway_LFQueue_write, Common::ETraceHop::T9t_TradeEngine_LFQueue_read);
+
         while (m_isRunning)
         {
+            bool did_work = false;
             for (auto client_response = pIncomingOgwResponses->GetNextToRead(); client_response; client_response = pIncomingOgwResponses->GetNextToRead())
             {
-                TTT_MEASURE(T9t_TradeEngine_LFQueue_read, m_logger);
+                m_trace = client_response->trace;
+                TRACE_END(m_trace, T9t_TradeEngine_LFQueue_read, m_logger);
 
-                m_logger.Log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                            client_response->ToString().c_str());
+                LOG_TRACE(m_logger, "%:% %() Processing %\n", __FILE__, __LINE__, __FUNCTION__, *client_response);
+                FLIGHT_RECORD(RESPONSE_READ, MakeOrderTraceId(client_response->clientId, client_response->clientOrderId), client_response->tickerId,
+                              client_response->side, client_response->price, client_response->execQty, client_response->type);
                 onOrderUpdate(client_response);
                 pIncomingOgwResponses->UpdateReadIndex();
+                m_responsesCounter.Increment();
                 m_lastEventTime = Common::GetCurrentNanos();
+                did_work = true;
             }
 
             for (auto market_update = pIncomingMdUpdates->GetNextToRead(); market_update; market_update = pIncomingMdUpdates->GetNextToRead())
             {
-                TTT_MEASURE(T9_TradeEngine_LFQueue_read, m_logger);
+                m_trace = market_update->trace;
+                TRACE_HOP(m_trace, T9_TradeEngine_LFQueue_read);
 
-                m_logger.Log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                            market_update->ToString().c_str());
+                LOG_TRACE(m_logger, "%:% %() Processing %\n", __FILE__, __LINE__, __FUNCTION__, *market_update);
 
                 ASSERT(market_update->tickerId < m_tickerOrderBook.size(),
                        "Unknown ticker-id on update:" + market_update->ToString());
 
+                FLIGHT_RECORD(MARKET_UPDATE_READ, market_update->orderId, market_update->tickerId, market_update->side, market_update->price, market_update->qty,
+                              market_update->type);
                 m_tickerOrderBook[market_update->tickerId]->OnMarketUpdate(market_update);
                 pIncomingMdUpdates->UpdateReadIndex();
+                m_marketUpdatesCounter.Increment();
                 m_lastEventTime = Common::GetCurrentNanos();
+                did_work = true;
             }
+
+            ALLOCATION_FREE_AFTER_WARMUP("trading:trade_engine", did_work);
+            m_waitStrategy.OnPoll(did_work);
         }
     }
 
     /// Process changes to the order book - updates the position keeper, feature engine and informs the trading algorithm about the update.
     auto CTradeEngine::onOrderBookUpdate(TickerId ticker_id, Price price, ESide side, CMarketOrderBook *book) noexcept -> void
     {
-        m_logger.Log("%:% %() % ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::GetCurrentTimeStr(&m_timeStr), ticker_id, Common::PriceToString(price).c_str(),
+        LOG_TRACE(m_logger, "%:% %() ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
+                    ticker_id, Common::PriceToString(price).c_str(),
                     Common::SideToString(side).c_str());
 
         auto bbo = book->GetBBO();
 
         START_MEASURE(Trading_PositionKeeper_updateBBO);
         m_positionKeeper.UpdateBBO(ticker_id, bbo);
-        END_MEASURE(Trading_PositionKeeper_updateBBO, m_logger);
+        END_MEASURE(Trading_PositionKeeper_updateBBO);
 
         START_MEASURE(Trading_FeatureEngine_onOrderBookUpdate);
         m_featureEngine.onOrderBookUpdate(ticker_id, price, side, book);
-        END_MEASURE(Trading_FeatureEngine_onOrderBookUpdate, m_logger);
+        END_MEASURE(Trading_FeatureEngine_onOrderBookUpdate);
 
         START_MEASURE(Trading_TradeEngine_algoOnOrderBookUpdate_);
         m_algoOnOrderBookUpdate(ticker_id, price, side, book);
-        END_MEASURE(Trading_TradeEngine_algoOnOrderBookUpdate_, m_logger);
+        END_MEASURE(Trading_TradeEngine_algoOnOrderBookUpdate_);
     }
 
     /// Process trade events - updates the  feature engine and informs the trading algorithm about the trade event.
     auto CTradeEngine::onTradeUpdate(const Exchange::SMEMarketUpdate *market_update, CMarketOrderBook *book) noexcept -> void
     {
-        m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                    market_update->ToString().c_str());
+        LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *market_update);
 
         START_MEASURE(Trading_FeatureEngine_onTradeUpdate);
         m_featureEngine.onTradeUpdate(market_update, book);
-        END_MEASURE(Trading_FeatureEngine_onTradeUpdate, m_logger);
+        END_MEASURE(Trading_FeatureEngine_onTradeUpdate);
 
         START_MEASURE(Trading_TradeEngine_algoOnTradeUpdate_);
         m_algoOnTradeUpdate(market_update, book);
-        END_MEASURE(Trading_TradeEngine_algoOnTradeUpdate_, m_logger);
+        END_MEASURE(Trading_TradeEngine_algoOnTradeUpdate_);
     }
 
     /// Process client responses - updates the position keeper and informs the trading algorithm about the response.
     auto CTradeEngine::onOrderUpdate(const Exchange::SMEClientResponse *client_response) noexcept -> void
     {
-        m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                    client_response->ToString().c_str());
+        LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *client_response);
 
         if (UNLIKELY(client_response->type == Exchange::EClientResponseType::FILLED))
         {
             START_MEASURE(Trading_PositionKeeper_addFill);
             m_positionKeeper.addFill(client_response);
-            END_MEASURE(Trading_PositionKeeper_addFill, m_logger);
+            END_MEASURE(Trading_PositionKeeper_addFill);
         }
 
         START_MEASURE(Trading_TradeEngine_algoOnOrderUpdate_);
         m_algoOnOrderUpdate(client_response);
-        END_MEASURE(Trading_TradeEngine_algoOnOrderUpdate_, m_logger);
+        END_MEASURE(Trading_TradeEngine_algoOnOrderUpdate_);
     }
 }
@@ -2,11 +2,13 @@
 
 #include <functional>
 
+#include "common/AllocationTracker.h"
 #include "common/ThreadUtils.h"
 #include "common/TimeUtils.h"
-#include "common/LockFreeQueue.h"
+#include "common/OptLockFreeQueue.h"
 #include "common/Macros.h"
 #include "common/Logging.h"
+#include "common/Metrics.h"
 
 #include "exchange/order_server/ClientRequest.h"
 #include "exchange/order_server/ClientResponse.h"
@@ -49,24 +51,30 @@ namespace Trading
         {
             while (pIncomingOgwResponses->size() || pIncomingMdUpdates->size())
             {
-                m_logger.Log("%:% %() % Sleeping till all updates are consumed ogw-size:% md-size:%\n", __FILE__, __LINE__, __FUNCTION__,
-                            Common::GetCurrentTimeStr(&m_timeStr), pIncomingOgwResponses->size(), pIncomingMdUpdates->size());
+                LOG_INFO(m_logger, "%:% %() Sleeping till all updates are consumed ogw-size:% md-size:%\n", __FILE__, __LINE__, __FUNCTION__,
+                            pIncomingOgwResponses->size(), pIncomingMdUpdates->size());
 
                 using namespace std::literals::chrono_literals;
                 std::this_thread::sleep_for(10ms);
             }
 
-            m_logger.Log("%:% %() % POSITIONS\n%\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                        m_positionKeeper.ToString());
+            LOG_INFO(m_logger, "%:% %() POSITIONS\n%\n", __FILE__, __LINE__, __FUNCTION__, m_positionKeeper.ToString());
 
             m_isRunning = false;
         }
 
+        /// Idle behaviour of the run loop, only call before Start().
+        auto SetWaitStrategy(Common::EWaitStrategy strategy) noexcept
+        {
+            m_waitStrategy.SetStrategy(strategy);
+        }
+
         /// Main loop for this thread - processes incoming client responses and market data updates which in turn may generate client requests.
         auto Run() noexcept -> void;
 
         /// Write a client request to the lock free queue for the order server to consume and send to the exchange.
-        auto sendClientRequest(const Exchange::SMEClientRequest* pClientRequest) noexcept -> void;
+        /// The request's trace forks from cause, the trace of what made the caller send it. An invalid cause starts a fresh trace.
+        auto sendClientRequest(const Exchange::SMEClientRequest* pClientRequest, const Common::STraceContext &cause) noexcept -> void;
 
         /// Process changes to the order book - updates the position keeper, feature engine and informs the trading algorithm about the update.
         auto onOrderBookUpdate(TickerId tickerId, Price price, ESide side, CMarketOrderBook* pBook) noexcept -> void;
@@ -97,6 +105,12 @@ namespace Trading
             return m_clientId;
         }
 
+        /// Trace of the message the run loop is processing, the cause of the requests the algorithm sends. Only for the trade engine thread.
+        auto GetTrace() const noexcept -> const Common::STraceContext &
+        {
+            return m_trace;
+        }
+
         /// Deleted default, copy & move constructors and assignment-operators.
         CTradeEngine() = delete;
         CTradeEngine(const CTradeEngine &) = delete;
@@ -119,11 +133,17 @@ namespace Trading
         Exchange::ClientResponseLFQueue* pIncomingOgwResponses = nullptr;
         Exchange::MEMarketUpdateLFQueue* pIncomingMdUpdates    = nullptr;
 
+        /// Trace of the client response or market update being processed, carried on by the client requests the algorithm sends in reaction.
+        /// Only market updates that lead to an order are traced to the end, from T7 to T12.
+        Common::STraceContext m_trace;
+
         Nanos m_lastEventTime = 0;
         volatile bool m_isRunning = false;
 
-        std::string m_timeStr;
-        CLogger     m_logger;
+        /// What the run loop does after a pass that found nothing to process.
+        Common::CWaitStrategy m_waitStrategy;
+
+        CLogger m_logger;
 
         /// Feature engine for the trading algorithms.
         CFeatureEngine m_featureEngine;
@@ -141,24 +161,27 @@ namespace Trading
         CMarketMaker*    m_pMmAlgo = nullptr;
         CLiquidityTaker* m_pTakerAlgo = nullptr;
 
+        /// Live message counts, published through CMetricsRegistry.
+        Common::CMetricCounter m_responsesCounter;
+        Common::CMetricCounter m_marketUpdatesCounter;
+        Common::CMetricCounter m_requestsCounter;
+
         /// Default methods to initialize the function wrappers.
         auto defaultAlgoOnOrderBookUpdate(TickerId tickerId, Price price, ESide side, CMarketOrderBook* ) noexcept -> void
         {
-            m_logger.Log("%:% %() % ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::GetCurrentTimeStr(&m_timeStr), tickerId, Common::PriceToString(price).c_str(),
+            LOG_TRACE(m_logger, "%:% %() ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
+                        tickerId, Common::PriceToString(price).c_str(),
                         Common::SideToString(side).c_str());
         }
 
         auto defaultAlgoOnTradeUpdate(const Exchange::SMEMarketUpdate* pMarketUpdate, CMarketOrderBook *) noexcept -> void
         {
-            m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                        pMarketUpdate->ToString().c_str());
+            LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *pMarketUpdate);
         }
 
         auto defaultAlgoOnOrderUpdate(const Exchange::SMEClientResponse* pClientResponse) noexcept -> void
         {
-            m_logger.Log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::GetCurrentTimeStr(&m_timeStr),
-                        pClientResponse->ToString().c_str());
+            LOG_TRACE(m_logger, "%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, *pClientResponse);
         }
     };
 }